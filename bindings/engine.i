@@ -62,12 +62,16 @@
 
 using SplitsVec = std::vector<Split*>;
 using AccountVec = std::vector<Account*>;
+using TimeVec = std::vector<time64>;
+using NumericVec = std::vector<gnc_numeric>;
 
 SplitsVec gnc_get_match_commodity_splits (AccountVec accounts, bool use_end_date,
                                           time64 end_date, gnc_commodity *comm, bool sort);
 
 AccountVec gnc_accounts_and_all_descendants (AccountVec accounts);
 
+NumericVec xaccAccountGetBalancesAsOfDates (Account *acc, TimeVec dates);
+
 extern "C"
 {
 SCM scm_init_sw_engine_module (void);
@@ -88,6 +92,20 @@ GLIST_HELPER_INOUT(CommodityList, SWIGTYPE_p_gnc_commodity);
 VECTOR_HELPER_INOUT(SplitsVec, SWIGTYPE_p_Split, Split);
 VECTOR_HELPER_INOUT(AccountVec, SWIGTYPE_p_Account, Account);
 
+#if defined(SWIGGUILE)
+%typemap(in) TimeVec {
+  for (auto node = $input; !scm_is_null (node); node = scm_cdr (node))
+      $1.push_back (scm_to_int64 (scm_car (node)));
+}
+
+%typemap(out) NumericVec {
+  SCM list = SCM_EOL;
+  std::for_each ($1.rbegin(), $1.rend(), [&list](auto n)
+                 { list = scm_cons (gnc_numeric_to_scm (n), list); });
+  $result = list;
+}
+#endif
+
 %typemap(newfree) char * "g_free($1);"
 
 /* These need to be here so that they are *before* the function
@@ -175,6 +193,14 @@ gnc_accounts_and_all_descendants (AccountVec accounts)
     return AccountVec (accset.begin(), accset.end());
 }
 
+/* The balance of an account as of each of a list of dates, found by
+ * binary search of the running balances instead of one call per date. */
+NumericVec
+xaccAccountGetBalancesAsOfDates (Account *acc, TimeVec dates)
+{
+    return gnc_account_get_balances_as_of_dates (acc, dates);
+}
+
 %}
 
 /* NB: The object ownership annotations should already cover all the
@@ -304,6 +330,7 @@ SplitList * qof_query_run_subquery (QofQuery *q, const QofQuery *q);
 
 time64 time64CanonicalDayTime(time64 t);
 
+%ignore gnc_budget_get_period_dates;
 %include <gnc-budget.h>
 %typemap (freearg) GList * "g_list_free_full ($1, g_free);"
 
@@ -21,6 +21,8 @@
 %module sw_expressions
 %{
 #include <gnc-sx-instance-model.h>
+#include <gnc-ui-util.h>
+#include <SX-book.h>
 
 SCM scm_init_sw_expressions_module (void);
 
@@ -49,6 +51,47 @@ gnc_numeric_to_scm(gnc_numeric arg)
     return gnc_numeric_check (arg) ? SCM_BOOL_F :
            scm_divide (scm_from_int64 (arg.num), scm_from_int64 (arg.denom));
 }
+
+/* Projects the cash flow of all SXs of the current book over a list of
+ * (start end) intervals of time64s, returning a hash table from account
+ * GUID strings to a list of amounts, one for each interval. */
+static SCM
+gnc_sx_all_instantiate_cashflow_series (SCM intervals)
+{
+    guint n_ranges = scm_to_uint (scm_length (intervals));
+    GDate *starts = g_new (GDate, n_ranges);
+    GDate *ends = g_new (GDate, n_ranges);
+    GList *all_sxes = gnc_book_get_schedxactions (gnc_get_current_book ())->sx_list;
+    SCM table = scm_c_make_hash_table (17);
+    GList *series, *node;
+    guint i;
+
+    for (i = 0; !scm_is_null (intervals); intervals = scm_cdr (intervals), i++)
+    {
+        SCM interval = scm_car (intervals);
+        starts[i] = gnc_time64_to_GDate (scm_car (interval));
+        ends[i] = gnc_time64_to_GDate (scm_cadr (interval));
+    }
+
+    series = gnc_sx_cashflow_project (all_sxes, starts, ends, n_ranges, NULL);
+    for (node = series; node; node = node->next)
+    {
+        GncSxCashflowSeries *account_series = node->data;
+        SCM amounts = SCM_EOL;
+
+        for (i = n_ranges; i-- > 0;)
+            amounts = scm_cons (gnc_numeric_to_scm (account_series->amounts[i]),
+                                amounts);
+        scm_hash_set_x (table,
+                        gnc_guid2scm (*xaccAccountGetGUID (account_series->account)),
+                        amounts);
+    }
+
+    gnc_sx_cashflow_series_list_free (series);
+    g_free (starts);
+    g_free (ends);
+    return table;
+}
 %}
 #include <gnc-sx-instance-model.h>
 %import "base-typemaps.i"
@@ -72,3 +115,5 @@ $result = table;
 }
 GHashTable* gnc_sx_all_instantiate_cashflow_all(GDate range_start, GDate range_end);
 %clear GHashTable *;
+
+SCM gnc_sx_all_instantiate_cashflow_series (SCM intervals);
@@ -1435,6 +1435,56 @@ gnc_tree_model_price_row_delete (GncTreeModelPrice *model,
 }
 
 
+/** This function updates the model after many prices were added to the
+ *  price db at once, which only announces itself by a single event for the
+ *  price db.  The namespaces are not affected, so each of them is removed
+ *  from and then re-inserted into the views, which then read the
+ *  commodities and prices below them anew.
+ *
+ *  @internal
+ *
+ *  @param model The price tree model.
+ */
+static void
+gnc_tree_model_price_reload (GncTreeModelPrice *model)
+{
+    GtkTreeModel *tree_model;
+    GtkTreePath *path;
+    GtkTreeIter iter;
+    gint i, n;
+
+    ENTER("model %p", model);
+
+    tree_model = GTK_TREE_MODEL(model);
+    gnc_pricedb_nth_price_reset_cache (model->price_db);
+    do
+    {
+        model->stamp++;
+    }
+    while (model->stamp == 0);
+
+    n = gtk_tree_model_iter_n_children (tree_model, NULL);
+    for (i = n - 1; i >= 0; i--)
+    {
+        path = gtk_tree_path_new_from_indices (i, -1);
+        gtk_tree_model_row_deleted (tree_model, path);
+        gtk_tree_path_free (path);
+    }
+    for (i = 0; i < n; i++)
+    {
+        if (!gtk_tree_model_iter_nth_child (tree_model, &iter, NULL, i))
+            continue;
+        path = gtk_tree_path_new_from_indices (i, -1);
+        gtk_tree_model_row_inserted (tree_model, path, &iter);
+        if (gtk_tree_model_iter_has_child (tree_model, &iter))
+            gtk_tree_model_row_has_child_toggled (tree_model, path, &iter);
+        gtk_tree_path_free (path);
+    }
+
+    LEAVE(" ");
+}
+
+
 /** This function is a one-shot helper routine for the following
  *  gnc_tree_model_price_event_handler() function.  It must be armed
  *  each time an item is removed from the model.  This function will
@@ -1486,7 +1536,8 @@ gnc_tree_model_price_do_deletions (gpointer price_db)
  *  namespace is added to the engine, modified, or deleted from the engine.
  *  This change to the model is then propagated to any/all overlying filters
  *  and views. This function listens to the ADD, REMOVE, MODIFY, and DESTROY
- *  events.
+ *  events, and to the MODIFY event for the price db that replaces them when
+ *  many prices are added at once.
  *
  *  @internal
  *
@@ -1581,6 +1632,15 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
             }
         }
     }
+    else if (GNC_IS_PRICEDB(entity))
+    {
+        /* A batch of prices was added. */
+        if (event_type == QOF_EVENT_MODIFY &&
+            GNC_PRICEDB(entity) == model->price_db)
+            gnc_tree_model_price_reload (model);
+        LEAVE(" ");
+        return;
+    }
     else
     {
         LEAVE(" ");
@@ -1172,14 +1172,17 @@ bgv_get_total_for_account (Account *account, GncBudget *budget, gnc_commodity *n
     gnc_numeric total = gnc_numeric_zero ();
     GNCPriceDB *pdb;
     gnc_commodity *currency;
+    time64 *period_starts = NULL;
+
+    num_periods = gnc_budget_get_num_periods (budget);
 
     if (new_currency)
     {
         pdb      = gnc_pricedb_get_db (gnc_get_current_book ());
         currency = gnc_account_get_currency_or_parent (account);
+        period_starts = g_new (time64, num_periods);
+        gnc_budget_get_period_dates (budget, period_starts, NULL);
     }
-
-    num_periods = gnc_budget_get_num_periods (budget);
     for (period_num = 0; period_num < num_periods; ++period_num)
     {
         if (!gnc_budget_is_account_period_value_set (budget, account, period_num))
@@ -1192,7 +1195,7 @@ bgv_get_total_for_account (Account *account, GncBudget *budget, gnc_commodity *n
                 {
                     numeric = gnc_pricedb_convert_balance_nearest_price_t64 (
                                 pdb, numeric, currency, new_currency,
-                                gnc_budget_get_period_start_date (budget, period_num));
+                                period_starts[period_num]);
                 }
                 total = gnc_numeric_add (total, numeric, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
             }
@@ -1206,13 +1209,14 @@ bgv_get_total_for_account (Account *account, GncBudget *budget, gnc_commodity *n
                 {
                     numeric = gnc_pricedb_convert_balance_nearest_price_t64 (
                                 pdb, numeric, currency, new_currency,
-                                gnc_budget_get_period_start_date (budget, period_num));
+                                period_starts[period_num]);
                 }
                 total = gnc_numeric_add (total, numeric, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
             }
         }
     }
 
+    g_free (period_starts);
     return total;
 }
 
@@ -34,6 +34,8 @@
 
 #include <config.h>
 
+#include <vector>
+
 #include <gtk/gtk.h>
 #ifdef __G_IR_SCANNER__
 #undef __G_IR_SCANNER__
@@ -988,11 +990,12 @@ estimate_budget_helper (GtkTreeModel *model, GtkTreePath *path,
     }
     else
     {
+        std::vector<time64> starts (num_periods), ends (num_periods);
+        recurrenceGetPeriodTimes (&priv->r, num_periods, starts.data (), ends.data ());
         for (i = 0; i < num_periods; i++)
         {
             num = xaccAccountGetNoclosingBalanceChangeForPeriod
-                (acct, recurrenceGetPeriodTime (&priv->r, i, FALSE),
-                 recurrenceGetPeriodTime (&priv->r, i, TRUE), TRUE);
+                (acct, starts[i], ends[i], TRUE);
 
             if (!gnc_numeric_check (num))
             {
@@ -289,7 +289,8 @@ std::string GncImportPrice::verify_essentials (void)
         return std::string();
 }
 
-Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over)
+Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over,
+                                     PriceBatch& batch)
 {
     /* Gently refuse to create the price if the basics are not set correctly
      * This should have been tested before calling this function though!
@@ -306,11 +307,25 @@ Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over)
     auto amount = *m_amount;
     Result ret_val = ADDED;
 
-    GNCPrice *old_price = gnc_pricedb_lookup_day_t64 (pdb, *m_from_commodity,
-                                                      *m_to_currency, date);
+    /* An earlier line of the file may already have a price for this day,
+     * in which case it takes the place of the one in the pricedb. */
+    auto key = std::make_tuple (*m_from_commodity, *m_to_currency, date);
+    auto pending = batch.find (key);
+    GNCPrice *old_price = nullptr;
+    if (pending == batch.end())
+        old_price = gnc_pricedb_lookup_day_t64 (pdb, *m_from_commodity,
+                                                *m_to_currency, date);
 
     // Should old price be over written
-    if ((old_price != nullptr) && (over == true))
+    if (over && pending != batch.end())
+    {
+        DEBUG("Over write");
+        gnc_price_unref (pending->second.first);
+        batch.erase (pending);
+        pending = batch.end();
+        ret_val = REPLACED;
+    }
+    else if ((old_price != nullptr) && (over == true))
     {
         DEBUG("Over write");
         gnc_pricedb_remove_price (pdb, old_price);
@@ -328,7 +343,7 @@ Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over)
           gnc_commodity_get_fullname (*m_to_currency),
           amount.to_string().c_str());
     // Create the new price
-    if (old_price == nullptr)
+    if (old_price == nullptr && pending == batch.end())
     {
         DEBUG("Create");
         GNCPrice *price = gnc_price_create (book);
@@ -347,16 +362,13 @@ Result GncImportPrice::create_price (QofBook* book, GNCPriceDB *pdb, bool over)
         gnc_price_set_typestr (price, PRICE_TYPE_LAST);
         gnc_price_commit_edit (price);
 
-        bool perr = gnc_pricedb_add_price (pdb, price);
-
-        gnc_price_unref (price);
-
-        if (perr == false)
-            throw std::invalid_argument (_("Failed to create price from selected columns."));
+        // The batch keeps our reference until it is added to the pricedb
+        batch.emplace (key, std::make_pair (price, ret_val));
     }
     else
     {
-        gnc_price_unref (old_price);
+        if (old_price)
+            gnc_price_unref (old_price);
         ret_val = DUPLICATED;
     }
     return ret_val;
@@ -37,6 +37,7 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <tuple>
 #include <gnc-datetime.hpp>
 #include <gnc-numeric.hpp>
 
@@ -56,6 +57,12 @@ enum class GncPricePropType {
 
 enum Result { FAILED, ADDED, DUPLICATED, REPLACED };
 
+/** Prices created from the imported lines but not yet added to the pricedb,
+ *  keyed by commodity, currency and date, along with how each was counted.
+ *  Each holds a reference that has to be dropped once the batch is added. */
+using PriceBatch = std::map<std::tuple<gnc_commodity*, gnc_commodity*, time64>,
+                            std::pair<GNCPrice*, Result>>;
+
 /** Maps all column types to a string representation.
  *  The actual definition is in gnc-imp-props-price.cpp.
  *  Attention: that definition should be adjusted for any
@@ -91,7 +98,7 @@ public:
     void set_currency_format (int currency_format) { m_currency_format = currency_format ;}
     void reset (GncPricePropType prop_type);
     std::string verify_essentials (void);
-    Result create_price (QofBook* book, GNCPriceDB *pdb, bool over);
+    Result create_price (QofBook* book, GNCPriceDB *pdb, bool over, PriceBatch& batch);
 
     gnc_commodity* get_from_commodity () { if (m_from_commodity) return *m_from_commodity; else return nullptr; }
     void set_from_commodity (gnc_commodity* comm) { if (comm) m_from_commodity = comm; else m_from_commodity.reset(); }
@@ -552,7 +552,8 @@ static void price_properties_verify_essentials (std::vector<parse_line_t>::itera
         throw std::invalid_argument(error_message);
 }
 
-void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_line)
+void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_line,
+                                   PriceBatch& batch)
 {
     StrVec line;
     std::string error_message;
@@ -607,8 +608,8 @@ void GncPriceImport::create_price (std::vector<parse_line_t>::iterator& parsed_l
         QofBook* book = gnc_get_current_book();
         GNCPriceDB *pdb = gnc_pricedb_get_db (book);
 
-        /* If all went well, add this price to the list. */
-        auto price_created = price_props->create_price (book, pdb, m_over_write);
+        /* If all went well, add this price to the batch. */
+        auto price_created = price_props->create_price (book, pdb, m_over_write, batch);
         if (price_created == ADDED)
             m_prices_added++;
         else if (price_created == DUPLICATED)
@@ -642,6 +643,7 @@ void GncPriceImport::create_prices ()
     m_prices_replaced = 0;
 
     /* Iterate over all parsed lines */
+    PriceBatch batch;
     for (auto parsed_lines_it = m_parsed_lines.begin();
             parsed_lines_it != m_parsed_lines.end();
             ++parsed_lines_it)
@@ -651,8 +653,44 @@ void GncPriceImport::create_prices ()
             continue;
 
         /* Should not throw anymore, otherwise verify needs revision */
-        create_price (parsed_lines_it);
+        create_price (parsed_lines_it, batch);
     }
+
+    /* Add the new prices to the pricedb in one go. */
+    PriceList *prices = nullptr;
+    for (auto& entry : batch)
+        prices = g_list_prepend (prices, entry.second.first);
+    prices = g_list_reverse (prices);
+    if (prices)
+    {
+        auto pdb = gnc_pricedb_get_db (gnc_get_current_book());
+        auto added = gnc_pricedb_add_prices (pdb, prices);
+        if (added < batch.size())
+        {
+            /* The pricedb kept a better price for some of the days, so
+             * count those lines as duplicates instead. */
+            PWARN ("Only %u of %zu prices were added to the pricedb",
+                   added, batch.size());
+            for (auto& entry : batch)
+            {
+                auto price = entry.second.first;
+                auto kept = gnc_pricedb_lookup_day_t64 (pdb,
+                                                        gnc_price_get_commodity (price),
+                                                        gnc_price_get_currency (price),
+                                                        gnc_price_get_time64 (price));
+                if (kept)
+                    gnc_price_unref (kept);
+                if (kept == price)
+                    continue;
+                if (entry.second.second == REPLACED)
+                    m_prices_replaced--;
+                else
+                    m_prices_added--;
+                m_prices_duplicated++;
+            }
+        }
+    }
+    g_list_free_full (prices, (GDestroyNotify)gnc_price_unref);
     PINFO("Number of lines is %d, added %d, duplicated %d, replaced %d",
          (int)m_parsed_lines.size(), m_prices_added, m_prices_duplicated, m_prices_replaced);
 }
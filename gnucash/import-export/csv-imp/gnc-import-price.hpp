@@ -150,7 +150,8 @@ private:
      *  to convert a single tokenized line into a price using
      *  the column types the user has set.
      */
-    void create_price (std::vector<parse_line_t>::iterator& parsed_line);
+    void create_price (std::vector<parse_line_t>::iterator& parsed_line,
+                       PriceBatch& batch);
 
     void verify_column_selections (ErrorListPrice& error_msg);
 
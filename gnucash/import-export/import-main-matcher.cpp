@@ -81,6 +81,7 @@ struct _main_matcher_info
     GtkWidget               *append_text; // Update+Clear: Append import Desc/Notes to matched Desc/Notes
     GtkWidget               *reconcile_after_close;
     bool add_toggled;     // flag to indicate that add has been toggled to stop selection
+    bool bayes_batch_open; // Bayesian matching works in memory while transactions are added
     gint id;
     GSList* temp_trans_list;  // Temporary list of imported transactions
     GHashTable* acct_id_hash; // Hash table, per account, of list of transaction IDs.
@@ -194,6 +195,17 @@ defer_bal_computation (GNCImportMainMatcher *info, Account* acc)
     }
 }
 
+/* Ends the Bayesian matching batch opened for adding the imported
+ * transactions, if it is still open. */
+static void
+end_bayes_batch (GNCImportMainMatcher *info)
+{
+    if (!info->bayes_batch_open)
+        return;
+    gnc_account_imap_end_bayes_batch ();
+    info->bayes_batch_open = false;
+}
+
 void
 gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
 {
@@ -237,6 +249,9 @@ gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
     // We've deferred balance computations on many accounts. Let's do it now that we're done.
     update_all_balances (info);
 
+    // In case the import was abandoned before its transactions were shown.
+    end_bayes_batch (info);
+
     gnc_import_PendingMatches_delete (info->pending_matches);
     g_hash_table_destroy (info->acct_id_hash);
     g_hash_table_destroy (info->desc_hash);
@@ -495,6 +510,9 @@ gnc_gen_trans_list_show_all (GNCImportMainMatcher *info)
 {
     g_assert (info);
 
+    // All the imported transactions have been added and matched.
+    end_bayes_batch (info);
+
     // Set initial state of Append checkbox to same as last import for this account.
     // Get the import account from the first split in first transaction.
     GSList *temp_trans_list = info->temp_trans_list;
@@ -544,9 +562,16 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
     /* Don't run any queries and/or split sorts while processing the matcher
     results. */
     gnc_suspend_gui_refresh ();
+    /* Likewise, store the imported transactions and the accounts together
+     * when the book is in a database. */
+    auto backend = qof_book_get_backend (gnc_get_current_book ());
+    qof_backend_begin_group_commit (backend);
     bool first_tran = true;
     bool append_text = gtk_toggle_button_get_active ((GtkToggleButton*) info->append_text);
     GList *accounts_modified = NULL;
+    /* Learn the Bayesian tokens of all the transactions in memory and write
+     * them back to the accounts once. */
+    gnc_account_imap_begin_bayes_batch ();
     do
     {
         GNCImportTransInfo *trans_info;
@@ -588,6 +613,9 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
     }
     while (gtk_tree_model_iter_next (model, &iter));
 
+    // Write back the Bayesian token counts learned during this import.
+    gnc_account_imap_end_bayes_batch ();
+
     gnc_gen_trans_list_delete (info);
 
     /* Allow GUI refresh again. */
@@ -595,6 +623,13 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
 
     /* DEBUG ("End") */
     g_list_free_full (accounts_modified, (GDestroyNotify)xaccAccountCommitEdit);
+    if (!qof_backend_end_group_commit (backend))
+    {
+        PERR ("Storing the imported transactions failed");
+        gnc_error_dialog (gnc_ui_get_main_window (nullptr), "%s",
+                          _("The imported transactions could not be saved to the database. "
+                            "They remain in the book, but are not stored yet."));
+    }
 }
 
 void
@@ -1682,6 +1717,11 @@ gnc_gen_trans_common_setup (GNCImportMainMatcher *info,
 {
     info->pending_matches = gnc_import_PendingMatches_new ();
 
+    /* Match the Bayesian tokens of the imported transactions in memory
+     * until they have all been added. */
+    gnc_account_imap_begin_bayes_batch ();
+    info->bayes_batch_open = true;
+
     /* Initialize user Settings. */
     info->user_settings = gnc_import_Settings_new ();
     gnc_import_Settings_set_match_date_hardlimit (info->user_settings, match_date_hardlimit);
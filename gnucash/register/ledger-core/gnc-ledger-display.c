@@ -904,6 +904,9 @@ gnc_ledger_display_refresh_internal (GNCLedgerDisplay* ld)
      * changed, requiring a full new query.  Similar considerations
      * needed for multi-user mode.
      */
+    /* A book opened from a database may have left older transactions out;
+     * load those of the register's accounts and dates. */
+    xaccQueryLoadHistory (ld->query);
     splits = qof_query_run (ld->query);
 
     if (!qof_query_equal (ld->query, ld->pre_filter_query))
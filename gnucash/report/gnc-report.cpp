@@ -27,6 +27,7 @@
 #define _GL_UNISTD_H //Deflect poisonous define in Guile's GnuLib
 #endif
 #include <gnc-optiondb.hpp>
+#include <gnc-optiondb-impl.hpp>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gtk/gtk.h>
@@ -41,6 +42,9 @@
 #include <gnc-filepath-utils.h>
 #include <gnc-guile-utils.h>
 #include <gnc-engine.h>
+#include <Account.h>
+#include <gnc-pricedb.h>
+#include <gnc-ui-util.h>
 #include "gnc-report.h"
 
 extern "C" SCM scm_init_sw_report_module(void);
@@ -208,17 +212,69 @@ gnc_reports_foreach (GHFunc func, gpointer user_data)
         g_hash_table_foreach (reports, func, user_data);
 }
 
+/* A book opened from a database may have left older transactions out.
+ * Load those the report covers: from its start date on, for its accounts
+ * and their subaccounts. A report without one of those options gets all
+ * the dates or all the accounts. */
+static void
+load_report_history (SCM report)
+{
+    auto book = gnc_get_current_book ();
+    auto be = qof_book_get_backend (book);
+    if (!be)
+        return;
+
+    auto odb = gnc_get_optiondb_from_dispatcher
+        (scm_call_1 (scm_c_eval_string ("gnc:report-options"), report));
+    auto start_option = odb ? odb->find_option ("General", "Start Date") : nullptr;
+    auto accounts_option = odb ? odb->find_option ("Accounts", "Accounts") : nullptr;
+    auto since = start_option ? start_option->get_value<time64>() : G_MININT64;
+
+    if (!accounts_option)
+    {
+        qof_backend_load_older (be, nullptr, since);
+        return;
+    }
+    for (const auto& guid : accounts_option->get_value<GncOptionAccountList>())
+        if (auto acc = xaccAccountLookup (&guid, book))
+            gnc_account_load_history (acc, since, TRUE);
+}
+
+/* Whether the report's "Chain Price Conversions" option is set; see
+ * gnc:options-add-multi-hop-prices!. */
+static bool
+report_chains_prices (SCM report)
+{
+    auto odb = gnc_get_optiondb_from_dispatcher
+        (scm_call_1 (scm_c_eval_string ("gnc:report-options"), report));
+    auto option = odb ? odb->find_option ("Commodities", "Chain Price Conversions")
+        : nullptr;
+    return option && option->get_value<bool>();
+}
+
 gboolean
 gnc_run_report_with_error_handling (gint report_id, gchar ** data, gchar **errmsg)
 {
     SCM report, res, html, captured_error;
+    GNCPriceDB *pricedb;
+    bool multi_hop;
 
     report = gnc_report_find (report_id);
     g_return_val_if_fail (data, FALSE);
     g_return_val_if_fail (errmsg, FALSE);
     g_return_val_if_fail (!scm_is_false (report), FALSE);
 
+    load_report_history (report);
+
+    /* Let the reports that ask for it chain prices through several other
+     * commodities. The rates worked out either way are kept for later runs. */
+    pricedb = gnc_pricedb_get_db (gnc_get_current_book ());
+    multi_hop = report_chains_prices (report);
+    if (multi_hop)
+        gnc_pricedb_set_multi_hop_conversions (pricedb, TRUE);
     res = scm_call_1 (scm_c_eval_string ("gnc:render-report"), report);
+    if (multi_hop)
+        gnc_pricedb_set_multi_hop_conversions (pricedb, FALSE);
     html = scm_car (res);
     captured_error = scm_cadr (res);
 
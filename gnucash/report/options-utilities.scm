@@ -34,6 +34,7 @@
 (export gnc:options-add-account-selection!)
 (export gnc:options-add-currency!)
 (export gnc:options-add-price-source!)
+(export gnc:options-add-multi-hop-prices!)
 (export gnc:options-add-plot-size!)
 (export gnc:options-add-marker-choice!)
 (export gnc:options-add-sort-method!)
@@ -143,6 +144,16 @@
           (vector 'pricedb-nearest (N_ "Closest to report date"))
           (vector 'pricedb-latest (N_ "Most recent")))))
 
+;; Whether prices may be chained through several other commodities when
+;; there's no direct rate. The report runner looks for this option on the
+;; Commodities page.
+(define (gnc:options-add-multi-hop-prices! options sort-tag)
+  (gnc-register-simple-boolean-option (gnc:optiondb options)
+    (N_ "Commodities") (N_ "Chain Price Conversions")
+    sort-tag
+    (N_ "Convert through a chain of other commodities' prices when there is no direct or single-currency price.")
+    #f))
+
 ;; The width- and height- options for charts
 (define (gnc:options-add-plot-size!
          options pagename
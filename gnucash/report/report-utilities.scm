@@ -446,11 +446,16 @@
     (gnc:make-gnc-monetary (xaccAccountGetCommodity account) (or bal 0)))
   (define balance 0)
   (map amount->monetary
-       (gnc:account-accumulate-at-dates
-        account dates-list #:split->elt
-        (lambda (s)
-          (if s (set! balance (+ balance (or (split->amount s) 0))))
-          balance))))
+       (if (eq? split->amount xaccSplitGetAmount)
+           ;; the plain balance is the running balance, which the engine
+           ;; binary-searches; it counts splits posted before each date,
+           ;; hence the 1+ to include those posted at it.
+           (xaccAccountGetBalancesAsOfDates account (map 1+ (sort dates-list <)))
+           (gnc:account-accumulate-at-dates
+            account dates-list #:split->elt
+            (lambda (s)
+              (if s (set! balance (+ balance (or (split->amount s) 0))))
+              balance)))))
 
 
 ;; this function will scan through account splitlist, building a list
@@ -188,45 +188,49 @@ date point, a projected minimum balance including scheduled transactions."))
         report-title (gnc:report-id report-obj))))
 
      (else
-      ;; initialize the SX balance accumulator with the instantiated SX
-      ;; amounts starting from the earliest split date in the list of
-      ;; accounts up to the report start date.
+      ;; project the SX amounts of every interval at once, preceded by
+      ;; the amounts from the earliest split date in the list of accounts
+      ;; up to the report start date, which initialize the SX balance
+      ;; accumulator.
       (let* ((accounts-dates (map (compose xaccTransGetDate xaccSplitGetParent car)
                                   (filter pair?
                                           (map xaccAccountGetSplitList accounts))))
              (earliest (and (pair? accounts-dates) (apply min accounts-dates)))
-             (sx-hash (if earliest
-                          (gnc-sx-all-instantiate-cashflow-all earliest from-date)
-                          (make-hash-table))))
-        (for-each
-         (lambda (account)
-           (accum 'add (xaccAccountGetCommodity account)
-                  (hash-ref sx-hash (gncAccountGetGUID account) 0)))
-         accounts))
-
-      ;; Calculate balances
-      (let ((balances
-             (map
-              (lambda (date accounts-balance)
-                (let* ((start-date (car date))
-                       (end-date (cadr date))
-                       (balance (gnc:make-commodity-collector))
-                       (sx-value (gnc-sx-all-instantiate-cashflow-all
-                                  start-date end-date)))
-                  (for-each
-                   (lambda (account account-balance)
-                     (accum 'add (xaccAccountGetCommodity account)
-                            (hash-ref sx-value (gncAccountGetGUID account) 0))
-                     (balance 'add (gnc:gnc-monetary-commodity account-balance)
-                              (gnc:gnc-monetary-amount account-balance)))
-                   accounts accounts-balance)
-                  (balance 'merge accum #f)
-                  (gnc:gnc-monetary-amount
-                   (gnc:sum-collector-commodity
-                    balance currency
-                    (lambda (monetary target-curr)
-                      (exchange-fn monetary target-curr end-date))))))
-              intervals (apply zip accounts-balancelist))))
+             (sx-series (gnc-sx-all-instantiate-cashflow-series
+                         (if earliest
+                             (cons (list earliest from-date) intervals)
+                             intervals)))
+             (accounts-sx-values
+              (map
+               (lambda (account)
+                 (let ((sx-values (hash-ref sx-series (gncAccountGetGUID account))))
+                   (cond
+                    ((not sx-values) (make-list (length intervals) 0))
+                    (earliest
+                     (accum 'add (xaccAccountGetCommodity account) (car sx-values))
+                     (cdr sx-values))
+                    (else sx-values))))
+               accounts))
+             ;; Calculate balances
+             (balances
+              (map
+               (lambda (date accounts-balance accounts-sx-value)
+                 (let* ((end-date (cadr date))
+                        (balance (gnc:make-commodity-collector)))
+                   (for-each
+                    (lambda (account account-balance sx-value)
+                      (accum 'add (xaccAccountGetCommodity account) sx-value)
+                      (balance 'add (gnc:gnc-monetary-commodity account-balance)
+                               (gnc:gnc-monetary-amount account-balance)))
+                    accounts accounts-balance accounts-sx-value)
+                   (balance 'merge accum #f)
+                   (gnc:gnc-monetary-amount
+                    (gnc:sum-collector-commodity
+                     balance currency
+                     (lambda (monetary target-curr)
+                       (exchange-fn monetary target-curr end-date))))))
+               intervals (apply zip accounts-balancelist)
+               (apply zip accounts-sx-values))))
 
         ;; Minimum line
         (when show-minimum
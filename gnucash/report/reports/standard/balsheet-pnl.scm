@@ -112,6 +112,7 @@ below parent and children groups."))
 (define optname-report-commodity (N_ "Report's currency"))
 
 (define optname-price-source (N_ "Price Source"))
+(define optname-multi-hop (N_ "Chain Price Conversions"))
 
 (define optname-show-foreign (N_ "Show original currency amount"))
 (define opthelp-show-foreign (N_ "Also show original currency amounts"))
@@ -226,7 +227,8 @@ also show overall period profit & loss."))
          (list optname-report-commodity
                optname-show-rates
                optname-show-foreign
-               optname-price-source))))
+               optname-price-source
+               optname-multi-hop))))
 
     (gnc:options-add-currency!
      options pagename-commodities
@@ -236,6 +238,8 @@ also show overall period profit & loss."))
      options pagename-commodities
      optname-price-source "d" 'pricedb-nearest)
 
+    (gnc:options-add-multi-hop-prices! options "da")
+
     (gnc-register-simple-boolean-option options
       pagename-commodities optname-show-foreign
       "e" opthelp-show-foreign #t)
@@ -668,6 +668,17 @@
         '(("USD" . 0) ("USD" . 18) ("USD" . 18) ("USD" . 18))
         (map monetary->pair (gnc:account-get-balances-at-dates bank4 dates)))
 
+      (test-equal "unsorted dates give the balances in date order"
+        '(("USD" . 0) ("USD" . 10) ("USD" . 30) ("USD" . 150))
+        (map monetary->pair (gnc:account-get-balances-at-dates
+                             bank1 (reverse dates))))
+
+      (test-equal "engine balances match summing the split amounts"
+        (map monetary->pair (gnc:account-get-balances-at-dates bank2 dates))
+        (map monetary->pair (gnc:account-get-balances-at-dates
+                             bank2 dates #:split->amount
+                             (lambda (s) (xaccSplitGetAmount s)))))
+
       (test-equal "1 txn in each slot"
         '(#f 10 30 150)
         (gnc:account-accumulate-at-dates bank1 dates))
@@ -32,10 +32,13 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 
 /* Keys used for core preferences */
 #define GNC_PREF_FILE_COMPRESSION    "file-compression"
+#define GNC_PREF_FILE_COMPRESSION_LEVEL   "file-compression-level"
+#define GNC_PREF_FILE_COMPRESSION_THREADS "file-compression-threads"
 #define GNC_PREF_RETAIN_TYPE_NEVER   "retain-type-never"
 #define GNC_PREF_RETAIN_TYPE_DAYS    "retain-type-days"
 #define GNC_PREF_RETAIN_TYPE_FOREVER "retain-type-forever"
 #define GNC_PREF_RETAIN_DAYS         "retain-days"
+#define GNC_PREF_SQL_LAZY_LOAD       "sql-lazy-load-months"
 
 /***************************************************************
  * Initialization                                              *
@@ -78,6 +81,28 @@ file_compression_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
     }
 }
 
+static void
+file_compression_options_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint level = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL);
+        gint threads = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_THREADS);
+        gnc_prefs_set_file_compression_level (CLAMP (level, -1, 9));
+        gnc_prefs_set_file_compression_threads (MAX (threads, 0));
+    }
+}
+
+static void
+sql_lazy_load_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint months = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LAZY_LOAD);
+        gnc_prefs_set_sql_lazy_load_months (months);
+    }
+}
+
 
 void gnc_prefs_init (void)
 {
@@ -89,6 +114,8 @@ void gnc_prefs_init (void)
     file_retain_changed_cb (NULL, NULL, NULL);
     file_retain_type_changed_cb (NULL, NULL, NULL);
     file_compression_changed_cb (NULL, NULL, NULL);
+    file_compression_options_changed_cb (NULL, NULL, NULL);
+    sql_lazy_load_changed_cb (NULL, NULL, NULL);
 
     /* Check for invalid retain_type (days)/retain_days (0) combo.
      * This can happen either because a user changed the preferences
@@ -122,6 +149,12 @@ void gnc_prefs_init (void)
                            file_retain_type_changed_cb, NULL);
     gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION,
                            file_compression_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL,
+                           file_compression_options_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_THREADS,
+                           file_compression_options_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LAZY_LOAD,
+                           sql_lazy_load_changed_cb, NULL);
 
 }
 
@@ -139,5 +172,11 @@ gnc_prefs_remove_registered (void)
                            file_retain_type_changed_cb, NULL);
     gnc_prefs_remove_cb_by_func (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION,
                            file_compression_changed_cb, NULL);
+    gnc_prefs_remove_cb_by_func (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL,
+                           file_compression_options_changed_cb, NULL);
+    gnc_prefs_remove_cb_by_func (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_THREADS,
+                           file_compression_options_changed_cb, NULL);
+    gnc_prefs_remove_cb_by_func (GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LAZY_LOAD,
+                           sql_lazy_load_changed_cb, NULL);
     gnc_gsettings_shutdown ();
 }
@@ -1400,13 +1400,18 @@ gnc_sx_instance_model_effect_change(GncSxInstanceModel *model,
                                     GList **creation_errors)
 {
     GList *iter;
+    QofBook *book = gnc_get_current_book();
 
-    if (qof_book_is_readonly(gnc_get_current_book()))
+    if (qof_book_is_readonly(book))
     {
         /* Is the book read-only? Then don't change anything here. */
         return;
     }
 
+    /* Store all of the created transactions and updated SXes together
+     * rather than one database transaction per object. */
+    qof_backend_begin_group_commit (qof_book_get_backend (book));
+
     for (iter = model->sx_instance_list; iter != NULL; iter = iter->next)
     {
         GList *instance_iter;
@@ -1502,6 +1507,15 @@ gnc_sx_instance_model_effect_change(GncSxInstanceModel *model,
         gnc_sx_set_instance_count(instances->sx, instance_count);
         xaccSchedXactionSetRemOccur(instances->sx, remain_occur_count);
     }
+
+    if (!qof_backend_end_group_commit (qof_book_get_backend (book)))
+    {
+        const gchar *err = N_("The created transactions and updated scheduled "
+                              "transactions could not be saved to the database.");
+        g_critical ("%s", err);
+        if (creation_errors)
+            *creation_errors = g_list_append (*creation_errors, g_strdup (_(err)));
+    }
 }
 
 void
@@ -1674,28 +1688,12 @@ GHashTable* gnc_g_hash_new_guid_numeric()
                                   NULL, gnc_numeric_free);
 }
 
-typedef struct
-{
-    GHashTable *hash;
-    GList **creation_errors;
-    const SchedXaction *sx;
-    gnc_numeric count;
-} SxCashflowData;
-
-static void add_to_hash_amount(GHashTable* hash, const GncGUID* guid, const gnc_numeric* amount)
+/* Adds amount to *elem, which holds the cash flow into the account
+ * with the given guid. */
+static void add_cashflow_amount(gnc_numeric* elem, const GncGUID* guid, const gnc_numeric* amount)
 {
-    /* Do we have a number belonging to this GUID in the hash? If yes,
-     * modify it in-place; if not, insert the new element into the
-     * hash. */
-    gnc_numeric* elem = g_hash_table_lookup(hash, guid);
     gchar guidstr[GUID_ENCODING_LENGTH+1];
     guid_to_string_buff(guid, guidstr);
-    if (!elem)
-    {
-        elem = g_new0(gnc_numeric, 1);
-        *elem = gnc_numeric_zero();
-        g_hash_table_insert(hash, (gpointer) guid, elem);
-    }
 
     /* Check input arguments for sanity */
     if (gnc_numeric_check(*amount) != GNC_ERROR_OK)
@@ -1741,6 +1739,242 @@ static void add_to_hash_amount(GHashTable* hash, const GncGUID* guid, const gnc_
             gnc_num_dbg_to_string(*elem));
 }
 
+static void add_to_hash_amount(GHashTable* hash, const GncGUID* guid, const gnc_numeric* amount)
+{
+    /* Do we have a number belonging to this GUID in the hash? If yes,
+     * modify it in-place; if not, insert the new element into the
+     * hash. */
+    gnc_numeric* elem = g_hash_table_lookup(hash, guid);
+    if (!elem)
+    {
+        elem = g_new0(gnc_numeric, 1);
+        *elem = gnc_numeric_zero();
+        g_hash_table_insert(hash, (gpointer) guid, elem);
+    }
+    add_cashflow_amount(elem, guid, amount);
+}
+
+/* Cash flow projection
+ *
+ * Projecting the cash flow of an SX means counting its occurrences in
+ * each date range and multiplying the amounts of its template splits
+ * by that count.  Both are cached with the book, per SX:
+ *
+ * - The occurrence dates, as gnc_sx_get_num_occur_daterange() would
+ *   step through them, are kept as long as the SX's schedule is
+ *   unchanged, and extended as later ranges are asked for.  The
+ *   schedule is compared field by field on every use, so no event is
+ *   needed to notice a change.  Computing the dates only reads the SX,
+ *   so when many SXs need more dates they are computed on a pool of
+ *   threads.
+ *
+ * - The template splits' amounts are kept until any SX, transaction,
+ *   split or account of the book changes.  Evaluating them uses the
+ *   expression parser, which isn't thread-safe, so it is done on the
+ *   calling thread.
+ */
+#define GNC_SX_CASHFLOW_CACHE "gnc-sx-cashflow-cache"
+
+/* Below this many SXs needing dates starting threads costs more than
+ * it saves. */
+#define SX_CASHFLOW_PARALLEL_MIN 64
+
+typedef struct
+{
+    const Account *account;
+    gnc_numeric amount;         /* for one occurrence */
+} SxCashflowSplit;
+
+typedef struct
+{
+    /* The fields of the SX that determine its occurrence dates. */
+    GDate start_date;
+    GDate end_date;
+    GDate last_date;
+    gint num_occur_total;
+    gint num_occur_rem;
+    gint instance_num;
+    GList *schedule;            /* copies of the SX's recurrences */
+
+    GArray *dates;              /* julian days, starting with last_date */
+    gboolean dates_complete;    /* the SX won't occur after the dates */
+    SXTmpStateData *state;      /* the state at the last of the dates */
+
+    guint splits_generation;    /* 0 if the splits were never evaluated */
+    GArray *splits;             /* SxCashflowSplit */
+    GList *split_errors;
+} SxCashflowEntry;
+
+typedef struct
+{
+    GHashTable *entries;        /* SchedXaction* -> SxCashflowEntry* */
+    guint generation;           /* changes when template amounts may have */
+} SxCashflowCache;
+
+typedef struct
+{
+    GArray *splits;
+    GList **creation_errors;
+    const SchedXaction *sx;
+} SxCashflowData;
+
+static gint sx_cashflow_qof_event_handler_id = 0;
+
+static gboolean
+gdate_equal (const GDate *a, const GDate *b)
+{
+    if (!g_date_valid (a) || !g_date_valid (b))
+        return g_date_valid (a) == g_date_valid (b);
+    return g_date_compare (a, b) == 0;
+}
+
+static gboolean
+sx_cashflow_entry_schedule_equal (const SxCashflowEntry *entry,
+                                  const SchedXaction *sx)
+{
+    GList *a, *b;
+
+    if (!gdate_equal (&entry->start_date, xaccSchedXactionGetStartDate (sx)) ||
+        !gdate_equal (&entry->end_date, xaccSchedXactionGetEndDate (sx)) ||
+        !gdate_equal (&entry->last_date, xaccSchedXactionGetLastOccurDate (sx)) ||
+        entry->num_occur_total != xaccSchedXactionGetNumOccur (sx) ||
+        entry->num_occur_rem != xaccSchedXactionGetRemOccur (sx) ||
+        entry->instance_num != gnc_sx_get_instance_count (sx, NULL))
+        return FALSE;
+
+    for (a = entry->schedule, b = gnc_sx_get_schedule (sx); a && b;
+         a = a->next, b = b->next)
+    {
+        const Recurrence *ra = a->data, *rb = b->data;
+        if (ra->ptype != rb->ptype || ra->mult != rb->mult ||
+            ra->wadj != rb->wadj || !gdate_equal (&ra->start, &rb->start))
+            return FALSE;
+    }
+    return a == NULL && b == NULL;
+}
+
+static void
+sx_cashflow_entry_reset_dates (SxCashflowEntry *entry, const SchedXaction *sx)
+{
+    guint32 julian;
+
+    entry->start_date = *xaccSchedXactionGetStartDate (sx);
+    entry->end_date = *xaccSchedXactionGetEndDate (sx);
+    entry->last_date = *xaccSchedXactionGetLastOccurDate (sx);
+    entry->num_occur_total = xaccSchedXactionGetNumOccur (sx);
+    entry->num_occur_rem = xaccSchedXactionGetRemOccur (sx);
+    entry->instance_num = gnc_sx_get_instance_count (sx, NULL);
+
+    g_list_free_full (entry->schedule, g_free);
+    entry->schedule = NULL;
+    for (GList *node = gnc_sx_get_schedule (sx); node; node = node->next)
+    {
+        Recurrence *r = g_new (Recurrence, 1);
+        *r = *(Recurrence *) node->data;
+        entry->schedule = g_list_prepend (entry->schedule, r);
+    }
+    entry->schedule = g_list_reverse (entry->schedule);
+
+    if (entry->state)
+        gnc_sx_destroy_temporal_state (entry->state);
+    entry->state = gnc_sx_create_temporal_state (sx);
+    julian = g_date_get_julian (&entry->state->last_date);
+    g_array_set_size (entry->dates, 0);
+    g_array_append_val (entry->dates, julian);
+    entry->dates_complete = FALSE;
+}
+
+static void
+sx_cashflow_entry_free (SxCashflowEntry *entry)
+{
+    g_list_free_full (entry->schedule, g_free);
+    g_array_free (entry->dates, TRUE);
+    gnc_sx_destroy_temporal_state (entry->state);
+    g_array_free (entry->splits, TRUE);
+    g_list_free_full (entry->split_errors, g_free);
+    g_free (entry);
+}
+
+/* Steps through the SX's occurrences until one is past the given julian
+ * day or there are no more.  Only reads the SX, so entries of different
+ * SXs can be extended on different threads. */
+static void
+sx_cashflow_entry_extend (SxCashflowEntry *entry, guint32 until,
+                          const SchedXaction *sx)
+{
+    while (!entry->dates_complete &&
+           g_array_index (entry->dates, guint32, entry->dates->len - 1) <= until)
+    {
+        gnc_sx_incr_temporal_state (sx, entry->state);
+        if (!g_date_valid (&entry->state->last_date) ||
+            (xaccSchedXactionHasOccurDef (sx) && entry->state->num_occur_rem < 0))
+        {
+            entry->dates_complete = TRUE;
+        }
+        else
+        {
+            guint32 julian = g_date_get_julian (&entry->state->last_date);
+            g_array_append_val (entry->dates, julian);
+        }
+    }
+}
+
+typedef struct
+{
+    SchedXaction *sx;
+    SxCashflowEntry *entry;
+} SxCashflowTask;
+
+static void
+sx_cashflow_extend_task (gpointer data, gpointer user_data)
+{
+    SxCashflowTask *task = data;
+    sx_cashflow_entry_extend (task->entry, *(guint32 *) user_data, task->sx);
+}
+
+/* Counts the occurrences in the date range the same way
+ * gnc_sx_get_num_occur_daterange() does, from dates extended past
+ * range_end. */
+static gint
+sx_cashflow_entry_count (const SxCashflowEntry *entry, const SchedXaction *sx,
+                         const GDate *range_start, const GDate *range_end)
+{
+    const guint32 *dates = (const guint32 *) entry->dates->data;
+    guint32 start = g_date_get_julian (range_start);
+    guint32 end = g_date_get_julian (range_end);
+    guint lo = 0, hi = entry->dates->len, i;
+    gint result = 0;
+
+    /* SX still active? */
+    if ((xaccSchedXactionHasOccurDef (sx) && xaccSchedXactionGetRemOccur (sx) <= 0) ||
+        (xaccSchedXactionHasEndDate (sx) &&
+         g_date_compare (xaccSchedXactionGetEndDate (sx), range_start) < 0))
+        return 0;
+
+    if (xaccSchedXactionHasEndDate (sx))
+        end = MIN (end, g_date_get_julian (xaccSchedXactionGetEndDate (sx)));
+
+    /* Find the first occurrence on or after the range start. */
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (dates[mid] < start)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (i = lo; i < entry->dates->len && dates[i] <= end; i++)
+        ++result;
+
+    /* The first of the dates is the SX's last occurrence, which
+     * doesn't count again. */
+    if (lo == 0 && result > 0)
+        --result;
+
+    return result;
+}
+
 static gboolean
 create_cashflow_helper(Transaction *template_txn, void *user_data)
 {
@@ -1787,8 +2021,7 @@ create_cashflow_helper(Transaction *template_txn, void *user_data)
         {
             gnc_numeric credit_num = gnc_numeric_zero();
             gnc_numeric debit_num = gnc_numeric_zero();
-            gnc_numeric final_once, final;
-            gint gncn_error;
+            SxCashflowSplit cashflow_split;
 
             /* Credit value */
             _get_sx_formula_value(creation_data->sx, template_split,
@@ -1800,22 +2033,10 @@ create_cashflow_helper(Transaction *template_txn, void *user_data)
 				  &debit_num, creation_data->creation_errors,
 				  "sx-debit-formula", "sx-debit-numeric", NULL);
 
-            /* The resulting cash flow number: debit minus credit,
-             * multiplied with the count factor. */
-            final_once = gnc_numeric_sub_fixed( debit_num, credit_num );
-            /* Multiply with the count factor. */
-            final = gnc_numeric_mul(final_once, creation_data->count,
-                                    gnc_numeric_denom(final_once),
-                                    GNC_HOW_RND_ROUND_HALF_UP);
-
-            gncn_error = gnc_numeric_check(final);
-            if (gncn_error != GNC_ERROR_OK)
-            {
-                gchar* err = N_("Error %d in SX [%s] final gnc_numeric value, using 0 instead.");
-                REPORT_ERROR(creation_data->creation_errors, err,
-                             gncn_error, xaccSchedXactionGetName(creation_data->sx));
-                final = gnc_numeric_zero();
-            }
+            /* The resulting cash flow number of one occurrence: debit
+             * minus credit. */
+            cashflow_split.account = split_acct;
+            cashflow_split.amount = gnc_numeric_sub_fixed( debit_num, credit_num );
 
             /* Print error message if we would have needed an exchange rate */
             if (! gnc_commodity_equal(split_cmdty, first_cmdty))
@@ -1825,94 +2046,314 @@ create_cashflow_helper(Transaction *template_txn, void *user_data)
                              xaccSchedXactionGetName(creation_data->sx),
                              gnc_commodity_get_mnemonic(split_cmdty),
                              gnc_commodity_get_mnemonic(first_cmdty));
-                final = gnc_numeric_zero();
+                cashflow_split.amount = gnc_numeric_zero();
             }
 
-            /* And add the resulting value to the hash */
-            add_to_hash_amount(creation_data->hash, xaccAccountGetGUID(split_acct), &final);
+            g_array_append_val(creation_data->splits, cashflow_split);
         }
     }
 
     return FALSE;
 }
 
+/* Makes sure the entry holds the amounts of the SX's template splits
+ * as of the cache's generation. */
 static void
-instantiate_cashflow_internal(const SchedXaction* sx,
-                              GHashTable* map,
-                              GList **creation_errors, gint count)
+sx_cashflow_entry_eval_splits (SxCashflowCache *cache, SxCashflowEntry *entry,
+                               const SchedXaction *sx, Account *sx_template_account)
 {
     SxCashflowData create_cashflow_data;
-    Account* sx_template_account = gnc_sx_get_template_transaction_account(sx);
 
-    if (!sx_template_account)
-    {
-        g_critical("Huh? No template account for the SX %s", xaccSchedXactionGetName(sx));
+    if (entry->splits_generation == cache->generation)
         return;
-    }
 
-    if (!xaccSchedXactionGetEnabled(sx))
-    {
-        DEBUG("Skipping non-enabled SX [%s]",
-                xaccSchedXactionGetName(sx));
-        return;
-    }
+    g_array_set_size (entry->splits, 0);
+    g_list_free_full (entry->split_errors, g_free);
+    entry->split_errors = NULL;
 
-    create_cashflow_data.hash = map;
-    create_cashflow_data.creation_errors = creation_errors;
+    create_cashflow_data.splits = entry->splits;
+    create_cashflow_data.creation_errors = &entry->split_errors;
     create_cashflow_data.sx = sx;
-    create_cashflow_data.count = gnc_numeric_create(count, 1);
 
     /* The cash flow numbers are in the transactions of the template
      * account, so run this foreach on the transactions. */
     xaccAccountForEachTransaction(sx_template_account,
                                   create_cashflow_helper,
                                   &create_cashflow_data);
+    entry->splits_generation = cache->generation;
 }
 
-typedef struct
+static void
+sx_cashflow_cache_drop (QofBook *book)
 {
-    GHashTable *hash;
-    GList **creation_errors;
-    const GDate *range_start;
-    const GDate *range_end;
-} SxAllCashflow;
+    SxCashflowCache *cache = qof_book_get_data (book, GNC_SX_CASHFLOW_CACHE);
+
+    if (!cache) return;
+
+    g_hash_table_destroy (cache->entries);
+    g_free (cache);
+    qof_book_set_data (book, GNC_SX_CASHFLOW_CACHE, NULL);
+}
 
-static void instantiate_cashflow_cb(gpointer data, gpointer _user_data)
+static void
+sx_cashflow_cache_book_end (QofBook *book, gpointer key, gpointer user_data)
 {
-    const SchedXaction* sx = (const SchedXaction*) data;
-    SxAllCashflow* userdata = (SxAllCashflow*) _user_data;
-    gint count;
+    sx_cashflow_cache_drop (book);
+}
 
-    g_assert(sx);
-    g_assert(userdata);
+/** Forgets the cached template amounts of the entity's book when a
+ *  template transaction, or anything its amounts are read from, may
+ *  have changed.
+ *
+ * @param entity Entity for the event
+ * @param event_type Event type
+ * @param user_data User data registered with the handler
+ * @param event_data Event data passed with the event.
+ */
+static void
+sx_cashflow_handle_qof_events (QofInstance *entity, QofEventId event_type,
+                               gpointer user_data, gpointer event_data)
+{
+    SxCashflowCache *cache;
+    QofBook *book;
 
-    /* How often does this particular SX occur in the date range? */
-    count = gnc_sx_get_num_occur_daterange(sx, userdata->range_start,
-                                           userdata->range_end);
-    if (count > 0)
+    if (!(GNC_IS_SPLIT (entity) || GNC_IS_TRANSACTION (entity) ||
+          GNC_IS_ACCOUNT (entity) || GNC_IS_SX (entity)))
+        return;
+
+    book = qof_instance_get_book (entity);
+    if (!book || qof_book_shutting_down (book))
+        return;
+
+    cache = qof_book_get_data (book, GNC_SX_CASHFLOW_CACHE);
+    if (!cache)
+        return;
+
+    /* 0 marks entries that were never evaluated */
+    if (++cache->generation == 0)
+        ++cache->generation;
+
+    if (GNC_IS_SX (entity) && (event_type & QOF_EVENT_DESTROY))
+        g_hash_table_remove (cache->entries, entity);
+}
+
+static SxCashflowCache *
+sx_cashflow_cache_get (QofBook *book)
+{
+    SxCashflowCache *cache = qof_book_get_data (book, GNC_SX_CASHFLOW_CACHE);
+
+    if (!cache)
     {
-        /* If it occurs at least once, calculate ("instantiate") its
-         * cash flow and add it to the result
-         * g_hash<GUID,gnc_numeric> */
-        instantiate_cashflow_internal(sx,
-                                      userdata->hash,
-                                      userdata->creation_errors,
-                                      count);
+        if (sx_cashflow_qof_event_handler_id == 0)
+            sx_cashflow_qof_event_handler_id =
+                qof_event_register_handler (sx_cashflow_handle_qof_events, NULL);
+
+        cache = g_new0 (SxCashflowCache, 1);
+        cache->entries = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                (GDestroyNotify) sx_cashflow_entry_free);
+        cache->generation = 1;
+        qof_book_set_data_fin (book, GNC_SX_CASHFLOW_CACHE, cache,
+                               sx_cashflow_cache_book_end);
     }
+    return cache;
+}
+
+static SxCashflowEntry *
+sx_cashflow_cache_lookup (SxCashflowCache *cache, SchedXaction *sx)
+{
+    SxCashflowEntry *entry = g_hash_table_lookup (cache->entries, sx);
+
+    if (!entry)
+    {
+        entry = g_new0 (SxCashflowEntry, 1);
+        entry->dates = g_array_new (FALSE, FALSE, sizeof (guint32));
+        entry->splits = g_array_new (FALSE, FALSE, sizeof (SxCashflowSplit));
+        sx_cashflow_entry_reset_dates (entry, sx);
+        g_hash_table_insert (cache->entries, sx, entry);
+    }
+    else if (!sx_cashflow_entry_schedule_equal (entry, sx))
+    {
+        sx_cashflow_entry_reset_dates (entry, sx);
+    }
+    return entry;
+}
+
+/* Brings the occurrence dates of all the SXs up to the given julian
+ * day, on several threads if there are many to do. */
+static void
+sx_cashflow_extend_all (SxCashflowTask *tasks, guint n_tasks, guint32 until)
+{
+    guint n_threads = MIN (g_get_num_processors (), 8);
+    GThreadPool *pool = NULL;
+    guint i, n_pending = 0;
+
+    for (i = 0; i < n_tasks; i++)
+        if (!tasks[i].entry->dates_complete &&
+            g_array_index (tasks[i].entry->dates, guint32,
+                           tasks[i].entry->dates->len - 1) <= until)
+            ++n_pending;
+
+    if (n_pending >= SX_CASHFLOW_PARALLEL_MIN && n_threads > 1)
+        pool = g_thread_pool_new (sx_cashflow_extend_task, &until,
+                                  n_threads, FALSE, NULL);
+
+    for (i = 0; i < n_tasks; i++)
+    {
+        if (pool)
+            g_thread_pool_push (pool, &tasks[i], NULL);
+        else
+            sx_cashflow_extend_task (&tasks[i], &until);
+    }
+
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+static void
+cashflow_series_free (GncSxCashflowSeries *series)
+{
+    g_free (series->amounts);
+    g_free (series);
+}
+
+void
+gnc_sx_cashflow_series_list_free (GList *series)
+{
+    g_list_free_full (series, (GDestroyNotify) cashflow_series_free);
+}
+
+GList*
+gnc_sx_cashflow_project (GList *all_sxes,
+                         const GDate *range_starts, const GDate *range_ends,
+                         guint n_ranges, GList **creation_errors)
+{
+    SxCashflowCache *cache;
+    SxCashflowTask *tasks;
+    GHashTable *series_by_account;
+    GList *result = NULL;
+    guint n_tasks = 0, i, r;
+    guint32 until = 0;
+
+    if (!all_sxes || n_ranges == 0)
+        return NULL;
+
+    g_return_val_if_fail (range_starts && range_ends, NULL);
+
+    cache = sx_cashflow_cache_get (qof_instance_get_book (all_sxes->data));
+
+    tasks = g_new (SxCashflowTask, g_list_length (all_sxes));
+    for (GList *node = all_sxes; node; node = node->next, ++n_tasks)
+    {
+        g_assert (node->data);
+        tasks[n_tasks].sx = node->data;
+        tasks[n_tasks].entry = sx_cashflow_cache_lookup (cache, node->data);
+    }
+
+    for (r = 0; r < n_ranges; r++)
+        until = MAX (until, g_date_get_julian (&range_ends[r]));
+    sx_cashflow_extend_all (tasks, n_tasks, until);
+
+    series_by_account = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (i = 0; i < n_tasks; i++)
+    {
+        SchedXaction *sx = tasks[i].sx;
+        SxCashflowEntry *entry = tasks[i].entry;
+        Account *sx_template_account = NULL;
+
+        for (r = 0; r < n_ranges; r++)
+        {
+            /* How often does this particular SX occur in the date range? */
+            gint count = sx_cashflow_entry_count (entry, sx, &range_starts[r],
+                                                  &range_ends[r]);
+            gnc_numeric count_num;
+
+            if (count <= 0)
+                continue;
+
+            /* If it occurs at least once, calculate ("instantiate") its
+             * cash flow and add it to the result. */
+            if (!sx_template_account)
+            {
+                sx_template_account = gnc_sx_get_template_transaction_account (sx);
+                if (!sx_template_account)
+                {
+                    g_critical("Huh? No template account for the SX %s", xaccSchedXactionGetName(sx));
+                    break;
+                }
+
+                if (!xaccSchedXactionGetEnabled(sx))
+                {
+                    DEBUG("Skipping non-enabled SX [%s]",
+                            xaccSchedXactionGetName(sx));
+                    break;
+                }
+
+                sx_cashflow_entry_eval_splits (cache, entry, sx, sx_template_account);
+                if (creation_errors)
+                    for (GList *err = entry->split_errors; err; err = err->next)
+                        *creation_errors = g_list_append (*creation_errors,
+                                                          g_strdup (err->data));
+            }
+
+            count_num = gnc_numeric_create (count, 1);
+            for (guint j = 0; j < entry->splits->len; j++)
+            {
+                SxCashflowSplit *split = &g_array_index (entry->splits, SxCashflowSplit, j);
+                GncSxCashflowSeries *series;
+                gint gncn_error;
+
+                /* Multiply with the count factor. */
+                gnc_numeric final = gnc_numeric_mul(split->amount, count_num,
+                                                    gnc_numeric_denom(split->amount),
+                                                    GNC_HOW_RND_ROUND_HALF_UP);
+
+                gncn_error = gnc_numeric_check(final);
+                if (gncn_error != GNC_ERROR_OK)
+                {
+                    gchar* err = N_("Error %d in SX [%s] final gnc_numeric value, using 0 instead.");
+                    REPORT_ERROR(creation_errors, err,
+                                 gncn_error, xaccSchedXactionGetName(sx));
+                    final = gnc_numeric_zero();
+                }
+
+                series = g_hash_table_lookup (series_by_account, split->account);
+                if (!series)
+                {
+                    series = g_new0 (GncSxCashflowSeries, 1);
+                    series->account = split->account;
+                    series->amounts = g_new (gnc_numeric, n_ranges);
+                    for (guint k = 0; k < n_ranges; k++)
+                        series->amounts[k] = gnc_numeric_zero ();
+                    g_hash_table_insert (series_by_account, (gpointer) split->account, series);
+                    result = g_list_prepend (result, series);
+                }
+
+                /* And add the resulting value to the series */
+                add_cashflow_amount (&series->amounts[r],
+                                     xaccAccountGetGUID (split->account), &final);
+            }
+        }
+    }
+
+    g_hash_table_destroy (series_by_account);
+    g_free (tasks);
+    return g_list_reverse (result);
 }
 
 void gnc_sx_all_instantiate_cashflow(GList *all_sxes,
                                      const GDate *range_start, const GDate *range_end,
                                      GHashTable* map, GList **creation_errors)
 {
-    SxAllCashflow userdata;
-    userdata.hash = map;
-    userdata.creation_errors = creation_errors;
-    userdata.range_start = range_start;
-    userdata.range_end = range_end;
+    GList *series = gnc_sx_cashflow_project (all_sxes, range_start, range_end,
+                                             1, creation_errors);
 
-    /* The work is done in the callback for each SX */
-    g_list_foreach(all_sxes, instantiate_cashflow_cb, &userdata);
+    for (GList *node = series; node; node = node->next)
+    {
+        GncSxCashflowSeries *account_series = node->data;
+        add_to_hash_amount (map, xaccAccountGetGUID (account_series->account),
+                            &account_series->amounts[0]);
+    }
+    gnc_sx_cashflow_series_list_free (series);
 }
 
 
@@ -222,6 +222,38 @@ void gnc_sx_all_instantiate_cashflow(GList *all_sxes,
  * g_hash_table_destroy. */
 GHashTable* gnc_sx_all_instantiate_cashflow_all(GDate range_start, GDate range_end);
 
+/** The projected cash flow of scheduled transactions into one account:
+ * an amount for each of the date ranges the projection was made over. */
+typedef struct
+{
+    const Account *account;
+    gnc_numeric *amounts;
+} GncSxCashflowSeries;
+
+/** Projects the cash flow of all given SXs (in the given
+ * GList<SchedXAction*>) over n_ranges date ranges, the ith one from
+ * range_starts[i] to range_ends[i].  Each SX is counted with
+ * multiplicity as it has occurrences in each date range, as in
+ * gnc_sx_all_instantiate_cashflow().
+ *
+ * The occurrence dates and template amounts of each SX are cached with
+ * its book and reused until the SX's schedule or its template
+ * transactions change, so repeated projections are cheap.  Occurrence
+ * dates are computed on several threads when many SXs need them.
+ *
+ * The creation_errors list, if non-NULL, receives any errors that
+ * occurred, as in gnc_sx_all_instantiate_cashflow().
+ *
+ * @return A GList<GncSxCashflowSeries*> with one element for each
+ * account that an SX occurring in any of the ranges flows into.  It
+ * must be freed with gnc_sx_cashflow_series_list_free(). */
+GList* gnc_sx_cashflow_project(GList *all_sxes,
+                               const GDate *range_starts, const GDate *range_ends,
+                               guint n_ranges, GList **creation_errors);
+
+/** Frees a list returned by gnc_sx_cashflow_project(). */
+void gnc_sx_cashflow_series_list_free(GList *series);
+
 /** Returns the list of GncSxInstances in the model
  * (Each element in the list has type GncSxInstances)
  *
@@ -23,6 +23,8 @@
 #include <libguile.h>
 
 #include <stdlib.h>
+#include <map>
+#include <vector>
 #include "SX-book.h"
 #include "SX-ttinfo.hpp"
 #include "gnc-date.h"
@@ -296,6 +298,118 @@ make_one_empty_transaction_with_txcurr(SchedXaction *sx)
     make_one_transaction_with_two_splits(sx, "", "", TRUE);
 }
 
+struct CashflowSx
+{
+    SchedXaction *sx;
+    Account *debit;
+    Account *credit;
+};
+
+static void
+check_cashflow_projection(const std::vector<CashflowSx>& sxes, GList *sx_list,
+                          const GDate *starts, const GDate *ends, guint n_ranges,
+                          const char *name)
+{
+    std::map<const Account*, std::vector<gnc_numeric>> expected;
+    auto add = [&](const Account *account, guint r, gint64 amount)
+    {
+        auto& amounts = expected[account];
+        if (amounts.empty())
+            amounts.assign(n_ranges, gnc_numeric_zero());
+        amounts[r] = gnc_numeric_add(amounts[r], gnc_numeric_create(amount, 1),
+                                     GNC_DENOM_AUTO,
+                                     GNC_HOW_DENOM_REDUCE | GNC_HOW_RND_NEVER);
+    };
+
+    for (auto& cf : sxes)
+        for (guint r = 0; r < n_ranges; r++)
+        {
+            gint count = gnc_sx_get_num_occur_daterange(cf.sx, &starts[r], &ends[r]);
+            if (count <= 0)
+                continue;
+            add(cf.debit, r, 123 * count);
+            add(cf.credit, r, -123 * count);
+        }
+
+    GList *series = gnc_sx_cashflow_project(sx_list, starts, ends, n_ranges, NULL);
+    gboolean match = g_list_length(series) == expected.size();
+    for (GList *node = series; node; node = node->next)
+    {
+        auto account_series = static_cast<GncSxCashflowSeries*>(node->data);
+        auto it = expected.find(account_series->account);
+        if (it == expected.end())
+        {
+            match = FALSE;
+            continue;
+        }
+        for (guint r = 0; r < n_ranges; r++)
+            if (!gnc_numeric_equal(account_series->amounts[r], it->second[r]))
+                match = FALSE;
+    }
+    do_test_args(match, "Projected cash flow", __FILE__, __LINE__, "for %s", name);
+    gnc_sx_cashflow_series_list_free(series);
+}
+
+static void
+test_cashflow_projection()
+{
+    const int n_sxes = 100;
+    std::vector<CashflowSx> sxes;
+    GList *sx_list = NULL;
+    GDate today, starts[3], ends[3], end_date;
+
+    g_date_clear(&today, 1);
+    gnc_gdate_set_today(&today);
+
+    /* The next ten days, the twenty after them, and yesterday */
+    starts[0] = ends[0] = today;
+    g_date_add_days(&ends[0], 9);
+    starts[1] = ends[1] = today;
+    g_date_add_days(&starts[1], 10);
+    g_date_add_days(&ends[1], 29);
+    starts[2] = ends[2] = today;
+    g_date_subtract_days(&starts[2], 1);
+    g_date_subtract_days(&ends[2], 1);
+
+    for (int i = 0; i < n_sxes; i++)
+    {
+        TTInfoPtr tti;
+        CashflowSx cf;
+        GDate start = today;
+
+        g_date_subtract_days(&start, i % 5);
+        cf.sx = add_daily_sx("cashflow", &start, NULL, NULL);
+
+        make_one_transaction_begin(tti, &cf.debit, &cf.credit);
+        TTSplitInfoPtr split1 = std::make_shared<TTSplitInfo>();
+        TTSplitInfoPtr split2 = std::make_shared<TTSplitInfo>();
+        split1->set_account(cf.debit);
+        split1->set_debit_formula("123");
+        tti->append_template_split(split1);
+        split2->set_account(cf.credit);
+        split2->set_credit_formula("123");
+        tti->append_template_split(split2);
+        make_one_transaction_end(tti, cf.sx);
+
+        sxes.push_back(cf);
+        sx_list = g_list_prepend(sx_list, cf.sx);
+    }
+    sx_list = g_list_reverse(sx_list);
+
+    check_cashflow_projection(sxes, sx_list, starts, ends, 3, "new SXs");
+    check_cashflow_projection(sxes, sx_list, starts, ends, 3, "cached SXs");
+
+    /* A changed schedule mustn't use the cached dates */
+    end_date = today;
+    g_date_add_days(&end_date, 4);
+    xaccSchedXactionSetEndDate(sxes[0].sx, &end_date);
+    check_cashflow_projection(sxes, sx_list, starts, ends, 3, "changed SX");
+
+    g_list_free(sx_list);
+    for (auto& cf : sxes)
+        remove_sx(cf.sx);
+}
+
 static void
 test_auto_create_transactions(const char *name, void (*populate_sx)(SchedXaction*), unsigned int expected_txns)
 {
@@ -351,6 +465,7 @@ real_main(void *closure, int argc, char **argv)
     }
     test_basic();
     test_state_changes();
+    test_cashflow_projection();
 
     test_auto_create_transactions("make_one_transaction", make_one_transaction, 1);
     test_auto_create_transactions("make_one_zero_transaction", make_one_zero_transaction, 1);
@@ -951,6 +951,8 @@ GncDbiBackend<Type>::safe_sync (QofBook* book)
     g_return_if_fail (book != nullptr);
 
     ENTER ("book=%p, primary=%p", book, m_book);
+    /* The tables are recreated, so first load what a partial load left out. */
+    load_older (nullptr, INT64_MIN);
     if (!conn->begin_transaction())
     {
         LEAVE("Failed to obtain a transaction.");
@@ -994,6 +996,8 @@ GncDbiBackend<DbType::DBI_MYSQL>::safe_sync (QofBook* book)
     g_return_if_fail (book != nullptr);
 
     ENTER ("book=%p, primary=%p", book, m_book);
+    /* The tables are recreated, so first load what a partial load left out. */
+    load_older (nullptr, INT64_MIN);
     if (!conn->table_operation (TableOpType::backup))
     {
         set_error(ERR_BACKEND_SERVER_ERR);
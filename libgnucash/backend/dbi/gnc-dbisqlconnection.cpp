@@ -85,7 +85,7 @@ GncDbiSqlConnection::GncDbiSqlConnection (DbType type, QofBackend* qbe,
             make_dbi_provider<DbType::DBI_MYSQL>() :
             make_dbi_provider<DbType::DBI_PGSQL>()},
     m_conn_ok{true}, m_last_error{ERR_BACKEND_NO_ERR}, m_error_repeat{0},
-    m_retry{false}, m_sql_savepoint{0}, m_readonly{false}
+    m_retry{false}, m_sql_savepoint{0}, m_readonly{false}, m_type{type}
 {
     if (mode == SESSION_READ_ONLY)
         m_readonly = true;
@@ -282,19 +282,108 @@ GncDbiSqlConnection::execute_select_statement (const GncSqlStatementPtr& stmt)
 int
 GncDbiSqlConnection::execute_nonselect_statement (const GncSqlStatementPtr& stmt)
     noexcept
+{
+    return execute_nonselect_sql (stmt->to_sql());
+}
+
+bool
+GncDbiSqlConnection::insert_rows (const std::string& table_name,
+                                  const StrVec& columns,
+                                  const std::vector<StrVec>& rows) noexcept
+{
+    if (rows.empty())
+        return true;
+
+    std::string sql{"INSERT INTO " + table_name + "("};
+    for (auto const& col : columns)
+    {
+        if (&col != &columns.front())
+            sql += ",";
+        sql += col;
+    }
+    sql += ") VALUES";
+    for (auto const& row : rows)
+    {
+        sql += &row == &rows.front() ? "(" : ",(";
+        for (auto const& value : row)
+        {
+            if (&value != &row.front())
+                sql += ",";
+            sql += value;
+        }
+        sql += ")";
+    }
+    return execute_nonselect_sql (sql.c_str()) != -1;
+}
+
+bool
+GncDbiSqlConnection::can_upsert () const noexcept
+{
+    if (m_can_upsert < 0)
+    {
+        /* PostgreSQL gained ON CONFLICT in 9.5; SQLite and MySQL have
+         * always had INSERT OR REPLACE and ON DUPLICATE KEY UPDATE. */
+        m_can_upsert = m_type != DbType::DBI_PGSQL ||
+            dbi_conn_get_engine_version (m_conn) >= 90500;
+    }
+    return m_can_upsert;
+}
+
+bool
+GncDbiSqlConnection::upsert_row (const std::string& table_name,
+                                 const StrVec& columns,
+                                 const StrVec& values) noexcept
+{
+    g_return_val_if_fail (!columns.empty() && columns.size() == values.size(),
+                          false);
+
+    std::string sql{m_type == DbType::DBI_SQLITE ? "INSERT OR REPLACE INTO " :
+                    "INSERT INTO "};
+    sql += table_name + "(";
+    for (auto const& col : columns)
+    {
+        if (&col != &columns.front())
+            sql += ",";
+        sql += col;
+    }
+    sql += ") VALUES(";
+    for (auto const& value : values)
+    {
+        if (&value != &values.front())
+            sql += ",";
+        sql += value;
+    }
+    sql += ")";
+    if (m_type != DbType::DBI_SQLITE)
+    {
+        sql += m_type == DbType::DBI_MYSQL ? " ON DUPLICATE KEY UPDATE " :
+            " ON CONFLICT (" + columns.front() + ") DO UPDATE SET ";
+        for (auto const& col : columns)
+        {
+            if (&col != &columns.front())
+                sql += ",";
+            sql += col + (m_type == DbType::DBI_MYSQL ? "=VALUES(" + col + ")" :
+                          "=EXCLUDED." + col);
+        }
+    }
+    return execute_nonselect_sql (sql.c_str()) != -1;
+}
+
+int
+GncDbiSqlConnection::execute_nonselect_sql (const char* sql) noexcept
 {
     dbi_result result;
 
-    DEBUG ("SQL: %s\n", stmt->to_sql());
+    DEBUG ("SQL: %s\n", sql);
     do
     {
         init_error ();
-        result = dbi_conn_query (m_conn, stmt->to_sql());
+        result = dbi_conn_query (m_conn, sql);
     }
     while (m_retry);
     if (result == nullptr && m_last_error)
     {
-        PERR ("Error executing SQL %s\n", stmt->to_sql());
+        PERR ("Error executing SQL %s\n", sql);
         if(m_last_error)
             m_qbe->set_error(m_last_error);
         else
@@ -50,6 +50,11 @@ public:
         noexcept override;
     GncSqlStatementPtr create_statement_from_sql (const std::string&)
         const noexcept override;
+    bool insert_rows (const std::string&, const StrVec&,
+                      const std::vector<StrVec>&) noexcept override;
+    bool can_upsert () const noexcept override;
+    bool upsert_row (const std::string&, const StrVec&,
+                     const StrVec&) noexcept override;
     bool does_table_exist (const std::string&) const noexcept override;
     bool begin_transaction () noexcept override;
     bool rollback_transaction () noexcept override;
@@ -109,12 +114,16 @@ private:
     bool m_retry;
     unsigned int m_sql_savepoint;
     bool m_readonly; 
+    DbType m_type;
+    /** Whether the server understands INSERT ... ON CONFLICT; -1 until asked */
+    mutable int m_can_upsert = -1;
     bool lock_database(bool break_lock);
     void unlock_database();
     bool rename_table(const std::string& old_name, const std::string& new_name);
     bool drop_table(const std::string& table);
     bool merge_tables(const std::string& table, const std::string& other);
     bool check_and_rollback_failed_save();
+    int execute_nonselect_sql (const char* sql) noexcept;
 };
 
 #endif //_GNC_DBISQLCONNECTION_HPP_
@@ -42,6 +42,8 @@
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
+#include "Query.h"
+#include "Scrub.h"
 #include "gnc-commodity.h"
 #include "gncAddress.h"
 #include "gncCustomer.h"
@@ -162,6 +164,66 @@ setup_memory (Fixture* fixture, gconstpointer pData)
         fixture->filename = NULL;
 }
 
+static void
+add_history_txn (QofBook* book, gnc_commodity* currency, Account* to,
+                 Account* from, gint64 amount, time64 posted, char reconciled)
+{
+    auto tx = xaccMallocTransaction (book);
+    xaccTransBeginEdit (tx);
+    xaccTransSetCurrency (tx, currency);
+    xaccTransSetDatePostedSecsNormalized (tx, posted);
+    auto spl1 = xaccMallocSplit (book);
+    xaccSplitSetAccount (spl1, to);
+    xaccSplitSetValue (spl1, gnc_numeric_create (amount, 100));
+    xaccSplitSetAmount (spl1, gnc_numeric_create (amount, 100));
+    xaccSplitSetReconcile (spl1, reconciled);
+    xaccTransAppendSplit (tx, spl1);
+    auto spl2 = xaccMallocSplit (book);
+    xaccSplitSetAccount (spl2, from);
+    xaccSplitSetValue (spl2, gnc_numeric_create (-amount, 100));
+    xaccSplitSetAmount (spl2, gnc_numeric_create (-amount, 100));
+    xaccTransAppendSplit (tx, spl2);
+    xaccTransCommitEdit (tx);
+}
+
+/* Two accounts with transactions from two years ago and from today. */
+static void
+setup_history (Fixture* fixture, gconstpointer pData)
+{
+    gchar* url = (gchar*)pData;
+    auto book = qof_book_new ();
+    auto session = qof_session_new (book);
+
+    gnc_module_init_backend_dbi ();
+    auto root = gnc_book_get_root_account (book);
+    auto table = gnc_commodity_table_get_table (book);
+    auto currency = gnc_commodity_table_lookup (table,
+                                                GNC_COMMODITY_NS_CURRENCY,
+                                                "CAD");
+    auto acct1 = xaccMallocAccount (book);
+    xaccAccountSetType (acct1, ACCT_TYPE_BANK);
+    xaccAccountSetName (acct1, "Bank 1");
+    xaccAccountSetCommodity (acct1, currency);
+    gnc_account_append_child (root, acct1);
+    auto acct2 = xaccMallocAccount (book);
+    xaccAccountSetType (acct2, ACCT_TYPE_INCOME);
+    xaccAccountSetName (acct2, "Income");
+    xaccAccountSetCommodity (acct2, currency);
+    gnc_account_append_child (root, acct2);
+
+    auto now = gnc_time (nullptr);
+    auto old = now - 2 * 365 * 24 * 3600;
+    add_history_txn (book, currency, acct1, acct2, 10000, old, YREC);
+    add_history_txn (book, currency, acct1, acct2, 5025, old + 3600, CREC);
+    add_history_txn (book, currency, acct1, acct2, 1000, now, NREC);
+
+    fixture->session = session;
+    if (g_strcmp0 (url, "sqlite3") == 0)
+        fixture->filename = g_strdup_printf ("/tmp/test-sqlite-%d", getpid ());
+    else
+        fixture->filename = NULL;
+}
+
 static void
 setup_business (Fixture* fixture, gconstpointer pData)
 {
@@ -419,6 +481,289 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+static void
+check_history_balances (Account* acct)
+{
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (acct),
+                                      gnc_numeric_create (16025, 100)));
+    g_assert_true (gnc_numeric_equal (xaccAccountGetClearedBalance (acct),
+                                      gnc_numeric_create (15025, 100)));
+    g_assert_true (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct),
+                                      gnc_numeric_create (10000, 100)));
+}
+
+/* Save a session and reload it with only the last month of transactions. */
+static QofSession*
+save_and_load_recent (QofSession* session, const gchar* url,
+                      SessionOpenMode mode = SESSION_READ_ONLY)
+{
+    auto book2{qof_book_new()};
+    auto session_2 = qof_session_new (book2);
+    qof_session_begin (session_2, url, SESSION_NEW_OVERWRITE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (session, session_2);
+    qof_book_mark_session_dirty (qof_session_get_book (session_2));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+
+    gnc_prefs_set_sql_lazy_load_months (1);
+    auto book3{qof_book_new()};
+    auto session_3 = qof_session_new (book3);
+    qof_session_begin (session_3, url, mode);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    gnc_prefs_set_sql_lazy_load_months (0);
+    return session_3;
+}
+
+/* Reload a saved session with only the last month of transactions, check
+ * that the balances include the others anyway, then load those. */
+static void
+test_dbi_lazy_load (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_3 = save_and_load_recent (fixture->session, url);
+    auto book = qof_session_get_book (session_3);
+    auto root = gnc_book_get_root_account (book);
+    auto bank = gnc_account_lookup_by_name (root, "Bank 1");
+    auto income = gnc_account_lookup_by_name (root, "Income");
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 1);
+    g_assert_cmpint (xaccAccountGetSplitsSize (bank), ==, 1);
+    check_history_balances (bank);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (income),
+                                      gnc_numeric_create (-16025, 100)));
+
+    qof_backend_load_older (qof_book_get_backend (book), QOF_INSTANCE (bank),
+                            INT64_MIN);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 3);
+    g_assert_cmpint (xaccAccountGetSplitsSize (bank), ==, 3);
+    check_history_balances (bank);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalance (income),
+                                      gnc_numeric_create (-16025, 100)));
+    g_assert_false (qof_book_session_not_saved (book));
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Balances as of a date before the initial load's cutoff load the
+ * transactions from that date on; those before it stay in the starting
+ * balance. */
+static void
+test_dbi_lazy_balance_as_of_date (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_3 = save_and_load_recent (fixture->session, url);
+    auto book = qof_session_get_book (session_3);
+    auto root = gnc_book_get_root_account (book);
+    auto bank = gnc_account_lookup_by_name (root, "Bank 1");
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+    auto now = gnc_time (nullptr);
+    auto old = now - 2 * 365 * 24 * 3600;
+
+    /* Nothing loaded is before last week, so it's all starting balance. */
+    auto last_week = now - 7 * 24 * 3600;
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (bank, last_week),
+                                      gnc_numeric_create (15025, 100)));
+    g_assert_true (gnc_numeric_equal (xaccAccountGetReconciledBalanceAsOfDate (bank, last_week),
+                                      gnc_numeric_create (10000, 100)));
+    g_assert_cmpint (qof_collection_count (transactions), ==, 1);
+
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (bank, old + 1800),
+                                      gnc_numeric_create (10000, 100)));
+    g_assert_cmpint (qof_collection_count (transactions), ==, 2);
+    g_assert_true (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (bank, old - 1),
+                                      gnc_numeric_zero ()));
+    g_assert_cmpint (qof_collection_count (transactions), ==, 3);
+    check_history_balances (bank);
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Scrubbing an account needs all of its splits. */
+static void
+test_dbi_lazy_scrub (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_3 = save_and_load_recent (fixture->session, url,
+                                           SESSION_NORMAL_OPEN);
+    auto book = qof_session_get_book (session_3);
+    auto root = gnc_book_get_root_account (book);
+    auto bank = gnc_account_lookup_by_name (root, "Bank 1");
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+    g_assert_cmpint (xaccAccountGetSplitsSize (bank), ==, 1);
+
+    xaccAccountScrubSplits (bank);
+    g_assert_cmpint (xaccAccountGetSplitsSize (bank), ==, 3);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 3);
+    check_history_balances (bank);
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Deleting an account must take the splits the initial load left out with
+ * it. */
+static void
+test_dbi_lazy_delete (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_3 = save_and_load_recent (fixture->session, url,
+                                           SESSION_NORMAL_OPEN);
+    auto book = qof_session_get_book (session_3);
+    auto root = gnc_book_get_root_account (book);
+    auto bank = gnc_account_lookup_by_name (root, "Bank 1");
+    auto income = gnc_account_lookup_by_name (root, "Income");
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 1);
+
+    xaccAccountBeginEdit (income);
+    xaccAccountDestroy (income);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 3);
+    g_assert_cmpint (xaccAccountGetSplitsSize (bank), ==, 3);
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* A register or search loads the transactions its query can match: those
+ * of its accounts from its start date on. */
+static void
+test_dbi_lazy_query_history (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_3 = save_and_load_recent (fixture->session, url);
+    auto book = qof_session_get_book (session_3);
+    auto root = gnc_book_get_root_account (book);
+    auto bank = gnc_account_lookup_by_name (root, "Bank 1");
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+    auto old = gnc_time (nullptr) - 2 * 365 * 24 * 3600;
+    g_assert_cmpint (qof_collection_count (transactions), ==, 1);
+
+    auto query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, book);
+    xaccQueryAddSingleAccountMatch (query, bank, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (query, TRUE, old + 1800, FALSE, 0, QOF_QUERY_AND);
+    xaccQueryLoadHistory (query);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 2);
+    qof_query_destroy (query);
+
+    query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, book);
+    xaccQueryAddSingleAccountMatch (query, bank, QOF_QUERY_AND);
+    xaccQueryLoadHistory (query);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 3);
+    g_assert_cmpint (xaccAccountGetSplitsSize (bank), ==, 3);
+    check_history_balances (bank);
+    qof_query_destroy (query);
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Split queries are run by the database, which must find the transactions the
+ * initial load left out too. */
+static void
+test_dbi_split_query (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    auto msg = "[GncDbiSqlConnection::unlock_database()] There was no lock entry in the Lock table";
+    auto log_domain = nullptr;
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    auto session_3 = save_and_load_recent (fixture->session, url);
+    auto book = qof_session_get_book (session_3);
+    auto root = gnc_book_get_root_account (book);
+    auto bank = gnc_account_lookup_by_name (root, "Bank 1");
+    auto transactions = qof_book_get_collection (book, GNC_ID_TRANS);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 1);
+
+    auto query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, book);
+    xaccQueryAddSingleAccountMatch (query, bank, QOF_QUERY_AND);
+    qof_query_set_max_results (query, 1);
+    auto splits = qof_query_run (query);
+    g_assert_cmpint (g_list_length (splits), ==, 1);
+    g_assert_true (gnc_numeric_equal (xaccSplitGetValue (GNC_SPLIT (splits->data)),
+                                      gnc_numeric_create (1000, 100)));
+    g_assert_cmpint (qof_collection_count (transactions), ==, 1);
+
+    xaccQueryAddValueMatch (query, gnc_numeric_create (5000, 100),
+                            QOF_NUMERIC_MATCH_ANY, QOF_COMPARE_GTE,
+                            QOF_QUERY_AND);
+    qof_query_set_max_results (query, -1);
+    splits = qof_query_run (query);
+    g_assert_cmpint (g_list_length (splits), ==, 2);
+    g_assert_cmpint (qof_collection_count (transactions), ==, 3);
+    check_history_balances (bank);
+    g_assert_false (qof_book_session_not_saved (book));
+    qof_query_destroy (query);
+
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -646,6 +991,18 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
                   test_dbi_version_control, teardown);
     GNC_TEST_ADD (subsuite, "business_store_and_reload", Fixture, url,
                   setup_business, test_dbi_business_store_and_reload, teardown);
+    GNC_TEST_ADD (subsuite, "lazy_load", Fixture, url, setup_history,
+                  test_dbi_lazy_load, teardown);
+    GNC_TEST_ADD (subsuite, "lazy_balance_as_of_date", Fixture, url,
+                  setup_history, test_dbi_lazy_balance_as_of_date, teardown);
+    GNC_TEST_ADD (subsuite, "lazy_scrub", Fixture, url, setup_history,
+                  test_dbi_lazy_scrub, teardown);
+    GNC_TEST_ADD (subsuite, "lazy_delete", Fixture, url, setup_history,
+                  test_dbi_lazy_delete, teardown);
+    GNC_TEST_ADD (subsuite, "lazy_query_history", Fixture, url, setup_history,
+                  test_dbi_lazy_query_history, teardown);
+    GNC_TEST_ADD (subsuite, "split_query", Fixture, url, setup_history,
+                  test_dbi_split_query, teardown);
     g_free (subsuite);
 
 }
@@ -167,8 +167,7 @@ GncSqlCommodityBackend::load_all (GncSqlBackend* sql_be)
 }
 /* ================================================================= */
 static gboolean
-do_commit_commodity (GncSqlBackend* sql_be, QofInstance* inst,
-                     gboolean force_insert)
+do_commit_commodity (GncSqlBackend* sql_be, QofInstance* inst)
 {
     const GncGUID* guid;
     gboolean is_infant;
@@ -180,13 +179,15 @@ do_commit_commodity (GncSqlBackend* sql_be, QofInstance* inst,
     {
         op = OP_DB_DELETE;
     }
-    else if (sql_be->pristine() || is_infant || force_insert)
+    else if (sql_be->pristine() || is_infant)
     {
         op = OP_DB_INSERT;
     }
     else
     {
-        op = OP_DB_UPDATE;
+        /* Commodities are saved on demand by the objects using them, so
+         * one that isn't new may still be missing from the database. */
+        op = OP_DB_UPSERT;
     }
     is_ok = sql_be->do_db_operation(op, COMMODITIES_TABLE, GNC_ID_COMMODITY,
                                     inst, col_table);
@@ -214,8 +215,7 @@ GncSqlCommodityBackend::commit (GncSqlBackend* sql_be, QofInstance* inst)
     g_return_val_if_fail (sql_be != NULL, FALSE);
     g_return_val_if_fail (inst != NULL, FALSE);
     g_return_val_if_fail (GNC_IS_COMMODITY (inst), FALSE);
-    auto in_be = instance_in_db(sql_be, inst);
-    return do_commit_commodity (sql_be, inst, !in_be);
+    return do_commit_commodity (sql_be, inst);
 }
 
 /* ----------------------------------------------------------------- */
@@ -108,19 +108,19 @@ GncSqlPriceBackend::load_all (GncSqlBackend* sql_be)
             return;
 
         GNCPrice* pPrice;
+        PriceList* prices = NULL;
 
-        gnc_pricedb_set_bulk_update (pPriceDB, TRUE);
         for (auto row : *result)
         {
             pPrice = load_single_price (sql_be, row);
 
             if (pPrice != NULL)
-            {
-                (void)gnc_pricedb_add_price (pPriceDB, pPrice);
-                gnc_price_unref (pPrice);
-            }
+                prices = g_list_prepend (prices, pPrice);
         }
+        gnc_pricedb_set_bulk_update (pPriceDB, TRUE);
+        (void)gnc_pricedb_add_prices (pPriceDB, prices);
         gnc_pricedb_set_bulk_update (pPriceDB, FALSE);
+        gnc_price_list_destroy (prices);
 	std::string pkey(col_table[0]->name());
         sql = "SELECT DISTINCT ";
 	sql += pkey + " FROM " TABLE_NAME;
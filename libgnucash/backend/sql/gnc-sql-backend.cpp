@@ -30,6 +30,7 @@
 #include <gncTaxTable.h>
 #include <gncInvoice.h>
 #include <gnc-pricedb.h>
+#include <guid.hpp>
 
 #include <algorithm>
 #include <cassert>
@@ -69,6 +70,13 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 
 using StrVec = std::vector<std::string>;
 
+/* Queued INSERTs for a table are written once there are this many rows, which
+ * keeps below the 500-row limit older SQLite versions put on VALUES lists, or
+ * once their text is this long, well within MySQL's default max_allowed_packet.
+ */
+static const size_t INSERT_BATCH_MAX_ROWS = 250;
+static const size_t INSERT_BATCH_MAX_LENGTH = 512 * 1024;
+
 static std::string empty_string{};
 static EntryVec version_table
 {
@@ -93,6 +101,10 @@ GncSqlBackend::~GncSqlBackend()
 void
 GncSqlBackend::connect(GncSqlConnection *conn) noexcept
 {
+    discard_insert_batches();
+    forget_persisted_keys();
+    end_group (false);
+    m_group_level = 0;
     if (m_conn != nullptr && m_conn != conn)
         delete m_conn;
     finalize_version_info();
@@ -113,6 +125,13 @@ GncSqlBackend::create_statement_from_sql(const std::string& str) const noexcept
 
 GncSqlResultPtr
 GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const noexcept
+{
+    flush_insert_batches();
+    return run_select_statement(stmt);
+}
+
+GncSqlResultPtr
+GncSqlBackend::run_select_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
     auto result = m_conn ? m_conn->execute_select_statement(stmt) : nullptr;
     if (result == nullptr)
@@ -126,6 +145,8 @@ GncSqlBackend::execute_select_statement(const GncSqlStatementPtr& stmt) const no
 int
 GncSqlBackend::execute_nonselect_statement(const GncSqlStatementPtr& stmt) const noexcept
 {
+    if (!flush_insert_batches())
+        return -1;
     int result = m_conn ? m_conn->execute_nonselect_statement(stmt) : -1;
     if (result == -1)
     {
@@ -295,6 +316,18 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
         assert (m_book == nullptr);
         m_book = book;
 
+        m_history_cutoff = INT64_MIN;
+        m_history_loaded.clear();
+        auto months = gnc_prefs_get_sql_lazy_load_months ();
+        if (months > 0)
+        {
+            GDate date;
+            gnc_gdate_set_today (&date);
+            g_date_set_day (&date, 1);
+            g_date_subtract_months (&date, months);
+            m_history_cutoff = gnc_time64_get_day_start_gdate (&date);
+        }
+
         auto num_types = m_backend_registry.size();
         auto num_done = 0;
 
@@ -332,8 +365,15 @@ GncSqlBackend::load (QofBook* book, QofBackendLoadType loadType)
     else if (loadType == LOAD_TYPE_LOAD_ALL)
     {
         // Load all transactions
-        auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
-        obe->load_all (this);
+        if (m_history_cutoff != INT64_MIN)
+        {
+            load_older (nullptr, INT64_MIN);
+        }
+        else
+        {
+            auto obe = m_backend_registry.get_object_backend (GNC_ID_TRANS);
+            obe->load_all (this);
+        }
     }
 
     m_loading = FALSE;
@@ -398,7 +438,7 @@ GncSqlBackend::write_accounts()
         is_ok = write_account_tree (gnc_book_get_template_root(m_book));
     }
 
-    return is_ok;
+    return is_ok && flush_insert_batches();
 }
 
 static gboolean // Can't be bool because of signature for xaccAccountTreeForEach
@@ -430,7 +470,7 @@ GncSqlBackend::write_transactions()
     (void)xaccAccountTreeForEachTransaction (
         gnc_book_get_root_account (m_book), write_tx, &data);
     update_progress(101.0);
-    return data.is_ok;
+    return data.is_ok && flush_insert_batches();
 }
 
 bool
@@ -468,12 +508,63 @@ GncSqlBackend::write_schedXactions()
     return is_ok;
 }
 
+void
+GncSqlBackend::load_older (QofInstance* inst, time64 since)
+{
+    if (m_history_cutoff == INT64_MIN || m_book == nullptr)
+        return;
+    if (inst != nullptr && !GNC_IS_ACCOUNT (inst))
+        return;
+
+    auto acct = inst ? GNC_ACCOUNT (inst) : nullptr;
+    auto until = m_history_cutoff;
+    if (acct != nullptr)
+    {
+        auto loaded = m_history_loaded.find (acct);
+        if (loaded != m_history_loaded.end())
+            until = loaded->second;
+    }
+    if (since >= until)
+        return;
+
+    ENTER ("acct=%p, since=%" G_GINT64_FORMAT, acct, since);
+    auto was_loading = m_loading;
+    auto was_saved = !qof_book_session_not_saved (m_book);
+    m_loading = true;
+    gnc_sql_transaction_load_history (this, acct, since, until);
+    m_loading = was_loading;
+    if (was_saved)
+        qof_book_mark_session_saved (m_book);
+
+    if (acct != nullptr)
+    {
+        m_history_loaded[acct] = since;
+    }
+    else if (since == INT64_MIN)
+    {
+        m_history_cutoff = INT64_MIN;
+        m_history_loaded.clear();
+    }
+    else
+    {
+        /* Everything since is loaded now, so that's the new cutoff. */
+        m_history_cutoff = since;
+        for (auto it = m_history_loaded.begin(); it != m_history_loaded.end();)
+            it = it->second >= since ? m_history_loaded.erase (it) : ++it;
+    }
+    LEAVE ("");
+}
+
 void
 GncSqlBackend::sync(QofBook* book)
 {
     g_return_if_fail (book != NULL);
     g_return_if_fail (m_conn != nullptr);
 
+    /* Everything is written anew, so first load what a partial load left
+     * out. */
+    if (book == m_book)
+        load_older (nullptr, INT64_MIN);
     reset_version_info();
     ENTER ("book=%p, sql_be->book=%p", book, m_book);
     update_progress(101.0);
@@ -484,7 +575,11 @@ GncSqlBackend::sync(QofBook* book)
 
     /* Save all contents */
     m_book = book;
+    forget_persisted_keys();
     auto is_ok = m_conn->begin_transaction();
+    /* Everything written is new, so write the rows of each table in as few
+     * statements as possible. */
+    m_batch_inserts = true;
 
     // FIXME: should write the set of commodities that are used
     // write_commodities(sql_be, book);
@@ -515,6 +610,11 @@ GncSqlBackend::sync(QofBook* book)
             std::get<1>(entry)->write (this);
     }
     if (is_ok)
+    {
+        is_ok = flush_insert_batches();
+    }
+    m_batch_inserts = false;
+    if (is_ok)
     {
         is_ok = m_conn->commit_transaction();
     }
@@ -530,6 +630,8 @@ GncSqlBackend::sync(QofBook* book)
     else
     {
         set_error (ERR_BACKEND_SERVER_ERR);
+        discard_insert_batches();
+        forget_persisted_keys();
         m_conn->rollback_transaction ();
     }
     finish_progress();
@@ -542,19 +644,145 @@ GncSqlBackend::sync(QofBook* book)
 void
 GncSqlBackend::begin(QofInstance* inst)
 {
-    //g_return_if_fail (inst != NULL);
+    g_return_if_fail (inst != NULL);
 
-    //ENTER (" ");
-    //LEAVE ("");
+    if (m_loading || !GNC_IS_TRANSACTION (inst))
+        return;
+    m_open_transactions.push_back (*qof_instance_get_guid (inst));
 }
 
 void
 GncSqlBackend::rollback(QofInstance* inst)
 {
-    //g_return_if_fail (inst != NULL);
+    g_return_if_fail (inst != NULL);
+
+    forget_open_transaction (inst);
+}
+
+void
+GncSqlBackend::forget_open_transaction(QofInstance* inst) noexcept
+{
+    if (m_open_transactions.empty() || !GNC_IS_TRANSACTION (inst))
+        return;
+    auto guid = qof_instance_get_guid (inst);
+    auto it = std::find (m_open_transactions.begin(),
+                         m_open_transactions.end(), *guid);
+    if (it != m_open_transactions.end())
+        m_open_transactions.erase (it);
+}
+
+std::vector<Transaction*>
+GncSqlBackend::open_transactions() noexcept
+{
+    std::vector<Transaction*> open;
+    for (auto it = m_open_transactions.begin();
+         it != m_open_transactions.end();)
+    {
+        auto tx = xaccTransLookup (&*it, m_book);
+        if (tx != nullptr && xaccTransIsOpen (tx))
+        {
+            open.push_back (tx);
+            ++it;
+        }
+        else
+        {
+            it = m_open_transactions.erase (it);
+        }
+    }
+    return open;
+}
+
+void*
+GncSqlBackend::compile_query(QofQuery* query)
+{
+    auto type = qof_query_get_search_for (query);
+    if (type == nullptr || m_conn == nullptr)
+        return nullptr;
+    auto obe = m_backend_registry.get_object_backend (type);
+    if (obe == nullptr)
+        return nullptr;
+    return obe->compile_query (this, query).release();
+}
+
+bool
+GncSqlBackend::run_query(void* compiled, std::vector<QofInstance*>& candidates)
+{
+    g_return_val_if_fail (compiled != nullptr, false);
+
+    /* Objects created during a load are found by the engine alone. */
+    if (m_loading || m_conn == nullptr)
+        return false;
+
+    ENTER (" ");
+    auto was_saved = !qof_book_session_not_saved (m_book);
+    m_loading = m_in_query = true;
+    auto is_ok = static_cast<GncSqlQuery*>(compiled)->run (this, candidates);
+    m_loading = m_in_query = false;
+    if (was_saved)
+        qof_book_mark_session_saved (m_book);
+    LEAVE ("%s, %zu candidates", is_ok ? "ok" : "failed", candidates.size());
+    return is_ok;
+}
+
+void
+GncSqlBackend::free_query(void* compiled)
+{
+    delete static_cast<GncSqlQuery*>(compiled);
+}
+
+void
+GncSqlBackend::begin_group_commit()
+{
+    if (m_group_level++ > 0 || m_conn == nullptr || m_loading ||
+        qof_book_is_readonly (m_book))
+        return;
+    ENTER (" ");
+    m_group_open = m_conn->begin_transaction();
+    if (!m_group_open)
+        PERR ("begin_transaction failed, committing objects separately\n");
+    LEAVE ("");
+}
+
+bool
+GncSqlBackend::end_group_commit()
+{
+    g_return_val_if_fail (m_group_level > 0, false);
+    if (--m_group_level > 0 || !m_group_open)
+        return true;
+    ENTER (" ");
+    auto is_ok = m_conn->commit_transaction();
+    if (!is_ok)
+    {
+        PERR ("Group commit failed, rolling it back\n");
+        (void)m_conn->rollback_transaction();
+        forget_persisted_keys();
+        set_error (ERR_BACKEND_SERVER_ERR);
+    }
+    end_group (is_ok);
+    LEAVE ("%s", is_ok ? "committed" : "rolled back");
+    return is_ok;
+}
 
-    //ENTER (" ");
-    //LEAVE ("");
+/* Release the objects committed in the group.  If the group's transaction
+ * didn't make it to the database they're marked dirty again, as they would
+ * be had their own commits failed. */
+void
+GncSqlBackend::end_group (bool committed) noexcept
+{
+    if (!m_group_open)
+        return;
+    m_group_open = false;
+    for (auto inst : m_group_instances)
+    {
+        if (!committed)
+            qof_instance_set_dirty (inst);
+        g_object_unref (inst);
+    }
+    m_group_instances.clear();
+    if (committed)
+        qof_book_mark_session_saved (m_book);
+    else
+        qof_book_mark_session_dirty (m_book);
 }
 
 void
@@ -583,6 +811,7 @@ GncSqlBackend::commit (QofInstance* inst)
     g_return_if_fail (inst != NULL);
     g_return_if_fail (m_conn != nullptr);
 
+    forget_open_transaction (inst);
     if (qof_book_is_readonly(m_book))
     {
         set_error (ERR_BACKEND_READONLY);
@@ -632,7 +861,17 @@ GncSqlBackend::commit (QofInstance* inst)
 
     auto obe = m_backend_registry.get_object_backend(std::string{inst->e_type});
     if (obe != nullptr)
-        is_ok = obe->commit(this, inst);
+    {
+        /* Send the object's rows and those of its splits, slots and so on
+         * together; anything queued by an enclosing commit goes first. */
+        auto batching = m_batch_inserts;
+        m_batch_inserts = true;
+        is_ok = flush_insert_batches() && obe->commit(this, inst) &&
+            flush_insert_batches();
+        m_batch_inserts = batching;
+        if (!is_ok)
+            discard_insert_batches();
+    }
     else
     {
         PERR ("Unknown object type '%s'\n", inst->e_type);
@@ -648,6 +887,7 @@ GncSqlBackend::commit (QofInstance* inst)
     {
         // Error - roll it back
         (void)m_conn->rollback_transaction();
+        forget_persisted_keys();
 
         // This *should* leave things marked dirty
         LEAVE ("Rolled back - database error");
@@ -656,8 +896,17 @@ GncSqlBackend::commit (QofInstance* inst)
 
     (void)m_conn->commit_transaction ();
 
-    qof_book_mark_session_saved(m_book);
     qof_instance_mark_clean (inst);
+    if (!m_group_open)
+    {
+        qof_book_mark_session_saved(m_book);
+    }
+    /* Only a destroyed object's rows can't be restored into the engine if
+     * the group fails; keep the others around to mark them dirty again. */
+    else if (!is_destroying && m_group_instances.insert(inst).second)
+    {
+        g_object_ref (inst);
+    }
 
     LEAVE ("");
 }
@@ -793,6 +1042,7 @@ GncSqlBackend::upgrade_table (const std::string& table_name,
                               const EntryVec& col_table) noexcept
 {
     DEBUG ("Upgrading %s table\n", table_name.c_str());
+    forget_persisted_keys();
 
     auto temp_table_name = table_name + "_new";
     create_table (temp_table_name, col_table);
@@ -836,20 +1086,80 @@ GncSqlBackend::object_in_db (const char* table_name, QofIdTypeConst obj_name,
     g_return_val_if_fail (obj_name != nullptr, false);
     g_return_val_if_fail (pObject != nullptr, false);
 
+    PairVec values{get_object_values(obj_name, pObject, table)};
+    /* We want only the first item in the table, which should be the PK. */
+    values.resize(1);
+    if (auto keys = persisted_keys (table_name, table))
+        return keys->count (values[0].second) > 0;
+
     /* SELECT * FROM */
     auto sql = std::string{"SELECT "} + table[0]->name() + " FROM " + table_name;
     auto stmt = create_statement_from_sql(sql.c_str());
     assert (stmt != nullptr);
 
     /* WHERE */
-    PairVec values{get_object_values(obj_name, pObject, table)};
-    /* We want only the first item in the table, which should be the PK. */
-    values.resize(1);
     stmt->add_where_cond(obj_name, values);
-    auto result = execute_select_statement (stmt);
+    /* Only rows queued for this table can affect the answer. */
+    auto batch = m_insert_batches.find(table_name);
+    if (batch != m_insert_batches.end() &&
+        !flush_insert_batch(batch->first, batch->second))
+        return false;
+    auto result = run_select_statement (stmt);
     return (result != nullptr && result->size() > 0);
 }
 
+/* The keys of a table's rows, read the first time they're asked for.  Only
+ * tables whose first column is the primary key are tracked. */
+const GncSqlBackend::KeySet*
+GncSqlBackend::persisted_keys (const char* table_name,
+                               const EntryVec& table) const noexcept
+{
+    auto keys = m_persisted_keys.find (table_name);
+    if (keys != m_persisted_keys.end())
+        return &keys->second;
+    if (table.empty() || !table[0]->is_primary_key() || table[0]->is_autoincr())
+        return nullptr;
+
+    auto batch = m_insert_batches.find (table_name);
+    if (batch != m_insert_batches.end() &&
+        !flush_insert_batch (batch->first, batch->second))
+        return nullptr;
+    auto sql = std::string{"SELECT "} + table[0]->name() + " FROM " + table_name;
+    auto result = run_select_statement (create_statement_from_sql (sql));
+    if (result == nullptr)
+        return nullptr;
+
+    KeySet key_set;
+    for (auto row : *result)
+    {
+        auto key = row.get_string_at_col (table[0]->name());
+        if (key)
+            key_set.insert (::quote_string (*key));
+    }
+    return &m_persisted_keys.emplace (table_name, std::move (key_set)).first->second;
+}
+
+/* Keep the persisted keys of a tracked table in step with a write to it. */
+void
+GncSqlBackend::update_persisted_keys (E_DB_OPERATION op, const char* table_name,
+                                      QofIdTypeConst obj_name, gpointer pObject,
+                                      const EntryVec& table) const noexcept
+{
+    if (op == OP_DB_UPDATE)
+        return;
+    auto keys = m_persisted_keys.find (table_name);
+    if (keys == m_persisted_keys.end())
+        return;
+    PairVec values;
+    table[0]->add_to_query (obj_name, pObject, values);
+    if (values.empty())
+        return;
+    if (op == OP_DB_DELETE)
+        keys->second.erase (values[0].second);
+    else
+        keys->second.insert (std::move (values[0].second));
+}
+
 bool
 GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
                                 QofIdTypeConst obj_name, gpointer pObject,
@@ -861,9 +1171,20 @@ GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
     g_return_val_if_fail (obj_name != nullptr, false);
     g_return_val_if_fail (pObject != nullptr, false);
 
+    if (op == OP_DB_UPSERT && !m_conn->can_upsert())
+        op = object_in_db (table_name, obj_name, pObject, table) ?
+            OP_DB_UPDATE : OP_DB_INSERT;
+
+    bool is_ok = false;
     switch(op)
     {
         case  OP_DB_INSERT:
+        if (m_batch_inserts)
+        {
+            is_ok = queue_insert (table_name,
+                                  get_object_values (obj_name, pObject, table));
+            break;
+        }
         stmt = build_insert_statement (table_name, obj_name, pObject, table);
         break;
         case OP_DB_UPDATE:
@@ -872,10 +1193,15 @@ GncSqlBackend::do_db_operation (E_DB_OPERATION op, const char* table_name,
         case OP_DB_DELETE:
         stmt = build_delete_statement (table_name, obj_name, pObject, table);
         break;
+        case OP_DB_UPSERT:
+        is_ok = execute_upsert (table_name, obj_name, pObject, table);
+        break;
     }
-    if (stmt == nullptr)
-        return false;
-    return (execute_nonselect_statement(stmt) != -1);
+    if (stmt != nullptr)
+        is_ok = (execute_nonselect_statement(stmt) != -1);
+    if (is_ok)
+        update_persisted_keys (op, table_name, obj_name, pObject, table);
+    return is_ok;
 }
 
 bool
@@ -960,6 +1286,90 @@ GncSqlBackend::build_update_statement(const gchar* table_name,
     return stmt;
 }
 
+bool
+GncSqlBackend::execute_upsert (const char* table_name,
+                               QofIdTypeConst obj_name,
+                               gpointer pObject,
+                               const EntryVec& table) const noexcept
+{
+    auto batch = m_insert_batches.find (table_name);
+    if (batch != m_insert_batches.end() &&
+        !flush_insert_batch (batch->first, batch->second))
+        return false;
+    StrVec columns, values;
+    for (auto& col_value : get_object_values (obj_name, pObject, table))
+    {
+        columns.push_back (std::move (col_value.first));
+        values.push_back (std::move (col_value.second));
+    }
+    return m_conn->upsert_row (table_name, columns, values);
+}
+
+bool
+GncSqlBackend::queue_insert (const char* table_name,
+                             PairVec&& values) const noexcept
+{
+    auto& batch = m_insert_batches[table_name];
+    if (!batch.rows.empty() && !same_columns (batch.columns, values) &&
+        !flush_insert_batch (table_name, batch))
+        return false;
+    if (batch.rows.empty())
+    {
+        batch.columns.clear();
+        for (auto const& col_value : values)
+            batch.columns.push_back(col_value.first);
+    }
+
+    StrVec row;
+    row.reserve(values.size());
+    for (auto& col_value : values)
+    {
+        batch.length += col_value.second.size() + 1;
+        row.push_back(std::move(col_value.second));
+    }
+    batch.rows.push_back(std::move(row));
+
+    if (batch.rows.size() >= INSERT_BATCH_MAX_ROWS ||
+        batch.length >= INSERT_BATCH_MAX_LENGTH)
+        return flush_insert_batch (table_name, batch);
+    return true;
+}
+
+bool
+GncSqlBackend::flush_insert_batch (const std::string& table_name,
+                                   InsertBatch& batch) const noexcept
+{
+    if (batch.rows.empty())
+        return true;
+
+    auto is_ok = m_conn != nullptr &&
+        m_conn->insert_rows (table_name, batch.columns, batch.rows);
+    if (!is_ok)
+    {
+        PERR ("SQL error inserting %" G_GSIZE_FORMAT " rows into %s\n",
+              batch.rows.size(), table_name.c_str());
+        qof_backend_set_error ((QofBackend*)this, ERR_BACKEND_SERVER_ERR);
+    }
+    batch.rows.clear();
+    batch.length = 0;
+    return is_ok;
+}
+
+bool
+GncSqlBackend::flush_insert_batches () const noexcept
+{
+    bool is_ok = true;
+    for (auto& batch : m_insert_batches)
+        is_ok = flush_insert_batch (batch.first, batch.second) && is_ok;
+    return is_ok;
+}
+
+void
+GncSqlBackend::discard_insert_batches () const noexcept
+{
+    m_insert_batches.clear();
+}
+
 GncSqlStatementPtr
 GncSqlBackend::build_delete_statement(const gchar* table_name,
                                       QofIdTypeConst obj_name,
@@ -27,9 +27,14 @@
 #include <qof.h>
 #include <Account.h>
 
+#include <map>
 #include <memory>
+#include <cstdint>
 #include <exception>
 #include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <qof-backend.hpp>
 
@@ -48,12 +53,15 @@ using GncSqlResultPtr = GncSqlResult*;
 using VersionPair = std::pair<const std::string, unsigned int>;
 using VersionVec = std::vector<VersionPair>;
 using uint_t = unsigned int;
+using StrVec = std::vector<std::string>;
+using PairVec = std::vector<std::pair<std::string, std::string>>;
 
 typedef enum
 {
     OP_DB_INSERT,
     OP_DB_UPDATE,
-    OP_DB_DELETE
+    OP_DB_DELETE,
+    OP_DB_UPSERT  /**< Insert, or update if the row is already there */
 } E_DB_OPERATION;
 
 /**
@@ -71,6 +79,34 @@ public:
      * @param book Book to be loaded
      */
     void load(QofBook*, QofBackendLoadType) override;
+    /**
+     * Load the transactions with a split in an account posted since a date
+     * that the initial load left out, see history_cutoff().  So that the
+     * account's running balances stay right, everything from since up to the
+     * transactions already loaded is loaded.
+     *
+     * @param inst The account, or nullptr for all of them
+     * @param since The earliest posted date to load, INT64_MIN for all
+     */
+    void load_older(QofInstance* inst, time64 since) override;
+    /**
+     * Translate a query into SQL if its object type's backend can.
+     *
+     * @param query The query
+     * @return A GncSqlQuery, or nullptr
+     */
+    void* compile_query(QofQuery* query) override;
+    /**
+     * Select the objects that might match a query compiled by compile_query()
+     * from the database, loading any that the initial load left out.
+     *
+     * @param compiled The compiled query
+     * @param candidates Receives the objects
+     * @return false if the database couldn't be queried
+     */
+    bool run_query(void* compiled,
+                   std::vector<QofInstance*>& candidates) override;
+    void free_query(void* compiled) override;
     /**
      * Save the contents of a book to an SQL database.
      *
@@ -95,6 +131,21 @@ public:
      * @param inst Object being edited
      */
     void rollback(QofInstance*) override;
+    /**
+     * Until the matching end_group_commit(), commit objects inside one
+     * database transaction instead of one transaction each.  Every object
+     * still gets its own savepoint, so an object that fails to save is rolled
+     * back on its own.
+     */
+    void begin_group_commit() override;
+    /**
+     * Commit the transaction begun by the outermost begin_group_commit().  If
+     * that fails the whole group is rolled back and the objects committed in
+     * it are marked dirty again.
+     *
+     * @return TRUE if successful, FALSE if unsuccessful
+     */
+    bool end_group_commit() override;
     /** Connect the backend to a GncSqlConnection.
      * Sets up version info. Calling with nullptr clears the connection and
      * destroys the version info.
@@ -203,6 +254,10 @@ public:
     /**
      * Checks whether an object is in the database or not.
      *
+     * For tables keyed on their first column the keys are read once and then
+     * kept up to date by do_db_operation(), so later checks don't have to
+     * ask the database.
+     *
      * @param table_name DB table name
      * @param obj_name QOF object type name
      * @param pObject Object to be checked
@@ -233,6 +288,22 @@ public:
      */
     bool save_commodity(gnc_commodity* comm) noexcept;
     QofBook* book() const noexcept { return m_book; }
+    /**
+     * With the sql-lazy-load-months preference set, the initial load leaves
+     * out the transactions posted before this date unless they have a split
+     * in a lot, and their splits are summed into the accounts' starting
+     * balances instead.
+     *
+     * @return The cutoff date, or INT64_MIN if every transaction is loaded.
+     */
+    time64 history_cutoff() const noexcept { return m_history_cutoff; }
+    /**
+     * The database doesn't have the changes to transactions that are being
+     * edited until they're committed.
+     *
+     * @return The transactions being edited.
+     */
+    std::vector<Transaction*> open_transactions() noexcept;
     void set_loading(bool loading) noexcept { m_loading = loading; }
     bool pristine() const noexcept { return m_is_pristine_db; }
     void update_progress(double pct) const noexcept;
@@ -247,6 +318,7 @@ protected:
     const char* m_time_format = nullptr; /**< Server-specific date-time string format */
     VersionVec m_versions;    /**< Version number for each table */
 private:
+    void forget_open_transaction(QofInstance*) noexcept;
     bool write_account_tree(Account*);
     bool write_accounts();
     bool write_transactions();
@@ -260,6 +332,40 @@ private:
                                                QofIdTypeConst obj_name,
                                                gpointer pObject,
                                                const EntryVec& table) const noexcept;
+    bool execute_upsert (const char* table_name, QofIdTypeConst obj_name,
+                         gpointer pObject, const EntryVec& table) const noexcept;
+    GncSqlResultPtr run_select_statement (const GncSqlStatementPtr& stmt) const noexcept;
+    /** Rows for one table waiting to be written with a single INSERT. */
+    struct InsertBatch
+    {
+        StrVec columns;
+        std::vector<StrVec> rows;
+        std::size_t length = 0; /**< Length of the rows' SQL text */
+    };
+    bool queue_insert (const char* table_name, PairVec&& values) const noexcept;
+    bool flush_insert_batch (const std::string& table_name,
+                             InsertBatch& batch) const noexcept;
+    /**
+     * Writes out all of the queued INSERTs. This must happen before anything
+     * that could read or modify the rows, so every other statement executed
+     * through the backend does it first.
+     *
+     * @return TRUE if successful, FALSE if unsuccessful
+     */
+    bool flush_insert_batches () const noexcept;
+    void discard_insert_batches () const noexcept;
+    void end_group (bool committed) noexcept;
+    using KeySet = std::unordered_set<std::string>;
+    const KeySet* persisted_keys (const char* table_name,
+                                  const EntryVec& table) const noexcept;
+    void update_persisted_keys (E_DB_OPERATION op, const char* table_name,
+                                QofIdTypeConst obj_name, gpointer pObject,
+                                const EntryVec& table) const noexcept;
+    /**
+     * Forgets the persisted keys. Anything that may have undone writes to the
+     * database, such as a rollback, must do this.
+     */
+    void forget_persisted_keys () const noexcept { m_persisted_keys.clear(); }
     GncSqlStatementPtr build_delete_statement (const char* table_name,
                                                QofIdTypeConst obj_name,
                                                gpointer pObject,
@@ -286,6 +392,20 @@ private:
     };
     ObjectBackendRegistry m_backend_registry;
     std::vector<gnc_commodity*> m_postload_commodities;
+    bool m_batch_inserts = false; /**< Queue INSERTs in m_insert_batches */
+    mutable std::map<std::string, InsertBatch> m_insert_batches;
+    /** Primary keys of the rows of each table object_in_db() has checked. */
+    mutable std::map<std::string, KeySet> m_persisted_keys;
+    int m_group_level = 0;     /**< Nesting of begin_group_commit() */
+    bool m_group_open = false; /**< A group commit's transaction is open */
+    /** Objects committed in the open group, each holding a reference. */
+    std::unordered_set<QofInstance*> m_group_instances;
+    time64 m_history_cutoff = INT64_MIN;
+    /** For accounts loaded further back than m_history_cutoff, how far. */
+    std::unordered_map<const Account*, time64> m_history_loaded;
+    /** Transactions begun but not yet committed or rolled back. They're kept
+     * by GUID because one can be destroyed without either. */
+    std::vector<GncGUID> m_open_transactions;
 };
 
 #endif //__GNC_SQL_BACKEND_HPP__
@@ -26,6 +26,7 @@
 #include <sstream>
 #include <iomanip>
 #include <gnc-datetime.hpp>
+#include <guid.hpp>
 #include "gnc-sql-backend.hpp"
 #include "gnc-sql-object-backend.hpp"
 #include "gnc-sql-column-table-entry.hpp"
@@ -100,9 +101,9 @@ GncSqlColumnTableEntry::add_objectref_guid_to_query (QofIdTypeConst obj_name,
     if (inst == nullptr) return;
     auto guid = qof_instance_get_guid (inst);
     if (guid != nullptr) {
-        gchar *guid_s = guid_to_string(guid);
+        std::string guid_s (GUID_ENCODING_LENGTH, '\0');
+        guid_encode_hex (*guid, &guid_s[0]);
         vec.emplace_back (std::make_pair (std::string{m_col_name}, quote_string(guid_s)));
-        g_free(guid_s);
     }
 }
 
@@ -337,9 +338,9 @@ GncSqlColumnTableEntryImpl<CT_GUID>::add_to_query(QofIdTypeConst obj_name,
 
     if (s != nullptr)
     {
-        gchar *guid_s = guid_to_string(s);
+        std::string guid_s (GUID_ENCODING_LENGTH, '\0');
+        guid_encode_hex (*s, &guid_s[0]);
         vec.emplace_back (std::make_pair (std::string{m_col_name}, quote_string(guid_s)));
-        g_free(guid_s);
         return;
     }
 }
@@ -174,6 +174,10 @@ public:
      * Report if the entry is an auto-increment field.
      */
     bool is_autoincr() const noexcept { return m_flags & COL_AUTOINC; }
+    /**
+     * Report if the entry is the table's primary key.
+     */
+    bool is_primary_key() const noexcept { return m_flags & COL_PKEY; }
     /* On the other hand, our implementation class and GncSqlColumnInfo need to
      * be able to read our member variables.
      */
@@ -35,6 +35,7 @@ class GncSqlColumnTableEntry;
 using GncSqlColumnTableEntryPtr = std::shared_ptr<GncSqlColumnTableEntry>;
 using EntryVec = std::vector<GncSqlColumnTableEntryPtr>;
 using PairVec = std::vector<std::pair<std::string, std::string>>;
+using StrVec = std::vector<std::string>;
 struct GncSqlColumnInfo;
 using ColVec = std::vector<GncSqlColumnInfo>;
 
@@ -67,6 +68,18 @@ public:
         noexcept = 0;
     virtual GncSqlStatementPtr create_statement_from_sql (const std::string&)
         const noexcept = 0;
+    /** Inserts all of the rows into the table with a single statement. Each
+     * row holds the SQL literals for the columns, in the same order.
+     * Returns TRUE if successful, FALSE if error */
+    virtual bool insert_rows (const std::string&, const StrVec&,
+                              const std::vector<StrVec>&) noexcept = 0;
+    /** Returns TRUE if upsert_row can be used with this database */
+    virtual bool can_upsert () const noexcept = 0;
+    /** Inserts a row or, if there is already one with the same primary key,
+     * which must be the first column, replaces its values, with a single
+     * statement. Returns TRUE if successful, FALSE if error */
+    virtual bool upsert_row (const std::string&, const StrVec&,
+                             const StrVec&) noexcept = 0;
     /** Returns true if successful */
     virtual bool does_table_exist (const std::string&) const noexcept = 0;
     /** Returns TRUE if successful, false if error */
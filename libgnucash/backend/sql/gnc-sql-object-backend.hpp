@@ -37,13 +37,31 @@ using EntryVec = std::vector<GncSqlColumnTableEntryPtr>;
 
 #define GNC_SQL_BACKEND "gnc:sql:1"
 
+/**
+ * A QofQuery translated into SQL by GncSqlObjectBackend::compile_query().
+ */
+class GncSqlQuery
+{
+public:
+    virtual ~GncSqlQuery() = default;
+    /**
+     * Find the objects that might match the query, see QofBackend::run_query().
+     * @param sql_be The GncSqlBackend containing the database connection.
+     * @param candidates Receives the objects.
+     * @return false if the database couldn't be queried.
+     */
+    virtual bool run (GncSqlBackend* sql_be,
+                      std::vector<QofInstance*>& candidates) = 0;
+};
+
+using GncSqlQueryPtr = std::unique_ptr<GncSqlQuery>;
+
 /**
  * Encapsulates per-class table schema with functions to load, create a table,
  * commit a changed front-end object (note that database transaction semantics
- * are not yet implemented; edit/commit applies to the front-end object!) and
- * write all front-end objects of the type to the database. Additional functions
- * for creating and running queries existed but were unused and untested. They've
- * been temporarily removed until the front end is ready to use them.
+ * are not yet implemented; edit/commit applies to the front-end object!),
+ * write all front-end objects of the type to the database and translate
+ * queries for them into SQL.
  */
 class GncSqlObjectBackend
 {
@@ -81,6 +99,15 @@ public:
      * @return true if the objects were successfully written, false otherwise.
      */
     virtual bool write (GncSqlBackend* sql_be) { return true; }
+    /**
+     * Translate a query for objects of m_type_name into SQL.
+     * @param sql_be The GncSqlBackend containing the database connection.
+     * @param query The query, which must outlive the result.
+     * @return The translated query, or nullptr if the type's queries can't be
+     * translated or this one wouldn't narrow the search.
+     */
+    virtual GncSqlQueryPtr compile_query (GncSqlBackend* sql_be,
+                                          QofQuery* query) { return nullptr; }
     /**
      * Return the m_type_name for the class. This value is created at
      * compilation time and is called QofIdType or QofIdTypeConst in other parts
@@ -47,8 +47,13 @@
 #include "splint-defs.h"
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <locale>
+#include <optional>
 #include <string>
 #include <sstream>
+#include <unordered_map>
 
 #include "escape.h"
 
@@ -147,13 +152,6 @@ GncSqlSplitBackend::GncSqlSplitBackend() :
     GncSqlObjectBackend(SPLIT_TABLE_VERSION, GNC_ID_SPLIT,
                         SPLIT_TABLE, split_col_table) {}
 
-/* These functions exist but have not been tested.
-   #if LOAD_TRANSACTIONS_AS_NEEDED
-   compile_split_query,
-   run_split_query,
-   free_split_query,
-*/
-
 /* ================================================================= */
 
 static  gpointer
@@ -332,11 +330,12 @@ typedef struct
  *
  * @param sql_be SQL backend
  * @param stmt SQL statement
+ * @return The transactions that weren't already loaded
  */
-static void
+static InstanceVec
 query_transactions (GncSqlBackend* sql_be, std::string selector)
 {
-    g_return_if_fail (sql_be != NULL);
+    g_return_val_if_fail (sql_be != NULL, InstanceVec{});
 
     const std::string tpkey(tx_col_table[0]->name());
     std::string sql("SELECT * FROM " TRANSACTION_TABLE);
@@ -350,7 +349,7 @@ query_transactions (GncSqlBackend* sql_be, std::string selector)
     if (result->begin() == result->end())
     {
         PINFO("Query %s returned no results", sql.c_str());
-        return;
+        return InstanceVec{};
     }
 
     Transaction* tx;
@@ -396,6 +395,160 @@ query_transactions (GncSqlBackend* sql_be, std::string selector)
     for (auto instance : instances)
          xaccTransCommitEdit(GNC_TRANSACTION(instance));
     xaccEnableDataScrubbing();
+    return instances;
+}
+
+/* ----------------------------------------------------------------- */
+/* Partial loading.
+ *
+ * When the backend has a history cutoff the initial load leaves out the
+ * transactions posted before it, except those with a split in a lot because
+ * lots and the business objects using them need all of theirs. The database
+ * sums the splits left out into the starting balances of their accounts, so
+ * the balances are right without them, and whenever one of them is loaded
+ * later its splits are taken back out of the starting balances.
+ */
+struct start_balances_t
+{
+    gnc_numeric balance = gnc_numeric_zero ();
+    gnc_numeric noclosing_balance = gnc_numeric_zero ();
+    gnc_numeric cleared_balance = gnc_numeric_zero ();
+    gnc_numeric reconciled_balance = gnc_numeric_zero ();
+};
+using StartBalanceMap = std::unordered_map<Account*, start_balances_t>;
+
+static std::string
+time_for_sql (time64 t)
+{
+    return "'" + GncDateTime(t).format_iso8601() + "'";
+}
+
+/* Selects the ids of the transactions with a split in a lot. */
+static std::string
+lot_transactions_subquery ()
+{
+    const std::string stkey(split_col_table[1]->name()); //tx_guid
+    const std::string slkey(split_col_table[9]->name()); //lot_guid
+    return "(SELECT " + stkey + " FROM " SPLIT_TABLE " WHERE " + slkey +
+        " IS NOT NULL)";
+}
+
+/* The condition on the transactions an initial load with cutoff loads... */
+static std::string
+initial_load_condition (time64 cutoff)
+{
+    const std::string tpkey(tx_col_table[0]->name());
+    return "post_date IS NULL OR post_date >= " + time_for_sql (cutoff) +
+        " OR " + tpkey + " IN " + lot_transactions_subquery ();
+}
+
+/* ...and the one on the transactions it leaves out. The table is named so
+ * that it can be used in a join with the splits. */
+static std::string
+held_back_condition (time64 cutoff)
+{
+    const std::string tpkey(tx_col_table[0]->name());
+    return TRANSACTION_TABLE ".post_date < " + time_for_sql (cutoff) +
+        " AND " TRANSACTION_TABLE "." + tpkey + " NOT IN " +
+        lot_transactions_subquery ();
+}
+
+/* The sums may mix denominators, e.g. from amounts entered before the
+ * commodity's fraction changed, so they're added at their least common one. */
+static gnc_numeric
+add_amounts (gnc_numeric a, gnc_numeric b)
+{
+    return gnc_numeric_add (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+}
+
+static void
+add_split_amount (start_balances_t& bal, char reconcile_state,
+                  gnc_numeric amount, bool closing)
+{
+    bal.balance = add_amounts (bal.balance, amount);
+    if (!closing)
+        bal.noclosing_balance = add_amounts (bal.noclosing_balance, amount);
+    if (reconcile_state != NREC)
+        bal.cleared_balance = add_amounts (bal.cleared_balance, amount);
+    if (reconcile_state == YREC || reconcile_state == FREC)
+        bal.reconciled_balance = add_amounts (bal.reconciled_balance, amount);
+}
+
+/* The account adds its splits to the starting balances with a fixed
+ * denominator, so they're stored in the commodity's smallest unit. */
+static gnc_numeric
+start_balance_plus (Account* acct, const gnc_numeric& start, gnc_numeric delta)
+{
+    return gnc_numeric_convert (add_amounts (start, delta),
+                                xaccAccountGetCommoditySCU (acct),
+                                GNC_HOW_RND_ROUND_HALF_UP);
+}
+
+static void
+add_to_start_balances (const StartBalanceMap& deltas)
+{
+    for (const auto& [acct, delta] : deltas)
+    {
+        gnc_numeric *start, *noclosing, *cleared, *reconciled;
+        g_object_get (acct, "start-balance", &start,
+                      "start-noclosing-balance", &noclosing,
+                      "start-cleared-balance", &cleared,
+                      "start-reconciled-balance", &reconciled, nullptr);
+        gnc_account_set_start_balance (acct,
+                start_balance_plus (acct, *start, delta.balance));
+        gnc_account_set_start_noclosing_balance (acct,
+                start_balance_plus (acct, *noclosing, delta.noclosing_balance));
+        gnc_account_set_start_cleared_balance (acct,
+                start_balance_plus (acct, *cleared, delta.cleared_balance));
+        gnc_account_set_start_reconciled_balance (acct,
+                start_balance_plus (acct, *reconciled, delta.reconciled_balance));
+        g_free (start);
+        g_free (noclosing);
+        g_free (cleared);
+        g_free (reconciled);
+        xaccAccountRecomputeBalance (acct);
+    }
+}
+
+/* Template transactions are always loaded by the scheduled transactions, so
+ * only the accounts in the book's account tree have starting balances. */
+static bool
+in_account_tree (Account* acct, Account* root)
+{
+    return acct != nullptr && gnc_account_get_root (acct) == root;
+}
+
+static void seed_start_balances (GncSqlBackend* sql_be, time64 cutoff);
+
+/**
+ * Takes the splits of transactions that had been left out of the initial
+ * load out of the starting balances of their accounts. Every transaction
+ * loaded after the initial load is one of those.
+ */
+static void
+release_held_back (GncSqlBackend* sql_be, const InstanceVec& instances)
+{
+    if (sql_be->history_cutoff() == INT64_MIN || instances.empty())
+        return;
+
+    auto root = gnc_book_get_root_account (sql_be->book());
+    StartBalanceMap deltas;
+    for (auto inst : instances)
+    {
+        auto tx = GNC_TRANSACTION(inst);
+        auto closing = xaccTransGetIsClosingTxn (tx);
+        for (auto node = xaccTransGetSplitList (tx); node; node = node->next)
+        {
+            auto split = GNC_SPLIT(node->data);
+            auto acct = xaccSplitGetAccount (split);
+            if (!in_account_tree (acct, root))
+                continue;
+            add_split_amount (deltas[acct], xaccSplitGetReconcile (split),
+                              gnc_numeric_neg (xaccSplitGetAmount (split)),
+                              closing);
+        }
+    }
+    add_to_start_balances (deltas);
 }
 
 
@@ -704,12 +857,46 @@ void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
     std::string sql("(SELECT DISTINCT ");
     sql += stkey + " FROM " SPLIT_TABLE " WHERE " + sakey + " = '";
     sql += gnc::GUID(*guid).to_string() + "')";
-    query_transactions (sql_be, sql);
+    release_held_back (sql_be, query_transactions (sql_be, sql));
+}
+
+void
+gnc_sql_transaction_load_history (GncSqlBackend* sql_be, Account* account,
+                                  time64 since, time64 until)
+{
+    g_return_if_fail (sql_be != NULL);
+
+    auto cutoff = sql_be->history_cutoff();
+    if (cutoff == INT64_MIN)
+        return;
+
+    std::string sql = held_back_condition (cutoff);
+    if (until < cutoff)
+        sql += " AND post_date < " + time_for_sql (until);
+    if (since > MINTIME)
+        sql += " AND post_date >= " + time_for_sql (since);
+    if (account != nullptr)
+    {
+        const std::string tpkey(tx_col_table[0]->name());
+        const std::string stkey(split_col_table[1]->name());
+        const std::string sakey(split_col_table[2]->name());
+        auto guid = qof_instance_get_guid (QOF_INSTANCE (account));
+        sql += " AND " + tpkey + " IN (SELECT " + stkey + " FROM " SPLIT_TABLE
+            " WHERE " + sakey + " = '" + gnc::GUID(*guid).to_string() + "')";
+    }
+
+    auto root = gnc_book_get_root_account (sql_be->book());
+    gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
+                                   nullptr);
+    release_held_back (sql_be, query_transactions (sql_be, sql));
+    gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
+                                   nullptr);
 }
 
 /**
- * Loads all transactions.  This might be used during a save-as operation to ensure that
- * all data is in memory and ready to be saved.
+ * Loads all transactions, or if the backend has a history cutoff only those
+ * an initial load needs.  This might be used during a save-as operation to
+ * ensure that all data is in memory and ready to be saved.
  *
  * @param sql_be SQL backend
  */
@@ -721,11 +908,440 @@ GncSqlTransBackend::load_all (GncSqlBackend* sql_be)
     auto root = gnc_book_get_root_account (sql_be->book());
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
                                    nullptr);
-    query_transactions (sql_be, "");
+    auto cutoff = sql_be->history_cutoff();
+    if (cutoff == INT64_MIN)
+    {
+        query_transactions (sql_be, "");
+    }
+    else
+    {
+        query_transactions (sql_be, initial_load_condition (cutoff));
+        seed_start_balances (sql_be, cutoff);
+    }
     gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
                                    nullptr);
 }
 
+/* ----------------------------------------------------------------- */
+/* Split queries.
+ *
+ * A query for splits is translated into a condition on the splits joined with
+ * their transactions that every split the query matches meets. Terms that
+ * can't be translated are left out and some are widened, so the condition can
+ * select more splits than the query matches; the engine applies the query to
+ * the splits selected.
+ */
+#define SPLIT_QUERY_FROM SPLIT_TABLE " INNER JOIN " TRANSACTION_TABLE \
+    " ON " SPLIT_TABLE ".tx_guid = " TRANSACTION_TABLE ".guid"
+
+struct sql_term_t
+{
+    std::string cond;   /**< Empty if the term matches every split */
+    bool exact;         /**< cond selects only the splits the term matches */
+};
+
+using SqlTerm = std::optional<sql_term_t>;
+
+static bool
+param_path_is (const QofQueryParamList* path,
+               std::initializer_list<const char*> names)
+{
+    for (auto name : names)
+    {
+        if (path == nullptr || g_strcmp0 (static_cast<const char*>(path->data),
+                                          name))
+            return false;
+        path = path->next;
+    }
+    return path == nullptr;
+}
+
+static const char*
+compare_op (QofQueryCompare how)
+{
+    switch (how)
+    {
+    case QOF_COMPARE_LT:
+        return " < ";
+    case QOF_COMPARE_LTE:
+        return " <= ";
+    case QOF_COMPARE_EQUAL:
+        return " = ";
+    case QOF_COMPARE_GT:
+        return " > ";
+    case QOF_COMPARE_GTE:
+        return " >= ";
+    case QOF_COMPARE_NEQ:
+        return " <> ";
+    default:
+        return nullptr;
+    }
+}
+
+static SqlTerm
+guid_term (const std::string& col, query_guid_t pdata)
+{
+    if (pdata->options != QOF_GUID_MATCH_ANY &&
+        pdata->options != QOF_GUID_MATCH_NONE)
+        return std::nullopt;
+    auto any = pdata->options == QOF_GUID_MATCH_ANY;
+    if (pdata->guids == nullptr)
+        return sql_term_t{any ? "1 = 0" : "", true};
+
+    auto cond = col + (any ? " IN (" : " NOT IN (");
+    for (auto node = pdata->guids; node; node = node->next)
+    {
+        auto guid = static_cast<const GncGUID*>(node->data);
+        cond += (node == pdata->guids ? "'" : ", '") +
+            gnc::GUID(*guid).to_string() + "'";
+    }
+    return sql_term_t{cond + ")", true};
+}
+
+static SqlTerm
+date_term (const std::string& col, query_date_t pdata)
+{
+    auto op = compare_op (pdata->pd.how);
+    if (op == nullptr)
+        return std::nullopt;
+    if (pdata->options != QOF_DATE_MATCH_DAY)
+        return sql_term_t{col + op + time_for_sql (pdata->date), true};
+
+    /* Day matches depend on the time zone, so allow a day either side. */
+    auto lo = time_for_sql (gnc_time64_get_day_start (pdata->date) - 86400);
+    auto hi = time_for_sql (gnc_time64_get_day_end (pdata->date) + 86400);
+    switch (pdata->pd.how)
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+        return sql_term_t{col + " <= " + hi, false};
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
+        return sql_term_t{col + " >= " + lo, false};
+    case QOF_COMPARE_EQUAL:
+        return sql_term_t{col + " >= " + lo + " AND " + col + " <= " + hi,
+                          false};
+    default:
+        return std::nullopt;
+    }
+}
+
+/* The engine compares the absolute value of the split's amount. Fractions
+ * can't be compared in SQL without risking overflow, so the comparison is
+ * made in floating point and widened to make up for rounding. */
+static SqlTerm
+numeric_term (const std::string& col, query_numeric_t pdata)
+{
+    constexpr double slop = 0.001;
+    auto amount = gnc_numeric_to_double (pdata->amount);
+    auto value = "ABS(" + col + "_num * 1.0 / " + col + "_denom)";
+    std::ostringstream cond;
+    cond.imbue (std::locale::classic());
+    cond.precision (17);
+    switch (pdata->pd.how)
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+        cond << value << " <= " << amount + slop;
+        break;
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
+        cond << value << " >= " << amount - slop;
+        break;
+    case QOF_COMPARE_EQUAL:
+        cond << value << " >= " << std::abs (amount) - slop << " AND "
+             << value << " <= " << std::abs (amount) + slop;
+        break;
+    default:
+        return std::nullopt;
+    }
+    if (pdata->options == QOF_NUMERIC_MATCH_CREDIT)
+        cond << " AND " << col << "_num <= 0";
+    else if (pdata->options == QOF_NUMERIC_MATCH_DEBIT)
+        cond << " AND " << col << "_num >= 0";
+    return sql_term_t{cond.str(), false};
+}
+
+static bool
+is_ascii (const char* str)
+{
+    for (; *str; ++str)
+        if (static_cast<unsigned char>(*str) > 0x7f)
+            return false;
+    return true;
+}
+
+/* Matched with LIKE on the lower-cased strings, which finds everything a
+ * case-sensitive match does too. SQL databases don't all lower-case the same
+ * characters the engine does, so case-insensitive matches of patterns that
+ * aren't ASCII are left to the engine. */
+static SqlTerm
+string_term (const GncSqlBackend* sql_be, const std::string& col,
+             query_string_t pdata)
+{
+    if (pdata->is_regex || pdata->matchstring == nullptr)
+        return std::nullopt;
+    if (pdata->options == QOF_STRING_MATCH_CASEINSENSITIVE &&
+        !is_ascii (pdata->matchstring))
+        return std::nullopt;
+
+    auto contains = pdata->pd.how == QOF_COMPARE_CONTAINS;
+    if (!contains && pdata->pd.how != QOF_COMPARE_EQUAL)
+        return std::nullopt;
+    if (contains && *pdata->matchstring == '\0')
+        return sql_term_t{"", true};
+
+    std::string pattern{contains ? "%" : ""};
+    for (auto c = pdata->matchstring; *c; ++c)
+    {
+        if (*c == '!' || *c == '%' || *c == '_')
+            pattern += '!';
+        pattern += *c;
+    }
+    if (contains)
+        pattern += '%';
+    return sql_term_t{"LOWER(COALESCE(" + col + ", '')) LIKE LOWER(" +
+                      sql_be->quote_string (pattern) + ") ESCAPE '!'", false};
+}
+
+static SqlTerm
+char_term (const GncSqlBackend* sql_be, const std::string& col,
+           query_char_t pdata)
+{
+    if (pdata->options != QOF_CHAR_MATCH_ANY &&
+        pdata->options != QOF_CHAR_MATCH_NONE)
+        return std::nullopt;
+    auto any = pdata->options == QOF_CHAR_MATCH_ANY;
+    if (pdata->char_list == nullptr || *pdata->char_list == '\0')
+        return sql_term_t{any ? "1 = 0" : "", true};
+
+    auto cond = col + (any ? " IN (" : " NOT IN (");
+    for (auto c = pdata->char_list; *c; ++c)
+        cond += (c == pdata->char_list ? "" : ", ") +
+            sql_be->quote_string (std::string(1, *c));
+    return sql_term_t{cond + ")", true};
+}
+
+static SqlTerm
+split_term (const GncSqlBackend* sql_be, QofQueryTerm* qterm)
+{
+    auto path = qof_query_term_get_param_path (qterm);
+    auto pd = qof_query_term_get_pred_data (qterm);
+    auto type = pd->type_name;
+    SqlTerm term;
+
+    if (!g_strcmp0 (type, QOF_TYPE_GUID))
+    {
+        auto pdata = reinterpret_cast<query_guid_t>(pd);
+        if (param_path_is (path, {SPLIT_ACCOUNT, QOF_PARAM_GUID}))
+            term = guid_term (SPLIT_TABLE ".account_guid", pdata);
+        else if (param_path_is (path, {SPLIT_TRANS, QOF_PARAM_GUID}))
+            term = guid_term (SPLIT_TABLE ".tx_guid", pdata);
+        else if (param_path_is (path, {QOF_PARAM_GUID}))
+            term = guid_term (SPLIT_TABLE ".guid", pdata);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_DATE))
+    {
+        if (param_path_is (path, {SPLIT_TRANS, TRANS_DATE_POSTED}))
+            term = date_term (TRANSACTION_TABLE ".post_date",
+                              reinterpret_cast<query_date_t>(pd));
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_NUMERIC))
+    {
+        auto pdata = reinterpret_cast<query_numeric_t>(pd);
+        if (param_path_is (path, {SPLIT_VALUE}))
+            term = numeric_term (SPLIT_TABLE ".value", pdata);
+        else if (param_path_is (path, {SPLIT_AMOUNT}))
+            term = numeric_term (SPLIT_TABLE ".quantity", pdata);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_STRING))
+    {
+        auto pdata = reinterpret_cast<query_string_t>(pd);
+        if (param_path_is (path, {SPLIT_MEMO}))
+            term = string_term (sql_be, SPLIT_TABLE ".memo", pdata);
+        else if (param_path_is (path, {SPLIT_ACTION}))
+            term = string_term (sql_be, SPLIT_TABLE ".action", pdata);
+        else if (param_path_is (path, {SPLIT_TRANS, TRANS_DESCRIPTION}))
+            term = string_term (sql_be, TRANSACTION_TABLE ".description",
+                                pdata);
+        else if (param_path_is (path, {SPLIT_TRANS, TRANS_NUM}))
+            term = string_term (sql_be, TRANSACTION_TABLE ".num", pdata);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_CHAR))
+    {
+        if (param_path_is (path, {SPLIT_RECONCILE}))
+            term = char_term (sql_be, SPLIT_TABLE ".reconcile_state",
+                              reinterpret_cast<query_char_t>(pd));
+    }
+
+    if (!term || !qof_query_term_is_inverted (qterm))
+        return term;
+    /* Only the negation of an exact condition selects every split that the
+     * inverted term matches. */
+    if (!term->exact)
+        return std::nullopt;
+    if (term->cond.empty())
+        return sql_term_t{"1 = 0", true};
+    return sql_term_t{"NOT (" + term->cond + ")", true};
+}
+
+class GncSqlSplitQuery : public GncSqlQuery
+{
+public:
+    GncSqlSplitQuery (QofQuery* query, std::string&& where, bool exact) :
+        m_query{query}, m_where{std::move(where)}, m_exact{exact} {}
+    bool run (GncSqlBackend* sql_be, InstanceVec& candidates) override;
+private:
+    std::string limit_condition (GncSqlBackend* sql_be) const;
+    QofQuery* m_query;
+    std::string m_where;
+    bool m_exact;      /**< m_where selects only the splits the query matches */
+};
+
+/* The engine sorts the matching splits and keeps the last max_results of
+ * them. When it sorts them by posted date only those posted within a day
+ * (the sort might ignore the time) of the max_results-th latest one can be
+ * kept, or of the earliest ones when it sorts them in reverse. Splits without
+ * a posted date in the database are always selected. */
+std::string
+GncSqlSplitQuery::limit_condition (GncSqlBackend* sql_be) const
+{
+    auto max_results = qof_query_get_max_results (m_query);
+    if (!m_exact || max_results <= 0)
+        return "";
+
+    QofQuerySort *primary, *secondary, *tertiary;
+    qof_query_get_sorts (m_query, &primary, &secondary, &tertiary);
+    auto path = qof_query_sort_get_param_path (primary);
+    if (!param_path_is (path, {QUERY_DEFAULT_SORT}) &&
+        !param_path_is (path, {SPLIT_TRANS, TRANS_DATE_POSTED}))
+        return "";
+    auto latest = qof_query_sort_get_increasing (primary);
+
+    std::string sql ("SELECT " TRANSACTION_TABLE ".post_date FROM "
+                     SPLIT_QUERY_FROM " WHERE (");
+    sql += m_where + ") AND " TRANSACTION_TABLE ".post_date IS NOT NULL"
+        " ORDER BY " TRANSACTION_TABLE ".post_date" +
+        (latest ? " DESC" : " ASC") + " LIMIT 1 OFFSET " +
+        std::to_string (max_results - 1);
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    auto result = sql_be->execute_select_statement (stmt);
+    if (result == nullptr)
+        return "";
+    auto row = result->begin();
+    if (row == result->end())
+        return "";
+    auto boundary = row.get_time64_at_col ("post_date");
+    if (!boundary)
+        return "";
+    if (latest)
+        return TRANSACTION_TABLE ".post_date >= " +
+            time_for_sql (*boundary - 86400);
+    return TRANSACTION_TABLE ".post_date <= " +
+        time_for_sql (*boundary + 86400);
+}
+
+bool
+GncSqlSplitQuery::run (GncSqlBackend* sql_be, InstanceVec& candidates)
+{
+    /* Transactions being edited may match in the engine but not yet in the
+     * database, so their splits are always candidates, and they can push
+     * others out of the limit. */
+    auto open = sql_be->open_transactions();
+    std::string cond{"(" + m_where + ")"};
+    if (open.empty())
+    {
+        auto limit = limit_condition (sql_be);
+        if (!limit.empty())
+            cond += " AND " + limit;
+    }
+    cond = "(" + cond + ") OR " TRANSACTION_TABLE ".post_date IS NULL";
+
+    auto cutoff = sql_be->history_cutoff();
+    if (cutoff != INT64_MIN)
+    {
+        std::string selector ("(SELECT DISTINCT " SPLIT_TABLE ".tx_guid FROM "
+                              SPLIT_QUERY_FROM " WHERE (");
+        selector += cond + ") AND " + held_back_condition (cutoff) + ")";
+        auto root = gnc_book_get_root_account (sql_be->book());
+        gnc_account_foreach_descendant(root, (AccountCb)xaccAccountBeginEdit,
+                                       nullptr);
+        release_held_back (sql_be, query_transactions (sql_be, selector));
+        gnc_account_foreach_descendant(root, (AccountCb)xaccAccountCommitEdit,
+                                       nullptr);
+    }
+
+    std::string sql ("SELECT " SPLIT_TABLE ".guid FROM " SPLIT_QUERY_FROM
+                     " WHERE ");
+    sql += cond;
+    auto stmt = sql_be->create_statement_from_sql (sql);
+    auto result = sql_be->execute_select_statement (stmt);
+    if (result == nullptr)
+        return false;
+
+    candidates.reserve (candidates.size() + result->size());
+    for (auto row : *result)
+    {
+        auto val = row.get_string_at_col ("guid");
+        GncGUID guid;
+        if (!val || !string_to_guid (val->c_str(), &guid))
+            continue;
+        auto split = xaccSplitLookup (&guid, sql_be->book());
+        if (split != nullptr)
+            candidates.push_back (QOF_INSTANCE (split));
+    }
+
+    if (!open.empty())
+    {
+        for (auto tx : open)
+            for (auto node = xaccTransGetSplitList (tx); node; node = node->next)
+                candidates.push_back (QOF_INSTANCE (node->data));
+        std::sort (candidates.begin(), candidates.end());
+        candidates.erase (std::unique (candidates.begin(), candidates.end()),
+                          candidates.end());
+    }
+    return true;
+}
+
+GncSqlQueryPtr
+GncSqlSplitBackend::compile_query (GncSqlBackend* sql_be, QofQuery* query)
+{
+    g_return_val_if_fail (sql_be != nullptr, nullptr);
+    g_return_val_if_fail (query != nullptr, nullptr);
+
+    std::string where;
+    bool exact = true;
+    for (auto or_node = qof_query_get_terms (query); or_node;
+         or_node = or_node->next)
+    {
+        std::string clause;
+        for (auto and_node = static_cast<GList*>(or_node->data); and_node;
+             and_node = and_node->next)
+        {
+            auto term = split_term (sql_be,
+                                    static_cast<QofQueryTerm*>(and_node->data));
+            if (!term)
+            {
+                exact = false;
+                continue;
+            }
+            exact = exact && term->exact;
+            if (!term->cond.empty())
+                clause += (clause.empty() ? "(" : " AND (") + term->cond + ")";
+        }
+        /* A clause selecting every split makes the query select them all, and
+         * the engine does that faster. */
+        if (clause.empty())
+            return nullptr;
+        where += (where.empty() ? "(" : " OR (") + clause + ")";
+    }
+    if (where.empty())
+        return nullptr;
+
+    PINFO ("Split query %p selects %s", query, where.c_str());
+    return std::make_unique<GncSqlSplitQuery>(query, std::move(where), exact);
+}
+
 typedef struct
 {
     GncSqlStatementPtr stmt;
@@ -765,26 +1381,87 @@ set_acct_bal_reconcile_state (gpointer pObject, gpointer pValue)
     bal->reconcile_state = s[0];
 }
 
-static void
-set_acct_bal_balance (gpointer pObject, gnc_numeric value)
-{
-    single_acct_balance_t* bal = (single_acct_balance_t*)pObject;
-
-    g_return_if_fail (pObject != NULL);
-
-    bal->balance = value;
-}
-
 static const EntryVec acct_balances_col_table
 {
     gnc_sql_make_table_entry<CT_GUID>("account_guid", 0, 0, nullptr,
                                 (QofSetterFunc)set_acct_bal_account_from_guid),
     gnc_sql_make_table_entry<CT_STRING>("reconcile_state", 1, 0, nullptr,
                                 (QofSetterFunc)set_acct_bal_reconcile_state),
-    gnc_sql_make_table_entry<CT_NUMERIC>("quantity", 0, 0, nullptr,
-                                         (QofSetterFunc)set_acct_bal_balance),
 };
 
+/* The sum of an integer column is a decimal in some databases. */
+static std::optional<int64_t>
+get_sum_at_col (GncSqlRow& row, const char* col)
+{
+    if (auto int_val{row.get_int_at_col (col)})
+        return int_val;
+    if (auto double_val{row.get_double_at_col (col)})
+        return std::llround (*double_val);
+    if (auto str_val{row.get_string_at_col (col)})
+        return g_ascii_strtoll (str_val->c_str(), nullptr, 10);
+    return std::nullopt;
+}
+
+/**
+ * Sums the splits of the transactions an initial load with cutoff leaves out
+ * into the starting balances of their accounts.
+ *
+ * @param sql_be SQL backend
+ * @param cutoff The backend's history cutoff
+ */
+static void
+seed_start_balances (GncSqlBackend* sql_be, time64 cutoff)
+{
+    const std::string tpkey(tx_col_table[0]->name());
+    const std::string stkey(split_col_table[1]->name());
+    auto root = gnc_book_get_root_account (sql_be->book());
+    StartBalanceMap balances;
+    /* The amounts are summed per denominator because they can't be added up
+     * as fractions in SQL. Closing transactions are summed a second time to
+     * take them back out of the balances ignoring them. */
+    for (auto closing : {false, true})
+    {
+        std::string sql("SELECT " SPLIT_TABLE ".account_guid, "
+                        SPLIT_TABLE ".reconcile_state, "
+                        "SUM(" SPLIT_TABLE ".quantity_num) AS quantity_num, "
+                        SPLIT_TABLE ".quantity_denom FROM " SPLIT_TABLE
+                        " INNER JOIN " TRANSACTION_TABLE " ON " SPLIT_TABLE ".");
+        sql += stkey + " = " TRANSACTION_TABLE "." + tpkey + " WHERE " +
+            held_back_condition (cutoff);
+        if (closing)
+            sql += " AND " TRANSACTION_TABLE "." + tpkey + " IN (SELECT "
+                "obj_guid FROM slots WHERE name = 'book_closing')";
+        sql += " GROUP BY " SPLIT_TABLE ".account_guid, "
+            SPLIT_TABLE ".reconcile_state, " SPLIT_TABLE ".quantity_denom";
+
+        auto stmt = sql_be->create_statement_from_sql (sql);
+        auto result = sql_be->execute_select_statement (stmt);
+        if (result == nullptr)
+            return;
+        for (auto row : *result)
+        {
+            single_acct_balance_t bal{sql_be, nullptr, NREC,
+                                      gnc_numeric_zero ()};
+            gnc_sql_load_object (sql_be, row, nullptr, &bal,
+                                 acct_balances_col_table);
+            auto num = get_sum_at_col (row, "quantity_num");
+            auto denom = row.get_int_at_col ("quantity_denom");
+            if (!in_account_tree (bal.acct, root) || !num || !denom)
+                continue;
+            bal.balance = gnc_numeric_create (*num, *denom);
+            auto& start = balances[bal.acct];
+            if (closing)
+                start.noclosing_balance =
+                    add_amounts (start.noclosing_balance,
+                                 gnc_numeric_neg (bal.balance));
+            else
+                add_split_amount (start, bal.reconcile_state, bal.balance,
+                                  false);
+        }
+    }
+    add_to_start_balances (balances);
+}
+
 /* ----------------------------------------------------------------- */
 template<> void
 GncSqlColumnTableEntryImpl<CT_TXREF>::load (const GncSqlBackend* sql_be,
@@ -809,7 +1486,8 @@ GncSqlColumnTableEntryImpl<CT_TXREF>::load (const GncSqlBackend* sql_be,
     if (tx == nullptr)
     {
         std::string sql = tpkey + " = '" + *val + "'";
-        query_transactions ((GncSqlBackend*)sql_be, sql);
+        auto be = const_cast<GncSqlBackend*>(sql_be);
+        release_held_back (be, query_transactions (be, sql));
         tx = xaccTransLookup (&guid, sql_be->book());
     }
 
@@ -49,6 +49,8 @@ public:
     void load_all(GncSqlBackend*) override { return; } // loaded by transaction.
     void create_tables(GncSqlBackend*) override;
     bool commit (GncSqlBackend* sql_be, QofInstance* inst) override;
+    GncSqlQueryPtr compile_query (GncSqlBackend* sql_be,
+                                  QofQuery* query) override;
 };
 
 /**
@@ -59,6 +61,19 @@ public:
  */
 void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* sql_be,
                                               Account* account);
+/**
+ * Loads the transactions the initial load left out because they were posted
+ * before the backend's history cutoff, and takes their splits back out of the
+ * starting balances.
+ *
+ * @param sql_be SQL backend
+ * @param account Only load transactions with a split in this account, or all
+ * of them if nullptr
+ * @param since Only load transactions posted at or after this
+ * @param until Only load transactions posted before this
+ */
+void gnc_sql_transaction_load_history (GncSqlBackend* sql_be, Account* account,
+                                       time64 since, time64 until);
 typedef struct
 {
     Account* acct;
@@ -29,6 +29,7 @@
 #include "../gnc-sql-connection.hpp"
 #include "../gnc-sql-backend.hpp"
 #include "../gnc-sql-result.hpp"
+#include "../gnc-sql-column-table-entry.hpp"
 
 static const gchar* suitename = "/backend/sql/gnc-backend-sql";
 void test_suite_gnc_backend_sql (void);
@@ -94,17 +95,26 @@ class GncMockSqlConnection : public GncSqlConnection
 {
 public:
     GncSqlResultPtr execute_select_statement (const GncSqlStatementPtr&)
-        noexcept override { return &m_result; }
+        noexcept override { ++m_selects; return &m_result; }
     int execute_nonselect_statement (const GncSqlStatementPtr&)
         noexcept override { return 1; }
     GncSqlStatementPtr create_statement_from_sql (const std::string&)
         const noexcept override {
         return std::unique_ptr<GncMockSqlStatement>(new GncMockSqlStatement); }
+    bool insert_rows (const std::string&, const StrVec&,
+                      const std::vector<StrVec>&) noexcept override {
+        return true; }
+    bool can_upsert () const noexcept override { return false; }
+    bool upsert_row (const std::string&, const StrVec&,
+                     const StrVec&) noexcept override { return false; }
     bool does_table_exist (const std::string&) const noexcept override {
         return true; }
-    bool begin_transaction () noexcept override { return true;}
-    bool rollback_transaction () noexcept override { return true; }
-    bool commit_transaction () noexcept override { return true; }
+    bool begin_transaction () noexcept override { ++m_depth; return true;}
+    bool rollback_transaction () noexcept override { --m_depth; return true; }
+    bool commit_transaction () noexcept override {
+        if (m_depth == 1 && m_fail_commit) return false;
+        if (--m_depth == 0) ++m_commits;
+        return true; }
     bool create_table (const std::string&, const ColVec&)
         const noexcept override { return false; }
     bool create_index (const std::string&, const std::string&,
@@ -117,6 +127,10 @@ public:
     void set_error(QofBackendError error, unsigned int repeat, bool retry) noexcept override { return; }
     bool verify() noexcept override { return true; }
     bool retry_connection(const char* msg) noexcept override { return true; }
+    int m_selects = 0;          /* SELECTs executed */
+    int m_depth = 0;            /* Open transactions and savepoints */
+    int m_commits = 0;          /* Outermost transactions committed */
+    bool m_fail_commit = false; /* Make the outermost COMMIT fail */
 private:
     GncMockSqlResult m_result;
 };
@@ -332,6 +346,101 @@ test_gnc_sql_commit_edit (void)
     qof_book_destroy (book);
     delete sql_be;
 }
+/* begin_group_commit, end_group_commit
+void GncSqlBackend::begin_group_commit()
+bool GncSqlBackend::end_group_commit()
+*/
+static void
+test_gnc_sql_group_commit (void)
+{
+    auto conn{new GncMockSqlConnection};
+
+    qof_object_initialize ();
+    auto book = qof_book_new();
+    auto sql_be = new GncMockSqlBackend{conn, book};
+    gnc_account_create_root (book);
+
+    sql_be->begin_group_commit ();
+    sql_be->begin_group_commit ();
+    g_assert_cmpint (conn->m_depth, == , 1);
+    qof_instance_set_dirty_flag (QOF_INSTANCE (book), TRUE);
+    qof_book_mark_session_dirty (book);
+    sql_be->commit (QOF_INSTANCE (book));
+    sql_be->commit (QOF_INSTANCE (book));
+    /* Clean, but not saved until the whole group is. */
+    g_assert_true (!qof_instance_get_dirty_flag (QOF_INSTANCE (book)));
+    g_assert_true (qof_book_session_not_saved (book));
+    g_assert_cmpint (conn->m_depth, == , 1);
+    g_assert_cmpint (conn->m_commits, == , 0);
+    g_assert_true (sql_be->end_group_commit ());
+    g_assert_cmpint (conn->m_depth, == , 1);
+    g_assert_true (sql_be->end_group_commit ());
+    g_assert_cmpint (conn->m_depth, == , 0);
+    g_assert_cmpint (conn->m_commits, == , 1);
+    g_assert_true (!qof_book_session_not_saved (book));
+
+    /* If the group can't be committed its objects are dirty again. */
+    conn->m_fail_commit = true;
+    sql_be->begin_group_commit ();
+    qof_instance_set_dirty_flag (QOF_INSTANCE (book), TRUE);
+    qof_book_mark_session_dirty (book);
+    sql_be->commit (QOF_INSTANCE (book));
+    g_assert_true (!qof_instance_get_dirty_flag (QOF_INSTANCE (book)));
+    g_assert_true (!sql_be->end_group_commit ());
+    g_assert_cmpint (conn->m_depth, == , 0);
+    g_assert_cmpint (conn->m_commits, == , 1);
+    g_assert_true (qof_instance_get_dirty_flag (QOF_INSTANCE (book)));
+    g_assert_true (qof_book_session_not_saved (book));
+    g_assert_cmpint (sql_be->get_error (), == , ERR_BACKEND_SERVER_ERR);
+
+    qof_book_destroy (book);
+    delete sql_be;
+}
+/* object_in_db
+bool GncSqlBackend::object_in_db (const char* table_name, QofIdTypeConst obj_name,
+                                  const gpointer pObject, const EntryVec& table)
+*/
+static void
+test_gnc_sql_object_in_db (void)
+{
+    auto conn{new GncMockSqlConnection};
+    const EntryVec table
+    {
+        gnc_sql_make_table_entry<CT_GUID>("guid", 0, COL_NNUL | COL_PKEY, "guid"),
+    };
+
+    qof_object_initialize ();
+    auto book = qof_book_new();
+    auto sql_be = new GncMockSqlBackend{conn, book};
+    auto inst = static_cast<QofInstance*> (g_object_new (QOF_TYPE_INSTANCE, NULL));
+    qof_instance_init_data (inst, QOF_ID_NULL, book);
+
+    /* The table's keys are read once, then kept up to date by writes. */
+    g_assert_false (sql_be->object_in_db ("foo", QOF_ID_NULL, inst, table));
+    g_assert_cmpint (conn->m_selects, == , 1);
+    g_assert_true (sql_be->do_db_operation (OP_DB_INSERT, "foo", QOF_ID_NULL,
+                                            inst, table));
+    g_assert_true (sql_be->object_in_db ("foo", QOF_ID_NULL, inst, table));
+    g_assert_true (sql_be->do_db_operation (OP_DB_DELETE, "foo", QOF_ID_NULL,
+                                            inst, table));
+    g_assert_false (sql_be->object_in_db ("foo", QOF_ID_NULL, inst, table));
+    /* Without UPSERT the check decides between INSERT and UPDATE. */
+    g_assert_true (sql_be->do_db_operation (OP_DB_UPSERT, "foo", QOF_ID_NULL,
+                                            inst, table));
+    g_assert_true (sql_be->object_in_db ("foo", QOF_ID_NULL, inst, table));
+    g_assert_cmpint (conn->m_selects, == , 1);
+
+    /* A rollback throws the keys away. */
+    conn->m_fail_commit = true;
+    sql_be->begin_group_commit ();
+    g_assert_false (sql_be->end_group_commit ());
+    g_assert_true (!sql_be->object_in_db ("foo", QOF_ID_NULL, inst, table));
+    g_assert_cmpint (conn->m_selects, == , 2);
+
+    g_object_unref (inst);
+    qof_book_destroy (book);
+    delete sql_be;
+}
 /* handle_and_term
 static void
 handle_and_term (QofQueryTerm* pTerm, GString* sql)// 2
@@ -852,6 +961,8 @@ test_suite_gnc_backend_sql (void)
 // GNC_TEST_ADD (suitename, "gnc sql rollback edit", Fixture, nullptr, test_gnc_sql_rollback_edit,  teardown);
 // GNC_TEST_ADD (suitename, "commit cb", Fixture, nullptr, test_commit_cb,  teardown);
     GNC_TEST_ADD_FUNC (suitename, "gnc sql commit edit", test_gnc_sql_commit_edit);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql group commit", test_gnc_sql_group_commit);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql object in db", test_gnc_sql_object_in_db);
 // GNC_TEST_ADD (suitename, "handle and term", Fixture, nullptr, test_handle_and_term,  teardown);
 // GNC_TEST_ADD (suitename, "compile query cb", Fixture, nullptr, test_compile_query_cb,  teardown);
 // GNC_TEST_ADD (suitename, "gnc sql compile query", Fixture, nullptr, test_gnc_sql_compile_query,  teardown);
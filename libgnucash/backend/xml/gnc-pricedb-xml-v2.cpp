@@ -27,6 +27,7 @@
 #include "gnc-pricedb-p.h"
 
 #include "gnc-xml.h"
+#include "gnc-xml-stream.hpp"
 #include "sixtp.h"
 #include "sixtp-utils.h"
 #include "sixtp-parsers.h"
@@ -507,3 +508,79 @@ gnc_pricedb_dom_tree_create (GNCPriceDB* db)
 {
     return gnc_pricedb_to_dom_tree (BAD_CAST "gnc:pricedb", db);
 }
+
+/* gnc_price_to_dom_tree gives up on a price that has no commodity or
+ * currency, or no date; the whole pricedb is then left out. */
+static gboolean
+price_is_writable (GNCPrice* p, gpointer data)
+{
+    if (!p)
+        return TRUE;
+
+    auto commodity = gnc_price_get_commodity (p);
+    auto currency = gnc_price_get_currency (p);
+
+    return commodity && currency &&
+           gnc_commodity_get_namespace (commodity) &&
+           gnc_commodity_get_mnemonic (commodity) &&
+           gnc_commodity_get_namespace (currency) &&
+           gnc_commodity_get_mnemonic (currency) &&
+           gnc_price_get_time64 (p) != INT64_MAX;
+}
+
+struct price_stream_data
+{
+    GncXmlStream* out;
+    void (*progress) (gpointer);
+    gpointer progress_data;
+};
+
+static gboolean
+price_to_stream (GNCPrice* p, gpointer data)
+{
+    auto sdata = static_cast<price_stream_data*> (data);
+    auto out = sdata->out;
+
+    if (!p)
+        return TRUE;
+
+    out->start ("price");
+    out->guid ("price:id", gnc_price_get_guid (p));
+    out->commodity_ref ("price:commodity", gnc_price_get_commodity (p));
+    out->commodity_ref ("price:currency", gnc_price_get_currency (p));
+    out->timestamp ("price:time", gnc_price_get_time64 (p));
+
+    auto sourcestr = gnc_price_get_source_string (p);
+    if (sourcestr && *sourcestr)
+        out->text ("price:source", sourcestr);
+
+    auto typestr = gnc_price_get_typestr (p);
+    if (typestr && *typestr)
+        out->text ("price:type", typestr);
+
+    out->numeric ("price:value", gnc_price_get_value (p));
+    out->end ("price");
+
+    if (sdata->progress)
+        sdata->progress (sdata->progress_data);
+
+    return out->ok ();
+}
+
+gboolean
+gnc_pricedb_stream_write (GncXmlStream& out, GNCPriceDB* db,
+                          void (*progress) (gpointer), gpointer data)
+{
+    price_stream_data sdata { &out, progress, data };
+
+    if (!db || gnc_pricedb_get_num_prices (db) == 0 ||
+        !gnc_pricedb_foreach_price (db, price_is_writable, NULL, FALSE))
+        return TRUE;
+
+    out.start ("gnc:pricedb", "version", "1");
+    if (!gnc_pricedb_foreach_price (db, price_to_stream, &sdata, TRUE))
+        return FALSE;
+    out.end ("gnc:pricedb");
+
+    return out.flush ();
+}
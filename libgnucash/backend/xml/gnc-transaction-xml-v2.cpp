@@ -41,11 +41,20 @@
 #include "sixtp-dom-generators.h"
 
 #include "gnc-xml.h"
+#include "gnc-xml-stream.hpp"
 
 #include "io-gncxml-gen.h"
 
 #include "sixtp-dom-parsers.h"
 
+#include <kvp-frame.hpp>
+#include <qofinstance-p.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 [[maybe_unused]] static const QofLogModule log_module = G_LOG_DOMAIN;
 const gchar* transaction_version_string = "2.0.0";
 
@@ -191,12 +200,214 @@ gnc_transaction_dom_tree_create (Transaction* trn)
     return ret;
 }
 
+/* The streaming counterparts of split_to_dom_tree and
+ * gnc_transaction_dom_tree_create; the output must stay identical. */
+static void
+split_to_stream (GncXmlStream& out, const gchar* tag, Split* spl)
+{
+    out.start (tag);
+
+    out.guid ("split:id", xaccSplitGetGUID (spl));
+
+    auto memo = xaccSplitGetMemo (spl);
+    if (memo && *memo)
+        out.text ("split:memo", memo);
+
+    auto action = xaccSplitGetAction (spl);
+    if (action && *action)
+        out.text ("split:action", action);
+
+    char tmp[2] = { xaccSplitGetReconcile (spl), '\0' };
+    out.text ("split:reconciled-state", tmp);
+
+    auto reconciled = xaccSplitGetDateReconciled (spl);
+    if (reconciled)
+        out.timestamp ("split:reconcile-date", reconciled);
+
+    out.numeric ("split:value", xaccSplitGetValue (spl));
+    out.numeric ("split:quantity", xaccSplitGetAmount (spl));
+
+    out.guid ("split:account", xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+
+    GNCLot* lot = xaccSplitGetLot (spl);
+    if (lot)
+        out.guid ("split:lot", gnc_lot_get_guid (lot));
+
+    out.slots ("split:slots", QOF_INSTANCE (spl));
+
+    out.end (tag);
+}
+
+void
+gnc_transaction_stream_write (GncXmlStream& out, Transaction* trn)
+{
+    out.start ("gnc:transaction", "version", transaction_version_string);
+
+    out.guid ("trn:id", xaccTransGetGUID (trn));
+    out.commodity_ref ("trn:currency", xaccTransGetCurrency (trn));
+
+    auto num = xaccTransGetNum (trn);
+    if (num && *num)
+        out.text ("trn:num", num);
+
+    out.timestamp ("trn:date-posted", xaccTransRetDatePosted (trn));
+    out.timestamp ("trn:date-entered", xaccTransRetDateEntered (trn));
+
+    auto description = xaccTransGetDescription (trn);
+    if (description)
+        out.text ("trn:description", description);
+
+    out.slots ("trn:slots", QOF_INSTANCE (trn));
+
+    out.start ("trn:splits");
+    for (GList* n = xaccTransGetSplitList (trn); n; n = n->next)
+        split_to_stream (out, "trn:split", static_cast<Split*> (n->data));
+    out.end ("trn:splits");
+
+    out.end ("gnc:transaction");
+}
+
+/***********************************************************************/
+
+/* Values read out of a transaction's DOM tree ahead of time, keyed by the
+ * element they came from.  The conversions here don't touch the book, so the
+ * pipelined loader fills this in on a worker thread; the handlers below use
+ * an entry when there is one and parse the element themselves otherwise. */
+struct trn_preparse
+{
+    std::unordered_map<xmlNodePtr, GncGUID> guids;
+    std::unordered_map<xmlNodePtr, gnc_numeric> numerics;
+    std::unordered_map<xmlNodePtr, time64> times;
+    std::unordered_map<xmlNodePtr, std::unique_ptr<KvpFrame>> slots;
+};
+
+static GncGUID*
+pre_guid (xmlNodePtr node, trn_preparse* pre)
+{
+    if (pre)
+    {
+        auto it = pre->guids.find (node);
+        if (it != pre->guids.end ())
+            return guid_copy (&it->second);
+    }
+    return dom_tree_to_guid (node);
+}
+
+static gnc_numeric
+pre_numeric (xmlNodePtr node, trn_preparse* pre)
+{
+    if (pre)
+    {
+        auto it = pre->numerics.find (node);
+        if (it != pre->numerics.end ())
+            return it->second;
+    }
+    return dom_tree_to_gnc_numeric (node);
+}
+
+static time64
+pre_time64 (xmlNodePtr node, trn_preparse* pre)
+{
+    if (pre)
+    {
+        auto it = pre->times.find (node);
+        if (it != pre->times.end ())
+            return it->second;
+    }
+    return dom_tree_to_time64 (node);
+}
+
+static gboolean
+pre_instance_slots (xmlNodePtr node, QofInstance* inst, trn_preparse* pre)
+{
+    if (pre)
+    {
+        auto it = pre->slots.find (node);
+        /* A ready-made frame can only stand in for one that's still empty. */
+        if (it != pre->slots.end () && qof_instance_get_slots (inst)->empty ())
+        {
+            /* Merging into the old frame wouldn't have dirtied it. */
+            gboolean dirty = qof_instance_get_dirty_flag (inst);
+            qof_instance_set_slots (inst, it->second.release ());
+            qof_instance_set_dirty_flag (inst, dirty);
+            pre->slots.erase (it);
+            return TRUE;
+        }
+    }
+    return dom_tree_create_instance_slots (node, inst);
+}
+
+static void
+preparse_guid (xmlNodePtr node, trn_preparse* pre)
+{
+    GncGUID* id = dom_tree_to_guid (node);
+    if (!id)
+        return;
+    pre->guids.emplace (node, *id);
+    guid_free (id);
+}
+
+static void
+preparse_slots (xmlNodePtr node, trn_preparse* pre)
+{
+    KvpFrame* frame = dom_tree_to_kvp_frame (node);
+    if (frame)
+        pre->slots.emplace (node, frame);
+}
+
+static void
+preparse_split (xmlNodePtr node, trn_preparse* pre)
+{
+    for (xmlNodePtr mark = node->xmlChildrenNode; mark; mark = mark->next)
+    {
+        const char* name = (const char*)mark->name;
+
+        if (g_strcmp0 (name, "split:id") == 0 ||
+            g_strcmp0 (name, "split:account") == 0 ||
+            g_strcmp0 (name, "split:lot") == 0)
+            preparse_guid (mark, pre);
+        else if (g_strcmp0 (name, "split:value") == 0 ||
+                 g_strcmp0 (name, "split:quantity") == 0)
+            pre->numerics.emplace (mark, dom_tree_to_gnc_numeric (mark));
+        else if (g_strcmp0 (name, "split:reconcile-date") == 0)
+            pre->times.emplace (mark, dom_tree_to_time64 (mark));
+        else if (g_strcmp0 (name, "split:slots") == 0)
+            preparse_slots (mark, pre);
+    }
+}
+
+/* Everything done here must be safe to run off the main thread: no book,
+ * no engine objects, and no dom_tree_generic_parse (its tables are shared). */
+static void
+preparse_transaction (xmlNodePtr node, trn_preparse* pre)
+{
+    for (xmlNodePtr mark = node->xmlChildrenNode; mark; mark = mark->next)
+    {
+        const char* name = (const char*)mark->name;
+
+        if (g_strcmp0 (name, "trn:id") == 0)
+            preparse_guid (mark, pre);
+        else if (g_strcmp0 (name, "trn:date-posted") == 0 ||
+                 g_strcmp0 (name, "trn:date-entered") == 0)
+            pre->times.emplace (mark, dom_tree_to_time64 (mark));
+        else if (g_strcmp0 (name, "trn:slots") == 0)
+            preparse_slots (mark, pre);
+        else if (g_strcmp0 (name, "trn:splits") == 0)
+        {
+            for (xmlNodePtr spl = mark->xmlChildrenNode; spl; spl = spl->next)
+                if (g_strcmp0 ((const char*)spl->name, "trn:split") == 0)
+                    preparse_split (spl, pre);
+        }
+    }
+}
+
 /***********************************************************************/
 
 struct split_pdata
 {
     Split* split;
     QofBook* book;
+    trn_preparse* pre;
 };
 
 static inline gboolean
@@ -214,10 +425,10 @@ set_spl_string (xmlNodePtr node, Split* spl,
 }
 
 static inline gboolean
-set_spl_gnc_num (xmlNodePtr node, Split* spl,
+set_spl_gnc_num (xmlNodePtr node, struct split_pdata* pdata,
                  void (*func) (Split* spl, gnc_numeric gn))
 {
-    func (spl, dom_tree_to_gnc_numeric (node));
+    func (pdata->split, pre_numeric (node, pdata->pre));
     return TRUE;
 }
 
@@ -225,7 +436,7 @@ static gboolean
 spl_id_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    GncGUID* tmp = dom_tree_to_guid (node);
+    GncGUID* tmp = pre_guid (node, pdata->pre);
     g_return_val_if_fail (tmp, FALSE);
 
     xaccSplitSetGUID (pdata->split, tmp);
@@ -266,7 +477,7 @@ static gboolean
 spl_reconcile_date_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    time64 time  = dom_tree_to_time64 (node);
+    time64 time  = pre_time64 (node, pdata->pre);
     if (!dom_tree_valid_time64 (time, node->name)) time = 0;
     xaccSplitSetDateReconciledSecs (pdata->split, time);
     return TRUE;
@@ -276,14 +487,14 @@ static gboolean
 spl_value_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    return set_spl_gnc_num (node, pdata->split, xaccSplitSetValue);
+    return set_spl_gnc_num (node, pdata, xaccSplitSetValue);
 }
 
 static gboolean
 spl_quantity_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    return set_spl_gnc_num (node, pdata->split, xaccSplitSetAmount);
+    return set_spl_gnc_num (node, pdata, xaccSplitSetAmount);
 }
 
 gboolean gnc_transaction_xml_v2_testing = FALSE;
@@ -292,7 +503,7 @@ static gboolean
 spl_account_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    GncGUID* id = dom_tree_to_guid (node);
+    GncGUID* id = pre_guid (node, pdata->pre);
     Account* account;
 
     g_return_val_if_fail (id, FALSE);
@@ -318,7 +529,7 @@ static gboolean
 spl_lot_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    GncGUID* id = dom_tree_to_guid (node);
+    GncGUID* id = pre_guid (node, pdata->pre);
     GNCLot* lot;
 
     g_return_val_if_fail (id, FALSE);
@@ -344,8 +555,8 @@ spl_slots_handler (xmlNodePtr node, gpointer data)
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
     gboolean successful;
 
-    successful = dom_tree_create_instance_slots (node,
-                                                 QOF_INSTANCE (pdata->split));
+    successful = pre_instance_slots (node, QOF_INSTANCE (pdata->split),
+                                     pdata->pre);
     g_return_val_if_fail (successful, FALSE);
 
     return TRUE;
@@ -367,7 +578,7 @@ struct dom_tree_handler spl_dom_handlers[] =
 };
 
 static Split*
-dom_tree_to_split (xmlNodePtr node, QofBook* book)
+dom_tree_to_split (xmlNodePtr node, QofBook* book, trn_preparse* pre)
 {
     struct split_pdata pdata;
     Split* ret;
@@ -379,6 +590,7 @@ dom_tree_to_split (xmlNodePtr node, QofBook* book)
 
     pdata.split = ret;
     pdata.book = book;
+    pdata.pre = pre;
 
     /* this isn't going to work in a testing setup */
     if (dom_tree_generic_parse (node, spl_dom_handlers, &pdata))
@@ -398,6 +610,7 @@ struct trans_pdata
 {
     Transaction* trans;
     QofBook* book;
+    trn_preparse* pre;
 };
 
 static inline gboolean
@@ -418,10 +631,11 @@ set_tran_string (xmlNodePtr node, Transaction* trn,
 }
 
 static gboolean
-set_tran_time64 (xmlNodePtr node, Transaction * trn,
+set_tran_time64 (xmlNodePtr node, struct trans_pdata* pdata,
         void (*func) (Transaction *, time64))
 {
-    time64 time = dom_tree_to_time64 (node);
+    Transaction* trn = pdata->trans;
+    time64 time = pre_time64 (node, pdata->pre);
     if (!dom_tree_valid_time64 (time, node->name)) time = 0;
     func (trn, time);
     return TRUE;
@@ -432,7 +646,7 @@ trn_id_handler (xmlNodePtr node, gpointer trans_pdata)
 {
     struct trans_pdata* pdata = static_cast<decltype (pdata)> (trans_pdata);
     Transaction* trn = pdata->trans;
-    GncGUID* tmp = dom_tree_to_guid (node);
+    GncGUID* tmp = pre_guid (node, pdata->pre);
 
     g_return_val_if_fail (tmp, FALSE);
 
@@ -469,18 +683,16 @@ static gboolean
 trn_date_posted_handler (xmlNodePtr node, gpointer trans_pdata)
 {
     struct trans_pdata* pdata = static_cast<decltype (pdata)> (trans_pdata);
-    Transaction* trn = pdata->trans;
 
-    return set_tran_time64 (node, trn, xaccTransSetDatePostedSecs);
+    return set_tran_time64 (node, pdata, xaccTransSetDatePostedSecs);
 }
 
 static gboolean
 trn_date_entered_handler (xmlNodePtr node, gpointer trans_pdata)
 {
     struct trans_pdata* pdata = static_cast<decltype (pdata)> (trans_pdata);
-    Transaction* trn = pdata->trans;
 
-    return set_tran_time64 (node, trn, xaccTransSetDateEnteredSecs);
+    return set_tran_time64 (node, pdata, xaccTransSetDateEnteredSecs);
 }
 
 static gboolean
@@ -499,7 +711,7 @@ trn_slots_handler (xmlNodePtr node, gpointer trans_pdata)
     Transaction* trn = pdata->trans;
     gboolean successful;
 
-    successful = dom_tree_create_instance_slots (node, QOF_INSTANCE (trn));
+    successful = pre_instance_slots (node, QOF_INSTANCE (trn), pdata->pre);
 
     g_return_val_if_fail (successful, FALSE);
 
@@ -528,7 +740,7 @@ trn_splits_handler (xmlNodePtr node, gpointer trans_pdata)
             return FALSE;
         }
 
-        spl = dom_tree_to_split (mark, pdata->book);
+        spl = dom_tree_to_split (mark, pdata->book, pdata->pre);
 
         if (spl)
         {
@@ -555,6 +767,183 @@ struct dom_tree_handler trn_dom_handlers[] =
     { NULL, NULL, 0, 0 },
 };
 
+static Transaction*
+dom_tree_to_transaction_pre (xmlNodePtr node, QofBook* book,
+                             trn_preparse* pre);
+
+/* Pipelined loading.  While a pipeline is active the transaction parser
+ * doesn't build each transaction as its element closes: the subtree is
+ * queued, a pool thread does the book-independent conversions into a
+ * trn_preparse, and the transactions are then built and handed to the
+ * parse callback strictly in file order on the parsing thread.  Only that
+ * last step touches the engine, so it is never run concurrently. */
+#define TRN_PIPELINE_MAX_THREADS 4
+#define TRN_PIPELINE_DEPTH 64
+
+struct trn_load_job
+{
+    xmlNodePtr tree;
+    std::string tag;
+    gxpf_data gdata;
+    trn_preparse pre;
+    gboolean ready;
+};
+
+struct trn_load_pipeline
+{
+    GThreadPool* pool;
+    GMutex mutex;
+    GCond ready_cond;
+    std::deque<trn_load_job*> jobs;
+    guint max_pending;
+    gboolean ok;
+};
+
+static trn_load_pipeline* trn_pipeline = NULL;
+
+static void
+trn_pipeline_worker (gpointer data, gpointer user_data)
+{
+    trn_load_job* job = static_cast<decltype (job)> (data);
+    trn_load_pipeline* pl = static_cast<decltype (pl)> (user_data);
+
+    preparse_transaction (job->tree, &job->pre);
+
+    g_mutex_lock (&pl->mutex);
+    job->ready = TRUE;
+    g_cond_broadcast (&pl->ready_cond);
+    g_mutex_unlock (&pl->mutex);
+}
+
+static void
+trn_pipeline_finish_job (trn_load_pipeline* pl, trn_load_job* job)
+{
+    /* Once something has failed the parse is being abandoned, so the
+     * rest of the queue is only cleaned up. */
+    if (pl->ok)
+    {
+        auto book = static_cast<QofBook*> (job->gdata.bookdata);
+        Transaction* trn = dom_tree_to_transaction_pre (job->tree, book,
+                                                        &job->pre);
+        if (trn != NULL)
+            job->gdata.cb (job->tag.c_str (), job->gdata.parsedata, trn);
+        else
+            pl->ok = FALSE;
+    }
+
+    xmlFreeNode (job->tree);
+    delete job;
+}
+
+/* Build every queued transaction that is ready, in order, stopping at the
+ * first one that isn't.  Waits for the head of the queue only while more
+ * than max_pending jobs are outstanding. */
+static gboolean
+trn_pipeline_drain (trn_load_pipeline* pl, guint max_pending)
+{
+    g_mutex_lock (&pl->mutex);
+    while (!pl->jobs.empty ())
+    {
+        trn_load_job* job = pl->jobs.front ();
+
+        if (!job->ready)
+        {
+            if (pl->jobs.size () <= max_pending)
+                break;
+            g_cond_wait (&pl->ready_cond, &pl->mutex);
+            continue;
+        }
+
+        pl->jobs.pop_front ();
+        g_mutex_unlock (&pl->mutex);
+        trn_pipeline_finish_job (pl, job);
+        g_mutex_lock (&pl->mutex);
+    }
+    g_mutex_unlock (&pl->mutex);
+
+    return pl->ok;
+}
+
+static gboolean
+trn_pipeline_push (trn_load_pipeline* pl, xmlNodePtr tree, const gchar* tag,
+                   gxpf_data* gdata)
+{
+    auto job = new trn_load_job;
+
+    job->tree = tree;
+    job->tag = tag;
+    job->gdata = *gdata;
+    job->ready = FALSE;
+
+    g_mutex_lock (&pl->mutex);
+    pl->jobs.push_back (job);
+    g_mutex_unlock (&pl->mutex);
+
+    g_thread_pool_push (pl->pool, job, NULL);
+
+    return trn_pipeline_drain (pl, pl->max_pending);
+}
+
+void
+gnc_transaction_xml_pipeline_begin (void)
+{
+    guint n_threads;
+
+    g_return_if_fail (trn_pipeline == NULL);
+
+    /* The parsing thread builds the transactions, so leave it a core. */
+    n_threads = MIN ((guint)g_get_num_processors () - 1,
+                     TRN_PIPELINE_MAX_THREADS);
+    if (n_threads < 1)
+        return;
+
+    auto pl = new trn_load_pipeline;
+    g_mutex_init (&pl->mutex);
+    g_cond_init (&pl->ready_cond);
+    pl->max_pending = n_threads * TRN_PIPELINE_DEPTH;
+    pl->ok = TRUE;
+    pl->pool = g_thread_pool_new (trn_pipeline_worker, pl, n_threads,
+                                  TRUE, NULL);
+    if (!pl->pool)
+    {
+        g_mutex_clear (&pl->mutex);
+        g_cond_clear (&pl->ready_cond);
+        delete pl;
+        return;
+    }
+
+    trn_pipeline = pl;
+}
+
+gboolean
+gnc_transaction_xml_pipeline_flush (void)
+{
+    if (!trn_pipeline)
+        return TRUE;
+
+    return trn_pipeline_drain (trn_pipeline, 0);
+}
+
+gboolean
+gnc_transaction_xml_pipeline_end (void)
+{
+    trn_load_pipeline* pl = trn_pipeline;
+    gboolean ok;
+
+    if (!pl)
+        return TRUE;
+
+    ok = trn_pipeline_drain (pl, 0);
+    trn_pipeline = NULL;
+
+    g_thread_pool_free (pl->pool, FALSE, TRUE);
+    g_mutex_clear (&pl->mutex);
+    g_cond_clear (&pl->ready_cond);
+    delete pl;
+
+    return ok;
+}
+
 static gboolean
 gnc_transaction_end_handler (gpointer data_for_children,
                              GSList* data_from_children, GSList* sibling_data,
@@ -579,6 +968,9 @@ gnc_transaction_end_handler (gpointer data_for_children,
 
     g_return_val_if_fail (tree, FALSE);
 
+    if (trn_pipeline)
+        return trn_pipeline_push (trn_pipeline, tree, tag, gdata);
+
     trn = dom_tree_to_transaction (tree,
                                    static_cast<QofBook*> (gdata->bookdata));
     if (trn != NULL)
@@ -593,6 +985,13 @@ gnc_transaction_end_handler (gpointer data_for_children,
 
 Transaction*
 dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
+{
+    return dom_tree_to_transaction_pre (node, book, NULL);
+}
+
+static Transaction*
+dom_tree_to_transaction_pre (xmlNodePtr node, QofBook* book,
+                             trn_preparse* pre)
 {
     Transaction* trn;
     gboolean successful;
@@ -607,6 +1006,7 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
 
     pdata.trans = trn;
     pdata.book = book;
+    pdata.pre = pre;
 
     successful = dom_tree_generic_parse (node, trn_dom_handlers, &pdata);
 
@@ -407,6 +407,8 @@ GncXmlBackend::write_to_file (bool make_backup)
         }
     }
 
+    gnc_xml_set_compression (gnc_prefs_get_file_compression_level (),
+                             gnc_prefs_get_file_compression_threads ());
     if (gnc_book_write_to_xml_file_v2 (m_book, tmp_name,
                                        gnc_prefs_get_file_save_compressed ()))
     {
@@ -0,0 +1,356 @@
+/********************************************************************
+ * gnc-xml-stream.cpp: Stream v2 XML without building a DOM tree.   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+#include <glib.h>
+
+#include <config.h>
+
+#include <gnc-date.h>
+
+#include "gnc-xml-helper.h"
+#include "gnc-xml-stream.hpp"
+#include "sixtp-dom-generators.h"
+
+#include <kvp-frame.hpp>
+#include <gnc-datetime.hpp>
+
+[[maybe_unused]] static QofLogModule log_module = GNC_MOD_IO;
+
+/* Write to the file once this much has been collected. */
+static const size_t STREAM_BUFFER_SIZE = 64 * 1024;
+
+/* libxml2 stops indenting deeper than this many levels. */
+static const int STREAM_MAX_INDENT = 30;
+
+GncXmlStream::GncXmlStream (FILE* out, int level) :
+    m_out{out}, m_level{level}
+{
+    m_buf.reserve (STREAM_BUFFER_SIZE + 1024);
+}
+
+GncXmlStream::~GncXmlStream ()
+{
+    flush ();
+}
+
+bool
+GncXmlStream::flush ()
+{
+    if (!m_buf.empty ())
+    {
+        if (fwrite (m_buf.data (), 1, m_buf.size (), m_out) != m_buf.size ())
+        {
+            m_buf.clear ();
+            return false;
+        }
+        m_buf.clear ();
+    }
+    return ok ();
+}
+
+void
+GncXmlStream::maybe_flush ()
+{
+    if (m_buf.size () >= STREAM_BUFFER_SIZE)
+        flush ();
+}
+
+void
+GncXmlStream::indent ()
+{
+    m_buf.append (2 * MIN (m_level, STREAM_MAX_INDENT), ' ');
+}
+
+void
+GncXmlStream::close_pending ()
+{
+    if (!m_pending)
+        return;
+    m_buf += ">\n";
+    m_pending = false;
+}
+
+void
+GncXmlStream::open_tag (const char* tag, const char* attr, const char* value)
+{
+    close_pending ();
+    indent ();
+    m_buf += '<';
+    m_buf += tag;
+    if (attr)
+    {
+        m_buf += ' ';
+        m_buf += attr;
+        m_buf += "=\"";
+        m_buf += value;
+        m_buf += '"';
+    }
+}
+
+/* Does what checked_char_cast() and libxml2's text escaping do together:
+ * bad UTF-8 and control characters other than tab, newline and carriage
+ * return become '?', and <, >, & and CR become entities. */
+void
+GncXmlStream::escaped (const char* str)
+{
+    gchar* checked = nullptr;
+
+    if (!g_utf8_validate (str, -1, nullptr))
+    {
+        checked = g_strdup (str);
+        checked_char_cast (checked);
+        str = checked;
+    }
+
+    for (auto p = str; *p; ++p)
+    {
+        auto c = static_cast<unsigned char> (*p);
+        switch (c)
+        {
+        case '<':
+            m_buf += "&lt;";
+            break;
+        case '>':
+            m_buf += "&gt;";
+            break;
+        case '&':
+            m_buf += "&amp;";
+            break;
+        case '\r':
+            m_buf += "&#13;";
+            break;
+        case '\t':
+        case '\n':
+            m_buf += *p;
+            break;
+        default:
+            m_buf += c < 0x20 ? '?' : *p;
+            break;
+        }
+    }
+
+    g_free (checked);
+}
+
+void
+GncXmlStream::start (const char* tag, const char* attr, const char* value)
+{
+    open_tag (tag, attr, value);
+    m_pending = true;
+    ++m_level;
+}
+
+void
+GncXmlStream::end (const char* tag)
+{
+    --m_level;
+    if (m_pending)
+    {
+        m_buf += "/>\n";
+        m_pending = false;
+    }
+    else
+    {
+        indent ();
+        m_buf += "</";
+        m_buf += tag;
+        m_buf += ">\n";
+    }
+    maybe_flush ();
+}
+
+void
+GncXmlStream::text (const char* tag, const char* str, const char* attr,
+                    const char* value)
+{
+    open_tag (tag, attr, value);
+    if (!str)
+    {
+        m_buf += "/>\n";
+        return;
+    }
+    m_buf += '>';
+    escaped (str);
+    m_buf += "</";
+    m_buf += tag;
+    m_buf += ">\n";
+}
+
+void
+GncXmlStream::guid (const char* tag, const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (gid, guid_str))
+    {
+        PERR ("guid_to_string_buff failed\n");
+        return;
+    }
+    text (tag, guid_str, "type", "guid");
+}
+
+void
+GncXmlStream::commodity_ref (const char* tag, const gnc_commodity* c)
+{
+    g_return_if_fail (c);
+
+    auto name_space = gnc_commodity_get_namespace (c);
+    auto mnemonic = gnc_commodity_get_mnemonic (c);
+    if (!name_space || !mnemonic)
+        return;
+
+    start (tag);
+    text ("cmdty:space", name_space);
+    text ("cmdty:id", mnemonic);
+    end (tag);
+}
+
+void
+GncXmlStream::timestamp (const char* tag, time64 time, const char* type)
+{
+    g_return_if_fail (time != INT64_MAX);
+    auto date_str = GncDateTime(time).format_iso8601();
+    if (date_str.empty())
+        return;
+    date_str += " +0000"; //Tack on a UTC offset to mollify GnuCash for Android
+    start (tag, type ? "type" : nullptr, type);
+    text ("ts:date", date_str.c_str ());
+    end (tag);
+}
+
+void
+GncXmlStream::gdate (const char* tag, const GDate* date, const char* type)
+{
+    gchar date_str[512] = "";
+
+    g_return_if_fail (date);
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+
+    start (tag, type ? "type" : nullptr, type);
+    text ("gdate", date_str);
+    end (tag);
+}
+
+void
+GncXmlStream::numeric (const char* tag, gnc_numeric num)
+{
+    gchar* numstr = gnc_numeric_to_string (num);
+    g_return_if_fail (numstr);
+
+    text (tag, numstr);
+    g_free (numstr);
+}
+
+/* Mirrors add_kvp_value_node() in sixtp-dom-generators.cpp. */
+void
+GncXmlStream::kvp_value (const char* tag, KvpValue* val)
+{
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::INT64:
+    {
+        char *int_str = g_strdup_printf ("%" G_GINT64_FORMAT, val->get<int64_t> ());
+        text (tag, int_str, "type", "integer");
+        g_free (int_str);
+        break;
+    }
+    case KvpValue::Type::DOUBLE:
+    {
+        char *dbl_str = double_to_string (val->get<double> ());
+        text (tag, dbl_str, "type", "double");
+        g_free (dbl_str);
+        break;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        char *num_str = gnc_numeric_to_string (val->get<gnc_numeric> ());
+        text (tag, num_str, "type", "numeric");
+        g_free (num_str);
+        break;
+    }
+    case KvpValue::Type::STRING:
+        text (tag, val->get<const char*> (), "type", "string");
+        break;
+    case KvpValue::Type::GUID:
+    {
+        gchar guidstr[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff (val->get<GncGUID*> (), guidstr);
+        text (tag, guidstr, "type", "guid");
+        break;
+    }
+    /* Note: The type attribute must remain 'timespec' to maintain
+     * compatibility.
+     */
+    case KvpValue::Type::TIME64:
+    {
+        auto t = val->get<Time64> ();
+        if (t.t != INT64_MAX)
+            timestamp (tag, t.t, "timespec");
+        break;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate> ();
+        gdate (tag, &d, "gdate");
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        start (tag, "type", "list");
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+            kvp_value ("slot:value", static_cast<KvpValue*> (cursor->data));
+        end (tag);
+        break;
+    case KvpValue::Type::FRAME:
+    {
+        start (tag, "type", "frame");
+        auto frame = val->get<KvpFrame*> ();
+        if (frame)
+            frame->for_each_slot_temp ([this] (const char* key, KvpValue* value)
+                                       { kvp_slot (key, value); });
+        end (tag);
+        break;
+    }
+    default:
+        text (tag, nullptr);
+        break;
+    }
+}
+
+void
+GncXmlStream::kvp_slot (const char* key, KvpValue* val)
+{
+    start ("slot");
+    text ("slot:key", key);
+    kvp_value ("slot:value", val);
+    end ("slot");
+}
+
+void
+GncXmlStream::slots (const char* tag, const QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    if (!frame || frame->empty ())
+        return;
+
+    start (tag);
+    frame->for_each_slot_temp ([this] (const char* key, KvpValue* value)
+                               { kvp_slot (key, value); });
+    end (tag);
+}
@@ -0,0 +1,88 @@
+/********************************************************************
+ * gnc-xml-stream.hpp: Stream v2 XML without building a DOM tree.   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#ifndef GNC_XML_STREAM_HPP
+#define GNC_XML_STREAM_HPP
+
+#include <glib.h>
+#include <stdio.h>
+
+#include <string>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+
+/** Buffered writer producing exactly the text that xmlElemDump() gives for
+ *  the trees built by the sixtp-dom-generators.cpp functions: two spaces of
+ *  indentation per level, element-only content on separate lines, text
+ *  content inline and escaped, and childless elements written as <tag/>.
+ *
+ *  Elements are opened with start() and closed with end(); whether an
+ *  element is empty is only known when it is closed, so the end of the
+ *  start tag is held back until the first child arrives.
+ */
+class GncXmlStream
+{
+public:
+    /** @param out The file to write to.
+     *  @param level The indentation level of the first element written. */
+    GncXmlStream (FILE* out, int level = 0);
+    GncXmlStream (const GncXmlStream&) = delete;
+    GncXmlStream& operator= (const GncXmlStream&) = delete;
+    ~GncXmlStream ();
+
+    /** Write out anything buffered.  @return false on a write error. */
+    bool flush ();
+    /** @return false once a write error has occurred. */
+    bool ok () const { return !ferror (m_out); }
+
+    void start (const char* tag, const char* attr = nullptr,
+                const char* value = nullptr);
+    void end (const char* tag);
+    /** An element holding just text.  A null text gives an empty element. */
+    void text (const char* tag, const char* str, const char* attr = nullptr,
+               const char* value = nullptr);
+
+    /* Counterparts of the sixtp-dom-generators.cpp functions. */
+    void guid (const char* tag, const GncGUID* gid);
+    void commodity_ref (const char* tag, const gnc_commodity* c);
+    void timestamp (const char* tag, time64 time, const char* type = nullptr);
+    void gdate (const char* tag, const GDate* date,
+                const char* type = nullptr);
+    void numeric (const char* tag, gnc_numeric num);
+    void slots (const char* tag, const QofInstance* inst);
+
+private:
+    void kvp_value (const char* tag, KvpValue* val);
+    void kvp_slot (const char* key, KvpValue* val);
+    void open_tag (const char* tag, const char* attr, const char* value);
+    void close_pending ();
+    void indent ();
+    void escaped (const char* str);
+    void maybe_flush ();
+
+    FILE* m_out;
+    std::string m_buf;
+    int m_level;
+    bool m_pending = false;
+};
+
+#endif /* GNC_XML_STREAM_HPP */
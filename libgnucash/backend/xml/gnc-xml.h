@@ -33,6 +33,8 @@
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
 
+class GncXmlStream;
+
 xmlNodePtr gnc_account_dom_tree_create (Account* act, gboolean exporting,
                                         gboolean allow_incompat);
 sixtp* gnc_account_sixtp_parser_create (void);
@@ -52,6 +54,10 @@ sixtp* gnc_lot_sixtp_parser_create (void);
 
 xmlNodePtr gnc_pricedb_dom_tree_create (GNCPriceDB* db);
 sixtp* gnc_pricedb_sixtp_parser_create (void);
+/* Writes the same text as dumping gnc_pricedb_dom_tree_create's tree,
+ * calling progress after each price.  Returns FALSE on a write error. */
+gboolean gnc_pricedb_stream_write (GncXmlStream& out, GNCPriceDB* db,
+                                   void (*progress) (gpointer), gpointer data);
 
 xmlNodePtr gnc_schedXaction_dom_tree_create (SchedXaction* sx);
 sixtp* gnc_schedXaction_sixtp_parser_create (void);
@@ -60,8 +66,19 @@ xmlNodePtr gnc_budget_dom_tree_create (GncBudget* bgt);
 sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
+/* Writes the same text as dumping gnc_transaction_dom_tree_create's tree. */
+void gnc_transaction_stream_write (GncXmlStream& out, Transaction* txn);
 sixtp* gnc_transaction_sixtp_parser_create (void);
 
+/* While the transaction pipeline is running, transactions read by the
+ * parser from gnc_transaction_sixtp_parser_create are converted on worker
+ * threads and added to the book in file order on the calling thread.
+ * _flush adds everything still queued; _end flushes and stops the
+ * workers.  Both return FALSE if any queued transaction failed to load. */
+void gnc_transaction_xml_pipeline_begin (void);
+gboolean gnc_transaction_xml_pipeline_flush (void);
+gboolean gnc_transaction_xml_pipeline_end (void);
+
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
 
 #endif /* GNC_XML_H */
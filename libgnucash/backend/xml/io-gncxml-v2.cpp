@@ -45,6 +45,9 @@
 #include <zlib.h>
 #include <errno.h>
 
+#include <deque>
+#include <vector>
+
 #include "gnc-engine.h"
 #include "gnc-pricedb-p.h"
 #include "Scrub.h"
@@ -68,6 +71,7 @@
 #include "sixtp-parsers.h"
 #include "sixtp-utils.h"
 #include "gnc-xml.h"
+#include "gnc-xml-stream.hpp"
 #include "io-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "io-gncxml-v2.h"
@@ -81,8 +85,15 @@ typedef struct
     gchar* filename;
     gchar* perms;
     gboolean write;
+    gint level;
+    guint n_threads;
 } gz_thread_params_t;
 
+/* zlib level and number of deflate threads for compressed saves; 0
+ * threads means one per processor. */
+static gint gnc_xml_gz_level = Z_DEFAULT_COMPRESSION;
+static guint gnc_xml_gz_threads = 0;
+
 /* Callback structure */
 struct file_backend
 {
@@ -93,8 +104,35 @@ struct file_backend
     sixtp*          parser;
     FILE*           out;
     QofBook*        book;
+    GncXmlStream*   stream;
 };
 
+/* Write transactions and prices with GncXmlStream rather than building
+ * and dumping a DOM tree for each one. */
+static gboolean gnc_xml_streaming_writer = TRUE;
+
+void
+gnc_xml_set_streaming_writer (gboolean streaming)
+{
+    gnc_xml_streaming_writer = streaming;
+}
+
+gboolean
+gnc_xml_get_streaming_writer (void)
+{
+    return gnc_xml_streaming_writer;
+}
+
+void
+gnc_xml_set_compression (gint level, guint n_threads)
+{
+    g_return_if_fail (level >= Z_DEFAULT_COMPRESSION &&
+                      level <= Z_BEST_COMPRESSION);
+
+    gnc_xml_gz_level = level;
+    gnc_xml_gz_threads = n_threads;
+}
+
 static std::vector<GncXmlDataType_t> backend_registry;
 void
 gnc_xml_register_backend(GncXmlDataType_t& xmlbe)
@@ -677,6 +715,24 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+/* Transactions still in the loader pipeline have to be in the book before
+ * anything that follows them in the file is parsed. */
+static gboolean
+transaction_pipeline_before_child (gpointer data_for_children,
+                                   GSList* data_from_children,
+                                   GSList* sibling_data,
+                                   gpointer parent_data,
+                                   gpointer global_data,
+                                   gpointer* result,
+                                   const gchar* tag,
+                                   const gchar* child_tag)
+{
+    if (g_strcmp0 (child_tag, TRANSACTION_TAG) == 0)
+        return TRUE;
+
+    return gnc_transaction_xml_pipeline_flush ();
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full (
     GncXmlBackend* xml_be, QofBook* book,
@@ -757,9 +813,13 @@ qof_session_load_from_xml_file_v2_full (
     if (be_data.ok == FALSE)
         goto bail;
 
+    sixtp_set_before_child (main_parser, transaction_pipeline_before_child);
+    sixtp_set_before_child (book_parser, transaction_pipeline_before_child);
+
     /* stop logging while we load */
     xaccLogDisable ();
     xaccDisableDataScrubbing ();
+    gnc_transaction_xml_pipeline_begin ();
 
     if (push_handler)
     {
@@ -799,6 +859,10 @@ qof_session_load_from_xml_file_v2_full (
         }
     }
 
+    /* Always shut the pipeline down, even if the parse failed. */
+    if (!gnc_transaction_xml_pipeline_end ())
+        retval = FALSE;
+
     if (!retval)
     {
         sixtp_destroy (top_parser);
@@ -1086,6 +1150,15 @@ write_commodities (FILE* out, QofBook* book, sixtp_gdv2* gd)
     return success;
 }
 
+static void
+price_written (gpointer data)
+{
+    sixtp_gdv2* gd = static_cast<decltype (gd)> (data);
+
+    gd->counter.prices_loaded += 1;
+    sixtp_run_callback (gd, "prices");
+}
+
 static gboolean
 write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
@@ -1093,6 +1166,13 @@ write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
     xmlNodePtr parent;
     xmlOutputBufferPtr outbuf;
 
+    if (gnc_xml_streaming_writer)
+    {
+        GncXmlStream stream {out};
+        return gnc_pricedb_stream_write (stream, gnc_pricedb_get_db (book),
+                                         price_written, gd);
+    }
+
     parent = gnc_pricedb_dom_tree_create (gnc_pricedb_get_db (book));
 
     if (!parent)
@@ -1148,6 +1228,17 @@ xml_add_trn_data (Transaction* t, gpointer data)
     struct file_backend* be_data = static_cast<decltype (be_data)> (data);
     xmlNodePtr node;
 
+    if (be_data->stream)
+    {
+        gnc_transaction_stream_write (*be_data->stream, t);
+        if (!be_data->stream->ok ())
+            return -1;
+
+        be_data->gd->counter.transactions_loaded++;
+        sixtp_run_callback (be_data->gd, "transaction");
+        return 0;
+    }
+
     node = gnc_transaction_dom_tree_create (t);
 
     xmlElemDump (be_data->out, NULL, node);
@@ -1165,13 +1256,16 @@ static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     struct file_backend be_data;
+    GncXmlStream stream {out};
 
     be_data.out = out;
     be_data.gd = gd;
+    be_data.stream = gnc_xml_streaming_writer ? &stream : NULL;
     return 0 ==
            xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
                                               xml_add_trn_data,
-                                              (gpointer) &be_data);
+                                              (gpointer) &be_data)
+           && stream.flush ();
 }
 
 static gboolean
@@ -1179,9 +1273,11 @@ write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     Account* ra;
     struct file_backend be_data;
+    GncXmlStream stream {out};
 
     be_data.out = out;
     be_data.gd = gd;
+    be_data.stream = gnc_xml_streaming_writer ? &stream : NULL;
 
     ra = gnc_book_get_template_root (book);
     if (gnc_account_n_descendants (ra) > 0)
@@ -1189,6 +1285,7 @@ write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
         if (fprintf (out, "<%s>\n", TEMPLATE_TRANSACTION_TAG) < 0
             || !write_account_tree (out, ra, gd)
             || xaccAccountTreeForEachTransaction (ra, xml_add_trn_data, (gpointer)&be_data)
+            || !stream.flush ()
             || fprintf (out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
 
             return FALSE;
@@ -1403,37 +1500,232 @@ do_gzopen (const char* filename, const char* perms)
 
 constexpr uint32_t BUFLEN{4096};
 
+/* Compressed saves are deflated in independent blocks on a thread pool,
+ * the way pigz does it: each block is primed with the last 32k of the
+ * input before it so the ratio barely suffers, every block but the last
+ * ends on a sync flush so the raw deflate streams can simply be
+ * concatenated, and the result is wrapped in a single gzip member. */
+constexpr size_t GZ_BLOCK_SIZE{128 * 1024};
+constexpr size_t GZ_DICT_SIZE{32 * 1024};
+
+struct gz_block
+{
+    std::vector<Bytef> in;      /* Dictionary followed by the data. */
+    size_t dict_len;
+    std::vector<Bytef> out;
+    bool last;
+    bool done;
+    bool ok;
+};
+
+struct gz_writer
+{
+    GThreadPool* pool;
+    GMutex mutex;
+    GCond done_cond;
+    std::deque<gz_block*> blocks;
+    gint level;
+};
+
+static void
+gz_compress_block (gpointer data, gpointer user_data)
+{
+    gz_block* block = static_cast<decltype (block)> (data);
+    gz_writer* writer = static_cast<decltype (writer)> (user_data);
+    z_stream strm{};
+    bool ok;
+
+    ok = deflateInit2 (&strm, writer->level, Z_DEFLATED, -MAX_WBITS, 8,
+                       Z_DEFAULT_STRATEGY) == Z_OK;
+    if (ok && block->dict_len)
+        ok = deflateSetDictionary (&strm, block->in.data (),
+                                   block->dict_len) == Z_OK;
+    if (ok)
+    {
+        auto len = block->in.size () - block->dict_len;
+
+        /* deflateBound covers Z_FINISH; leave room for the flush marker. */
+        block->out.resize (deflateBound (&strm, len) + 16);
+        strm.next_in = block->in.data () + block->dict_len;
+        strm.avail_in = len;
+        strm.next_out = block->out.data ();
+        strm.avail_out = block->out.size ();
+
+        auto ret = deflate (&strm, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+        ok = (block->last ? ret == Z_STREAM_END : ret == Z_OK) &&
+             strm.avail_in == 0 && strm.avail_out > 0;
+        block->out.resize (strm.total_out);
+    }
+    deflateEnd (&strm);
+
+    g_mutex_lock (&writer->mutex);
+    block->ok = ok;
+    block->done = true;
+    g_cond_broadcast (&writer->done_cond);
+    g_mutex_unlock (&writer->mutex);
+}
+
+/* Write out finished blocks in order.  Waits for the oldest one while more
+ * than max_pending are outstanding. */
+static bool
+gz_write_blocks (gz_writer* writer, FILE* file, size_t max_pending,
+                 const gchar* filename)
+{
+    bool success = true;
+
+    g_mutex_lock (&writer->mutex);
+    while (!writer->blocks.empty ())
+    {
+        gz_block* block = writer->blocks.front ();
+
+        if (!block->done)
+        {
+            if (writer->blocks.size () <= max_pending)
+                break;
+            g_cond_wait (&writer->done_cond, &writer->mutex);
+            continue;
+        }
+
+        writer->blocks.pop_front ();
+        g_mutex_unlock (&writer->mutex);
+
+        if (success && !block->ok)
+        {
+            g_warning ("Could not compress data for '%s'.", filename);
+            success = false;
+        }
+        if (success && fwrite (block->out.data (), 1, block->out.size (),
+                               file) != block->out.size ())
+        {
+            g_warning ("Could not write the compressed file '%s'. The error is '%s' (errno %d)",
+                       filename, g_strerror (errno), errno);
+            success = false;
+        }
+        delete block;
+
+        g_mutex_lock (&writer->mutex);
+    }
+    g_mutex_unlock (&writer->mutex);
+
+    return success;
+}
+
+static void
+gz_put_le32 (Bytef* buf, uLong val)
+{
+    for (int i = 0; i < 4; ++i, val >>= 8)
+        buf[i] = val & 0xff;
+}
+
 static inline bool
-gz_thread_write (gzFile file, gz_thread_params_t* params)
+gz_thread_write (gz_thread_params_t* params)
 {
     bool success = true;
-    gchar buffer[BUFLEN];
+    bool eof = false;
+    uLong crc = crc32 (0L, Z_NULL, 0);
+    uLong total = 0;
+    std::vector<Bytef> prev;
+    guint n_threads = params->n_threads ? params->n_threads :
+                      (guint)g_get_num_processors ();
+    size_t max_pending = 2 * n_threads;
+    gz_writer writer;
+    /* Magic, deflate, no flags, no mtime, no extra flags, Unix. */
+    const Bytef header[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3 };
+    Bytef trailer[8];
+
+    FILE* file = g_fopen (params->filename, "wb");
+    if (!file)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                   params->filename, g_strerror (errno), errno);
+        return false;
+    }
 
-    while (success)
+    writer.level = params->level;
+    g_mutex_init (&writer.mutex);
+    g_cond_init (&writer.done_cond);
+    writer.pool = g_thread_pool_new (gz_compress_block, &writer, n_threads,
+                                     TRUE, NULL);
+    if (!writer.pool ||
+        fwrite (header, 1, sizeof (header), file) != sizeof (header))
+        success = false;
+
+    while (success && !eof)
     {
-        auto bytes = read (params->fd, buffer, BUFLEN);
-        if (bytes > 0)
+        auto block = new gz_block;
+        block->dict_len = MIN (prev.size (), GZ_DICT_SIZE);
+        block->in.reserve (block->dict_len + GZ_BLOCK_SIZE);
+        block->in.assign (prev.end () - block->dict_len, prev.end ());
+        block->in.resize (block->dict_len + GZ_BLOCK_SIZE);
+        block->done = block->ok = false;
+
+        size_t filled = block->dict_len;
+        while (filled < block->in.size ())
         {
-            if (gzwrite (file, buffer, bytes) <= 0)
+            auto bytes = read (params->fd, block->in.data () + filled,
+                               block->in.size () - filled);
+            if (bytes > 0)
+            {
+                filled += bytes;
+            }
+            else if (bytes == 0)
+            {
+                eof = true;
+                break;
+            }
+            else
             {
-                gint errnum;
-                auto error = gzerror (file, &errnum);
-                g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
-                           params->filename, error, errnum);
+                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
                 success = false;
+                break;
             }
         }
-        else if (bytes == 0)
+        block->in.resize (filled);
+        block->last = eof;
+
+        auto data = block->in.data () + block->dict_len;
+        auto len = filled - block->dict_len;
+        crc = crc32 (crc, data, len);
+        total += len;
+        prev.assign (data + len - MIN (len, GZ_DICT_SIZE), data + len);
+
+        if (!success)
         {
+            delete block;
             break;
         }
-        else
-        {
-            g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
-                       g_strerror (errno) ? g_strerror (errno) : "", errno);
+
+        g_mutex_lock (&writer.mutex);
+        writer.blocks.push_back (block);
+        g_mutex_unlock (&writer.mutex);
+        g_thread_pool_push (writer.pool, block, NULL);
+
+        if (!gz_write_blocks (&writer, file, max_pending, params->filename))
             success = false;
-        }
     }
+
+    /* Finish whatever was queued, even after a failure, so that no worker
+     * is left with a block. */
+    if (!gz_write_blocks (&writer, file, 0, params->filename))
+        success = false;
+    if (writer.pool)
+        g_thread_pool_free (writer.pool, FALSE, TRUE);
+    g_mutex_clear (&writer.mutex);
+    g_cond_clear (&writer.done_cond);
+
+    gz_put_le32 (trailer, crc);
+    gz_put_le32 (trailer + 4, total);
+    if (success && fwrite (trailer, 1, sizeof (trailer), file) != sizeof (trailer))
+        success = false;
+
+    if (fclose (file) != 0)
+    {
+        g_warning ("Could not close the compressed file '%s'. The error is '%s' (errno %d)",
+                   params->filename, g_strerror (errno), errno);
+        success = false;
+    }
+
     return success;
 }
 
@@ -1484,8 +1776,15 @@ gz_thread_func (gz_thread_params_t* params)
 {
     gint gzval;
     bool success = true;
+    gzFile file;
+
+    if (params->write)
+    {
+        success = gz_thread_write (params);
+        goto cleanup_gz_thread_func;
+    }
 
-    auto file = do_gzopen (params->filename, params->perms);
+    file = do_gzopen (params->filename, params->perms);
 
     if (!file)
     {
@@ -1494,14 +1793,7 @@ gz_thread_func (gz_thread_params_t* params)
         goto cleanup_gz_thread_func;
     }
 
-    if (params->write)
-    {
-        success = gz_thread_write (file, params);
-    }
-    else
-    {
-        success = gz_thread_read (file, params);
-    }
+    success = gz_thread_read (file, params);
 
     if ((gzval = gzclose (file)) != Z_OK)
     {
@@ -1564,6 +1856,8 @@ try_gz_open (const char* filename, const char* perms, gboolean compress,
         params->filename = g_strdup (filename);
         params->perms = g_strdup (perms);
         params->write = write;
+        params->level = gnc_xml_gz_level;
+        params->n_threads = gnc_xml_gz_threads;
 
         auto thread = g_thread_new ("xml_thread", (GThreadFunc) gz_thread_func,
                                     params);
@@ -90,6 +90,17 @@ gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
                                         gboolean compress);
 
+/* Whether saves stream transactions and prices straight to the file (the
+ * default) or build a libxml2 DOM tree for each first.  The output is the
+ * same either way. */
+void gnc_xml_set_streaming_writer (gboolean streaming);
+gboolean gnc_xml_get_streaming_writer (void);
+
+/* Compression used when gnc_book_write_to_xml_file_v2 writes a compressed
+ * file: the zlib level (0-9, or -1 for zlib's default) and the number of
+ * threads deflating blocks in parallel (0 for one per processor). */
+void gnc_xml_set_compression (gint level, guint n_threads);
+
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
                                                        QofBook* book, FILE* fh);
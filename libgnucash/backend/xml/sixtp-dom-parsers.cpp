@@ -59,12 +59,24 @@ dom_tree_to_guid (xmlNodePtr node)
         /* handle new and guid the same for the moment */
         if ((g_strcmp0 ("guid", type) == 0) || (g_strcmp0 ("new", type) == 0))
         {
-            auto gid = guid_new ();
-            char* guid_str;
+            auto gid = guid_malloc ();
+            auto text = node->xmlChildrenNode;
 
-            guid_str = (char*)xmlNodeGetContent (node->xmlChildrenNode);
-            string_to_guid (guid_str, gid);
-            xmlFree (guid_str);
+            /* A lone text node, which is what we write, is decoded in
+             * place; anything else is gathered up first.  Only make up a
+             * fresh GUID when the text doesn't parse. */
+            if (text && text->type == XML_TEXT_NODE && !text->next)
+            {
+                if (!string_to_guid ((const char*)text->content, gid))
+                    *gid = guid_new_return ();
+            }
+            else
+            {
+                auto guid_str = (char*)xmlNodeGetContent (text);
+                if (!string_to_guid (guid_str, gid))
+                    *gid = guid_new_return ();
+                xmlFree (guid_str);
+            }
             xmlFree (type);
             return gid;
         }
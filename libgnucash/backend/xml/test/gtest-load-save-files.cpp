@@ -38,6 +38,9 @@
 
 #include <cashobjects.h>
 #include <TransLog.h>
+#include <Account.h>
+#include <Transaction.h>
+#include <gnc-commodity.h>
 #include <gnc-engine.h>
 #include <gnc-prefs.h>
 
@@ -134,7 +137,7 @@ decompress_file (std::string filename, const std::vector<unsigned char> &in, std
         return false;
     }
 
-    out.resize (stream.avail_out);
+    out.resize (stream.total_out);
 
     return true;
 }
@@ -169,17 +172,11 @@ compare_compressed_files (std::string uncompressed_filename1, std::string compre
     }
 }
 
-/* The original file is used for comparisons. The file will be different when
- * there are future changes in the GnuCash output and needs to be updated if
- * that happens.
- *
- * Using the same file each time also checks that nothing in the file will swap
- * between two stable states (bug 746937).
- */
-class LoadSaveFiles : public testing::TestWithParam<std::string>
+/* Both suites below need the engine and the XML backend. */
+class XmlBackendEnvironment : public testing::Environment
 {
 public:
-    static void SetUpTestSuite ()
+    void SetUp () override
     {
         g_setenv ("GNC_UNINSTALLED", "1", TRUE);
         qof_init ();
@@ -188,12 +185,26 @@ public:
         xaccLogDisable ();
     }
 
-    static void TearDownTestSuite ()
+    void TearDown () override
     {
         qof_close ();
     }
 };
 
+[[maybe_unused]] static testing::Environment* const xml_backend_env =
+    testing::AddGlobalTestEnvironment (new XmlBackendEnvironment);
+
+/* The original file is used for comparisons. The file will be different when
+ * there are future changes in the GnuCash output and needs to be updated if
+ * that happens.
+ *
+ * Using the same file each time also checks that nothing in the file will swap
+ * between two stable states (bug 746937).
+ */
+class LoadSaveFiles : public testing::TestWithParam<std::string>
+{
+};
+
 #define QOF_SESSION_CHECKED_CALL(_function, _session, ...) \
     do { \
         _function (_session.get (), ## __VA_ARGS__); \
@@ -213,6 +224,10 @@ TEST_P(LoadSaveFiles, test_file)
      * that has the original content.
      */
     auto new_uncompressed_file = filename + "-test-uncompressed~";
+    /* Verify that the DOM based writer produces the same content as the
+     * streaming writer used for the files above.
+     */
+    auto new_dom_file = filename + "-test-dom~";
     const char *logdomain = "backend.xml";
     GLogLevelFlags loglevel = static_cast<decltype (loglevel)>
                               (G_LOG_LEVEL_WARNING);
@@ -275,6 +290,120 @@ TEST_P(LoadSaveFiles, test_file)
 
     if (!compare_files (filename, new_uncompressed_file))
         return;
+
+    {
+        auto load_session = std::shared_ptr<QofSession>{qof_session_new (qof_book_new ()), qof_session_destroy};
+
+        QOF_SESSION_CHECKED_CALL(qof_session_begin, load_session, filename.c_str (), SESSION_READ_ONLY);
+        QOF_SESSION_CHECKED_CALL(qof_session_load, load_session, nullptr);
+
+        auto save_dom_session = std::shared_ptr<QofSession>{qof_session_new (nullptr), qof_session_destroy};
+
+        g_unlink (new_dom_file.c_str ());
+        g_unlink ((new_dom_file + ".LCK").c_str ());
+        QOF_SESSION_CHECKED_CALL(qof_session_begin, save_dom_session, new_dom_file.c_str (), SESSION_NEW_OVERWRITE);
+
+        qof_event_suspend ();
+        qof_session_swap_data (load_session.get (), save_dom_session.get ());
+        qof_book_mark_session_dirty (qof_session_get_book (save_dom_session.get ()));
+        qof_event_resume ();
+
+        qof_session_end (load_session.get ());
+
+        gnc_prefs_set_file_save_compressed (FALSE);
+        gnc_xml_set_streaming_writer (FALSE);
+        QOF_SESSION_CHECKED_CALL(qof_session_save, save_dom_session, nullptr);
+        gnc_xml_set_streaming_writer (TRUE);
+
+        qof_session_end (save_dom_session.get ());
+    }
+
+    if (!compare_files (filename, new_dom_file))
+        return;
+}
+
+/* A book big enough that a compressed save deflates it in several blocks,
+ * on several threads, must still read back with the ordinary gzip reader. */
+TEST(LoadSaveCompressed, test_multi_block_round_trip)
+{
+    const int n_trans = 2000;
+    std::string filename{"test-multi-block-compressed~"};
+
+    {
+        auto session = std::shared_ptr<QofSession>{qof_session_new (qof_book_new ()), qof_session_destroy};
+
+        g_unlink (filename.c_str ());
+        g_unlink ((filename + ".LCK").c_str ());
+        QOF_SESSION_CHECKED_CALL(qof_session_begin, session, filename.c_str (), SESSION_NEW_OVERWRITE);
+
+        auto book = qof_session_get_book (session.get ());
+        auto usd = gnc_commodity_new (book, "US Dollar", "CURRENCY", "USD", "840", 100);
+        usd = gnc_commodity_table_insert (gnc_commodity_table_get_table (book), usd);
+
+        Account* accounts[2];
+        const char* names[2] = { "Checking", "Income" };
+        for (int i = 0; i < 2; ++i)
+        {
+            accounts[i] = xaccMallocAccount (book);
+            xaccAccountBeginEdit (accounts[i]);
+            xaccAccountSetName (accounts[i], names[i]);
+            xaccAccountSetType (accounts[i], i ? ACCT_TYPE_INCOME : ACCT_TYPE_BANK);
+            xaccAccountSetCommodity (accounts[i], usd);
+            gnc_account_append_child (gnc_book_get_root_account (book), accounts[i]);
+            xaccAccountCommitEdit (accounts[i]);
+        }
+
+        for (int i = 0; i < n_trans; ++i)
+        {
+            auto trans = xaccMallocTransaction (book);
+            xaccTransBeginEdit (trans);
+            xaccTransSetCurrency (trans, usd);
+            xaccTransSetDatePostedSecsNormalized (trans, gnc_time (nullptr) - i * 86400);
+            auto description = std::string{"Payment "} + std::to_string (i);
+            xaccTransSetDescription (trans, description.c_str ());
+            for (int j = 0; j < 2; ++j)
+            {
+                auto split = xaccMallocSplit (book);
+                auto amount = gnc_numeric_create (j ? -(i + 1) : i + 1, 100);
+                xaccSplitSetParent (split, trans);
+                xaccSplitSetAccount (split, accounts[j]);
+                xaccSplitSetAmount (split, amount);
+                xaccSplitSetValue (split, amount);
+            }
+            xaccTransCommitEdit (trans);
+        }
+
+        gnc_prefs_set_file_save_compressed (TRUE);
+        gnc_xml_set_compression (1, 4);
+        QOF_SESSION_CHECKED_CALL(qof_session_save, session, nullptr);
+        gnc_xml_set_compression (Z_DEFAULT_COMPRESSION, 0);
+
+        qof_session_end (session.get ());
+    }
+
+    auto compressed = read_file (filename);
+    std::vector<unsigned char> uncompressed(compressed.size () * 100);
+    ASSERT_TRUE(decompress_file (filename, compressed, uncompressed));
+    /* Deflate blocks are 128k of input each. */
+    EXPECT_GT(uncompressed.size (), 4u * 128 * 1024);
+
+    {
+        auto session = std::shared_ptr<QofSession>{qof_session_new (qof_book_new ()), qof_session_destroy};
+
+        QOF_SESSION_CHECKED_CALL(qof_session_begin, session, filename.c_str (), SESSION_READ_ONLY);
+        QOF_SESSION_CHECKED_CALL(qof_session_load, session, nullptr);
+
+        auto book = qof_session_get_book (session.get ());
+        EXPECT_EQ(qof_collection_count (qof_book_get_collection (book, GNC_ID_TRANS)),
+                  static_cast<guint>(n_trans));
+        auto checking = gnc_account_lookup_by_name (gnc_book_get_root_account (book), "Checking");
+        ASSERT_NE(checking, nullptr);
+        /* 1 + 2 + ... + n_trans cents */
+        EXPECT_TRUE(gnc_numeric_equal (xaccAccountGetBalance (checking),
+                                       gnc_numeric_create (n_trans * (n_trans + 1) / 2, 100)));
+
+        qof_session_end (session.get ());
+    }
 }
 
 std::vector<std::string> ListTestCases ();
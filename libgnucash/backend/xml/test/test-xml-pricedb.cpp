@@ -29,6 +29,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <string>
+
 #include "cashobjects.h"
 #include "gnc-engine.h"
 #include "gnc-pricedb.h"
@@ -37,6 +39,7 @@
 
 #include "gnc-xml-helper.h"
 #include "gnc-xml.h"
+#include "gnc-xml-stream.hpp"
 #include "sixtp.h"
 #include "sixtp-parsers.h"
 #include "sixtp-dom-parsers.h"
@@ -64,6 +67,40 @@ test_add_pricedb (const char* tag, gpointer globaldata, gpointer data)
     return TRUE;
 }
 
+static std::string
+read_and_close (FILE* f)
+{
+    std::string ret;
+    char buf[4096];
+    size_t len;
+
+    rewind (f);
+    while ((len = fread (buf, 1, sizeof (buf), f)) > 0)
+        ret.append (buf, len);
+    fclose (f);
+    return ret;
+}
+
+static void
+test_db_stream (GNCPriceDB* db, xmlNodePtr test_node)
+{
+    /* The streaming writer has to match dumping the DOM tree. */
+    FILE* dom_out = tmpfile ();
+    FILE* stream_out = tmpfile ();
+
+    xmlElemDump (dom_out, NULL, test_node);
+    fprintf (dom_out, "\n");
+    {
+        GncXmlStream stream {stream_out};
+        gnc_pricedb_stream_write (stream, db, NULL, NULL);
+    }
+
+    auto dom_text = read_and_close (dom_out);
+    auto stream_text = read_and_close (stream_out);
+    do_test_args (dom_text == stream_text, "gnc_pricedb_stream_write",
+                  __FILE__, __LINE__, "%d", iter);
+}
+
 static void
 test_db (GNCPriceDB* db)
 {
@@ -84,6 +121,8 @@ test_db (GNCPriceDB* db)
     if (!db)
         return;
 
+    test_db_stream (db, test_node);
+
     filename1 = g_strdup_printf ("test_file_XXXXXX");
 
     fd = g_mkstemp (filename1);
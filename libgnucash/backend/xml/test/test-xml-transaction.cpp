@@ -33,6 +33,8 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+#include <string>
+
 #include <gnc-engine.h>
 #include <cashobjects.h>
 #include <TransLog.h>
@@ -46,6 +48,7 @@
 
 #include "../gnc-xml-helper.h"
 #include "../gnc-xml.h"
+#include "../gnc-xml-stream.hpp"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
 #include "../io-gncxml-gen.h"
@@ -362,6 +365,20 @@ test_add_transaction (const char* tag, gpointer globaldata, gpointer data)
     return retval;
 }
 
+static std::string
+read_and_close (FILE* f)
+{
+    std::string ret;
+    char buf[4096];
+    size_t len;
+
+    rewind (f);
+    while ((len = fread (buf, 1, sizeof (buf), f)) > 0)
+        ret.append (buf, len);
+    fclose (f);
+    return ret;
+}
+
 static void
 test_transaction (void)
 {
@@ -433,6 +450,33 @@ test_transaction (void)
             success_args ("transaction_xml", __FILE__, __LINE__, "%d", i);
         }
 
+        {
+            /* The streaming writer has to match dumping the DOM tree. */
+            FILE* dom_out = tmpfile ();
+            FILE* stream_out = tmpfile ();
+
+            xmlElemDump (dom_out, NULL, test_node);
+            fprintf (dom_out, "\n");
+            {
+                GncXmlStream stream {stream_out};
+                gnc_transaction_stream_write (stream, ran_trn);
+            }
+
+            auto dom_text = read_and_close (dom_out);
+            auto stream_text = read_and_close (stream_out);
+            if (dom_text != stream_text)
+            {
+                failure_args ("gnc_transaction_stream_write", __FILE__, __LINE__,
+                              "%d: streamed\n%s\nexpected\n%s", i,
+                              stream_text.c_str (), dom_text.c_str ());
+            }
+            else
+            {
+                success_args ("gnc_transaction_stream_write", __FILE__, __LINE__,
+                              "%d", i);
+            }
+        }
+
         filename1 = g_strdup_printf ("test_file_XXXXXX");
 
         fd = g_mkstemp (filename1);
@@ -484,6 +528,31 @@ test_transaction (void)
             else
                 really_get_rid_of_transaction (data.new_trn);
         }
+        {
+            /* And again through the pipelined loader. */
+            sixtp* parser;
+            tran_data data;
+            gboolean ok;
+
+            data.trn = ran_trn;
+            data.com = com;
+            data.value = i;
+            parser = gnc_transaction_sixtp_parser_create ();
+
+            gnc_transaction_xml_pipeline_begin ();
+            ok = gnc_xml_parse_file (parser, filename1, test_add_transaction,
+                                     (gpointer)&data, book);
+            if (!gnc_transaction_xml_pipeline_end ())
+                ok = FALSE;
+
+            if (!ok)
+            {
+                failure_args ("pipelined gnc_xml_parse_file returned FALSE",
+                              __FILE__, __LINE__, "%d", i);
+            }
+            else
+                really_get_rid_of_transaction (data.new_trn);
+        }
         /* no handling of circular data structures.  We'll do that later */
         /* sixtp_destroy(parser); */
 
@@ -32,8 +32,11 @@ static gchar *namespace_regexp    = NULL;
 static gboolean is_debugging      = FALSE;
 static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
+static gint compression_level     = -1;   // -1 = zlib's default, the default in the prefs backend
+static gint compression_threads   = 0;    // 0 = one per processor, the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
+static gint sql_lazy_load_months  = 0;    // 0 = load everything, the default in the prefs backend
 
 
 /* Global variables used to remove the preference registered callbacks
@@ -95,6 +98,30 @@ gnc_prefs_set_file_save_compressed(gboolean compressed)
     use_compression = compressed;
 }
 
+gint
+gnc_prefs_get_file_compression_level(void)
+{
+    return compression_level;
+}
+
+void
+gnc_prefs_set_file_compression_level(gint level)
+{
+    compression_level = level;
+}
+
+gint
+gnc_prefs_get_file_compression_threads(void)
+{
+    return compression_threads;
+}
+
+void
+gnc_prefs_set_file_compression_threads(gint threads)
+{
+    compression_threads = threads;
+}
+
 gint
 gnc_prefs_get_file_retention_policy(void)
 {
@@ -119,6 +146,18 @@ gnc_prefs_set_file_retention_days(gint days)
     file_retention_days = days;
 }
 
+gint
+gnc_prefs_get_sql_lazy_load_months(void)
+{
+    return sql_lazy_load_months;
+}
+
+void
+gnc_prefs_set_sql_lazy_load_months(gint months)
+{
+    sql_lazy_load_months = months;
+}
+
 guint
 gnc_prefs_get_long_version()
 {
@@ -113,12 +113,21 @@ void gnc_prefs_set_extra(gboolean enabled);
 gboolean gnc_prefs_get_file_save_compressed(void);
 void gnc_prefs_set_file_save_compressed(gboolean compressed);
 
+gint gnc_prefs_get_file_compression_level(void);
+void gnc_prefs_set_file_compression_level(gint level);
+
+gint gnc_prefs_get_file_compression_threads(void);
+void gnc_prefs_set_file_compression_threads(gint threads);
+
 gint gnc_prefs_get_file_retention_policy(void);
 void gnc_prefs_set_file_retention_policy(gint policy);
 
 gint gnc_prefs_get_file_retention_days(void);
 void gnc_prefs_set_file_retention_days(gint days);
 
+gint gnc_prefs_get_sql_lazy_load_months(void);
+void gnc_prefs_set_sql_lazy_load_months(gint months);
+
 guint gnc_prefs_get_long_version( void );
 
 /** @} */
@@ -45,9 +45,11 @@
 #include "qofinstance-p.h"
 #include "gnc-features.h"
 #include "guid.hpp"
+#include "qofquery.hpp"
 
 #include <numeric>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 
 static QofLogModule log_module = GNC_MOD_ACCOUNT;
@@ -57,6 +59,7 @@ static gchar account_separator[8] = ".";
 static gunichar account_uc_separator = ':';
 
 static bool imap_convert_bayes_to_flat_run = false;
+static void imap_bayes_forget (Account *acc);
 
 /* Predefined KVP paths */
 static const std::string KEY_ASSOC_INCOME_ACCOUNT("ofx/associated-income-account");
@@ -80,6 +83,7 @@ static const std::string KEY_BALANCE_INCLUDE_SUB_ACCTS("inlude-sub-accts");
 using FinalProbabilityVec=std::vector<std::pair<std::string, int32_t>>;
 using ProbabilityVec=std::vector<std::pair<std::string, struct AccountProbability>>;
 using FlatKvpEntry=std::pair<std::string, KvpValue*>;
+using SplitsSet=std::unordered_set<Split*>;
 
 enum
 {
@@ -326,16 +330,21 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
 
     new (&priv->children) AccountVec ();
     new (&priv->splits) SplitsVec ();
     priv->splits_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
     priv->sort_dirty = FALSE;
+    new (&priv->unsorted_splits) SplitsSet ();
+    new (&priv->balance_dirty_splits) SplitsSet ();
+    priv->bayes_index = nullptr;
 }
 
 static void
 gnc_account_dispose (GObject *acctp)
 {
+    imap_bayes_forget (GNC_ACCOUNT(acctp));
     G_OBJECT_CLASS(gnc_account_parent_class)->dispose(acctp);
 }
 
@@ -398,7 +407,8 @@ gnc_account_get_property (GObject         *object,
         g_value_set_boolean(value, priv->non_standard_scu);
         break;
     case PROP_SORT_DIRTY:
-        g_value_set_boolean(value, priv->sort_dirty);
+        g_value_set_boolean(value, priv->sort_dirty ||
+                            !priv->unsorted_splits.empty());
         break;
     case PROP_BALANCE_DIRTY:
         g_value_set_boolean(value, priv->balance_dirty);
@@ -554,6 +564,10 @@ gnc_account_set_property (GObject         *object,
         number = static_cast<gnc_numeric*>(g_value_get_boxed(value));
         gnc_account_set_start_balance(account, *number);
         break;
+    case PROP_START_NOCLOSING_BALANCE:
+        number = static_cast<gnc_numeric*>(g_value_get_boxed(value));
+        gnc_account_set_start_noclosing_balance(account, *number);
+        break;
     case PROP_START_CLEARED_BALANCE:
         number = static_cast<gnc_numeric*>(g_value_get_boxed(value));
         gnc_account_set_start_cleared_balance(account, *number);
@@ -1163,6 +1177,34 @@ gnc_account_foreach_split_until_date (const Account *acc, time64 end_date,
     std::for_each (splits.begin(), after_date_iter, f);
 }
 
+void
+gnc_account_foreach_split_in_range (const Account *acc, time64 start_date,
+                                    time64 end_date,
+                                    std::function<void(Split*)> f)
+{
+    if (!GNC_IS_ACCOUNT (acc) || start_date > end_date)
+        return;
+
+    auto posted = [](auto s) { return xaccTransGetDate (xaccSplitGetParent (s)); };
+    auto priv{GET_PRIVATE(acc)};
+    auto& splits{priv->splits};
+    if (priv->sort_dirty || !priv->unsorted_splits.empty())
+    {
+        for (auto s : splits)
+            if (auto date = posted (s); date >= start_date && date <= end_date)
+                f (s);
+        return;
+    }
+
+    auto begin = std::lower_bound (splits.begin(), splits.end(), start_date,
+                                   [posted](auto s, time64 t)
+                                   { return posted (s) < t; });
+    auto end = std::upper_bound (begin, splits.end(), end_date,
+                                 [posted](time64 t, auto s)
+                                 { return t < posted (s); });
+    std::for_each (begin, end, f);
+}
+
 
 Split*
 gnc_account_find_split (const Account *acc, std::function<bool(const Split*)> predicate,
@@ -1378,6 +1420,7 @@ xaccFreeAccount (Account *acc)
 
     priv = GET_PRIVATE(acc);
     qof_event_gen (&acc->inst, QOF_EVENT_DESTROY, nullptr);
+    imap_bayes_forget (acc);
 
     /* Otherwise the lists below get munged while we're iterating
      * them, possibly crashing.
@@ -1460,6 +1503,8 @@ xaccFreeAccount (Account *acc)
     priv->balance_dirty = FALSE;
     priv->sort_dirty = FALSE;
     priv->splits.~SplitsVec();
+    priv->unsorted_splits.~SplitsSet();
+    priv->balance_dirty_splits.~SplitsSet();
     priv->children.~AccountVec();
     g_hash_table_destroy (priv->splits_hash);
 
@@ -1549,6 +1594,8 @@ xaccAccountCommitEdit (Account *acc)
         else
         {
             priv->splits.clear();
+            priv->unsorted_splits.clear();
+            priv->balance_dirty_splits.clear();
             g_hash_table_remove_all (priv->splits_hash);
         }
 
@@ -1591,11 +1638,28 @@ xaccAccountDestroy (Account *acc)
 {
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
+    /* The splits left out of a partial load must go with the account. */
+    if (!qof_book_shutting_down (gnc_account_get_book (acc)))
+        gnc_account_load_history (acc, INT64_MIN, TRUE);
+
     qof_instance_set_destroying(acc, TRUE);
 
     xaccAccountCommitEdit (acc);
 }
 
+void
+gnc_account_load_history (Account *acc, time64 since,
+                          gboolean include_descendants)
+{
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    auto be = qof_book_get_backend (gnc_account_get_book (acc));
+    qof_backend_load_older (be, QOF_INSTANCE (acc), since);
+    if (include_descendants)
+        for (auto child : GET_PRIVATE(acc)->children)
+            gnc_account_load_history (child, since, TRUE);
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -1862,6 +1926,17 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
 
 /********************************************************************\
 \********************************************************************/
+
+/* The running balances of splits[0 .. idx-1] are still correct; only
+ * the ones from idx onward need to be recomputed. */
+static void
+mark_balance_dirty_from (AccountPrivate *priv, size_t idx)
+{
+    if (!priv->balance_dirty || idx < priv->balance_dirty_from)
+        priv->balance_dirty_from = idx;
+    priv->balance_dirty = TRUE;
+}
+
 void
 gnc_account_set_sort_dirty (Account *acc)
 {
@@ -1887,7 +1962,33 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty_from (priv, 0);
+}
+
+void
+gnc_account_set_split_dirty (Account *acc, Split *split)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+
+    /* If the split isn't in the account yet then gnc_account_insert_split
+     * will take care of it. */
+    if (!g_hash_table_contains (priv->splits_hash, split))
+        return;
+
+    /* Its position is looked up when the balances are next needed, once
+     * for all the splits changed meanwhile. */
+    mark_balance_dirty_from (priv, priv->splits.size());
+    priv->balance_dirty_splits.insert (split);
+
+    if (!priv->sort_dirty)
+        priv->unsorted_splits.insert (split);
 }
 
 void gnc_account_set_defer_bal_computation (Account *acc, gboolean defer)
@@ -1921,6 +2022,95 @@ static bool split_cmp_less (const Split* a, const Split* b)
     return xaccSplitOrder (a, b) < 0;
 }
 
+/* Beyond this many flagged splits it's cheaper to sort the whole vector
+ * once than to move each of them. */
+#define RESORT_SPLITS_MAX_MOVES 16
+
+/* gnc_account_set_split_dirty only notes which splits changed. Find the
+ * earliest of them in one pass from the end, which stops once they're all
+ * found: edits are mostly to recent splits, and recomputing the balances
+ * walks at least that far anyway. */
+static void
+locate_balance_dirty_splits (AccountPrivate *priv)
+{
+    auto& dirty{priv->balance_dirty_splits};
+    if (dirty.empty())
+        return;
+
+    const auto& splits{priv->splits};
+    auto remaining{dirty.size()};
+    for (auto i = splits.size(); remaining && i-- > 0;)
+        if (dirty.count (splits[i]))
+        {
+            mark_balance_dirty_from (priv, i);
+            --remaining;
+        }
+    dirty.clear();
+}
+
+/* Restore the sort order of the account's splits. If only a few splits
+ * were flagged by gnc_account_set_split_dirty then just those are moved
+ * to their new place; otherwise the whole vector is sorted. Either way
+ * the running balances are invalidated only from the first split whose
+ * position changed. */
+static void
+resort_splits (AccountPrivate *priv)
+{
+    auto& splits{priv->splits};
+
+    locate_balance_dirty_splits (priv);
+    if (priv->sort_dirty ||
+        priv->unsorted_splits.size() > RESORT_SPLITS_MAX_MOVES)
+    {
+        auto old_splits{splits};
+        std::sort (splits.begin(), splits.end(), split_cmp_less);
+        auto diff{std::mismatch (splits.begin(), splits.end(), old_splits.begin()).first};
+        if (diff != splits.end())
+            mark_balance_dirty_from (priv, diff - splits.begin());
+    }
+    else if (!priv->unsorted_splits.empty())
+    {
+        /* Find all the flagged splits in one pass from the end. The
+         * positions come out descending, so erasing one doesn't move
+         * the others. */
+        std::vector<size_t> positions;
+        auto remaining{priv->unsorted_splits.size()};
+        for (auto i = splits.size(); remaining && i-- > 0;)
+            if (priv->unsorted_splits.count (splits[i]))
+            {
+                positions.push_back (i);
+                --remaining;
+            }
+
+        SplitsVec moved;
+        for (auto i : positions)
+        {
+            auto pos = splits.begin() + i;
+            auto s = *pos;
+            /* The common case: one split was edited and its sort keys
+             * didn't change. */
+            if (positions.size() == 1 &&
+                (pos == splits.begin() || !split_cmp_less (s, *std::prev (pos))) &&
+                (std::next (pos) == splits.end() || !split_cmp_less (*std::next (pos), s)))
+                continue;
+
+            mark_balance_dirty_from (priv, i);
+            splits.erase (pos);
+            moved.push_back (s);
+        }
+
+        for (auto s : moved)
+        {
+            auto pos = std::upper_bound (splits.begin(), splits.end(), s, split_cmp_less);
+            mark_balance_dirty_from (priv, pos - splits.begin());
+            splits.insert (pos, s);
+        }
+    }
+
+    priv->sort_dirty = FALSE;
+    priv->unsorted_splits.clear();
+}
+
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
@@ -1933,19 +2123,26 @@ gnc_account_insert_split (Account *acc, Split *s)
     if (!g_hash_table_add (priv->splits_hash, s))
         return false;
 
-    priv->splits.push_back (s);
-
     if (qof_instance_get_editlevel(acc) == 0)
-        std::sort (priv->splits.begin(), priv->splits.end(), split_cmp_less);
+    {
+        resort_splits (priv);
+        auto pos = std::upper_bound (priv->splits.begin(), priv->splits.end(),
+                                     s, split_cmp_less);
+        mark_balance_dirty_from (priv, pos - priv->splits.begin());
+        priv->splits.insert (pos, s);
+    }
     else
+    {
+        mark_balance_dirty_from (priv, priv->splits.size());
+        priv->splits.push_back (s);
         priv->sort_dirty = true;
+    }
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, nullptr);
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1964,20 +2161,23 @@ gnc_account_remove_split (Account *acc, Split *s)
     if (!g_hash_table_remove (priv->splits_hash, s))
         return false;
 
-    // shortcut pruning the last element. this is the most common
+    // search from the back: pruning the last element is the most common
     // remove_split operation during UI or book shutdown.
-    if (s == priv->splits.back())
-        priv->splits.pop_back();
-    else
-        priv->splits.erase (std::remove (priv->splits.begin(), priv->splits.end(), s),
-                            priv->splits.end());
+    auto it = std::find (priv->splits.rbegin(), priv->splits.rend(), s);
+    if (it != priv->splits.rend())
+    {
+        auto pos = std::prev (it.base());
+        mark_balance_dirty_from (priv, pos - priv->splits.begin());
+        priv->splits.erase (pos);
+    }
+    priv->unsorted_splits.erase (s);
+    priv->balance_dirty_splits.erase (s);
 
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, nullptr);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
@@ -1990,11 +2190,10 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     priv = GET_PRIVATE(acc);
-    if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
+    if ((!priv->sort_dirty && priv->unsorted_splits.empty()) ||
+        (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    std::sort (priv->splits.begin(), priv->splits.end(), split_cmp_less);
-    priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    resort_splits (priv);
 }
 
 static void
@@ -2002,8 +2201,8 @@ xaccAccountBringUpToDate(Account *acc)
 {
     if (!acc) return;
 
-    /* if a re-sort happens here, then everything will update, so the
-       cost basis and balance calls are no-ops */
+    /* a re-sort here only dirties the balances from the first split
+       that moved, so the recompute just walks that suffix */
     xaccAccountSortSplits(acc, FALSE);
     xaccAccountRecomputeBalance(acc);
 }
@@ -2274,15 +2473,31 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    noclosing_balance  = priv->starting_noclosing_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    locate_balance_dirty_splits (priv);
+    /* Everything before balance_dirty_from still carries a correct
+     * running balance, so pick up from there. */
+    auto start{std::min (priv->balance_dirty_from, priv->splits.size())};
+    if (start == 0)
+    {
+        balance            = priv->starting_balance;
+        noclosing_balance  = priv->starting_noclosing_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
+    else
+    {
+        auto prev = priv->splits[start - 1];
+        balance            = prev->balance;
+        noclosing_balance  = prev->noclosing_balance;
+        cleared_balance    = prev->cleared_balance;
+        reconciled_balance = prev->reconciled_balance;
+    }
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (auto split : priv->splits)
+    PINFO ("acct=%s starting at split %zu baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
+           priv->accountName, start, balance.num, balance.denom);
+    for (auto it = priv->splits.begin() + start; it != priv->splits.end(); ++it)
     {
+        auto split = *it;
         gnc_numeric amt = xaccSplitGetAmount (split);
 
         balance = gnc_numeric_add_fixed(balance, amt);
@@ -2314,6 +2529,7 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = 0;
 }
 
 /********************************************************************\
@@ -2414,7 +2630,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    mark_balance_dirty_from (priv, 0); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2657,7 +2873,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty_from (priv, 0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3385,7 +3601,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3398,7 +3614,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3411,7 +3627,20 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    mark_balance_dirty_from (priv, 0);
+}
+
+void
+gnc_account_set_start_noclosing_balance (Account *acc,
+        const gnc_numeric start_baln)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    priv = GET_PRIVATE(acc);
+    priv->starting_noclosing_balance = start_baln;
+    mark_balance_dirty_from (priv, 0);
 }
 
 gnc_numeric
@@ -3458,37 +3687,148 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
+/* The splits are sorted by xaccSplitOrder, whose first key is the posted
+ * date, so the split vector doubles as a date index: the splits posted
+ * before a date form a prefix of it. Splits without a transaction sort
+ * last and are never before anything. */
+static bool
+split_posted_before (const Split *split, time64 date)
+{
+    auto trans = xaccSplitGetParent (split);
+    return trans && xaccTransGetDate (trans) < date;
+}
+
 static gnc_numeric
-GetBalanceAsOfDate (Account *acc, time64 date, std::function<gnc_numeric(Split*)> split_to_numeric)
+split_balance (const Split *split, AccountBalanceKind kind)
+{
+    switch (kind)
+    {
+    case AccountBalanceKind::NOCLOSING:
+        return xaccSplitGetNoclosingBalance (split);
+    case AccountBalanceKind::CLEARED:
+        return xaccSplitGetClearedBalance (split);
+    case AccountBalanceKind::RECONCILED:
+        return xaccSplitGetReconciledBalance (split);
+    default:
+        return xaccSplitGetBalance (split);
+    }
+}
+
+/* The balance before the first split, which a partial load seeds with the
+ * splits it left out. */
+static gnc_numeric
+starting_balance_for (const AccountPrivate *priv, AccountBalanceKind kind)
+{
+    switch (kind)
+    {
+    case AccountBalanceKind::NOCLOSING:
+        return priv->starting_noclosing_balance;
+    case AccountBalanceKind::CLEARED:
+        return priv->starting_cleared_balance;
+    case AccountBalanceKind::RECONCILED:
+        return priv->starting_reconciled_balance;
+    default:
+        return priv->starting_balance;
+    }
+}
+
+/* A partial load folds the splits it left out into the starting balance,
+ * so before sorting, load those posted from the earliest date on: they
+ * come off the starting balance and the rest of it is the balance before
+ * that date. */
+static void
+load_splits_since (Account *acc, time64 date)
+{
+    auto be = qof_book_get_backend (gnc_account_get_book (acc));
+    qof_backend_load_older (be, QOF_INSTANCE (acc), date);
+}
+
+static gnc_numeric
+GetBalanceAsOfDate (Account *acc, time64 date, AccountBalanceKind kind)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    load_splits_since (acc, date);
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
-    auto is_before_date = [date](auto s) -> bool
-    { return xaccTransGetDate(xaccSplitGetParent(s)) < date; };
+    auto priv = GET_PRIVATE(acc);
+    const auto& splits{priv->splits};
+    auto after_latest = std::partition_point (splits.begin(), splits.end(),
+                                              [date](auto s)
+                                              { return split_posted_before (s, date); });
+    return after_latest == splits.begin() ?
+        starting_balance_for (priv, kind) :
+        split_balance (*std::prev (after_latest), kind);
+}
+
+std::vector<gnc_numeric>
+gnc_account_get_balances_as_of_dates (Account *acc, const std::vector<time64>& dates,
+                                      AccountBalanceKind kind)
+{
+    std::vector<gnc_numeric> balances;
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), balances);
+
+    if (!std::is_sorted (dates.begin(), dates.end()))
+    {
+        /* Answer for the dates in ascending order, then put the
+         * balances back in the order they were asked for. */
+        std::vector<size_t> order (dates.size());
+        std::iota (order.begin(), order.end(), 0);
+        std::stable_sort (order.begin(), order.end(),
+                          [&dates](auto a, auto b) { return dates[a] < dates[b]; });
+        std::vector<time64> sorted_dates;
+        sorted_dates.reserve (dates.size());
+        for (auto i : order)
+            sorted_dates.push_back (dates[i]);
+
+        auto sorted{gnc_account_get_balances_as_of_dates (acc, sorted_dates,
+                                                          kind)};
+        balances.resize (dates.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            balances[order[i]] = sorted[i];
+        return balances;
+    }
 
-    auto latest_split{gnc_account_find_split (acc, is_before_date, true)};
-    return latest_split ? split_to_numeric (latest_split) : gnc_numeric_zero();
+    if (!dates.empty())
+        load_splits_since (acc, dates.front());
+    xaccAccountSortSplits (acc, TRUE);
+    xaccAccountRecomputeBalance (acc);
+
+    auto priv = GET_PRIVATE(acc);
+    const auto& splits{priv->splits};
+    auto start_balance = starting_balance_for (priv, kind);
+    auto after_latest = splits.begin();
+    balances.reserve (dates.size());
+    for (auto date : dates)
+    {
+        /* Each date's prefix contains the previous one, so only search
+         * the remainder. */
+        after_latest = std::partition_point (after_latest, splits.end(),
+                                             [date](auto s)
+                                             { return split_posted_before (s, date); });
+        balances.push_back (after_latest == splits.begin() ? start_balance :
+                            split_balance (*std::prev (after_latest), kind));
+    }
+    return balances;
 }
 
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetBalance);
+    return GetBalanceAsOfDate (acc, date, AccountBalanceKind::ALL);
 }
 
 static gnc_numeric
 xaccAccountGetNoclosingBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetNoclosingBalance);
+    return GetBalanceAsOfDate (acc, date, AccountBalanceKind::NOCLOSING);
 }
 
 gnc_numeric
 xaccAccountGetReconciledBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, xaccSplitGetReconciledBalance);
+    return GetBalanceAsOfDate (acc, date, AccountBalanceKind::RECONCILED);
 }
 
 /*
@@ -3846,10 +4186,9 @@ xaccAccountBalanceChangeHelper (Account *acc, gpointer data)
 {
     CurrencyBalanceChange *cbdiff = static_cast<CurrencyBalanceChange*>(data);
 
-    gnc_numeric b1, b2;
-    b1 = GetBalanceAsOfDate(acc, cbdiff->t1, xaccSplitGetNoclosingBalance);
-    b2 = GetBalanceAsOfDate(acc, cbdiff->t2, xaccSplitGetNoclosingBalance);
-    gnc_numeric balanceChange = gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    auto bal{gnc_account_get_balances_as_of_dates (acc, {cbdiff->t1, cbdiff->t2},
+                                                   AccountBalanceKind::NOCLOSING)};
+    gnc_numeric balanceChange = gnc_numeric_sub(bal[1], bal[0], GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
     gnc_numeric balanceChange_conv = xaccAccountConvertBalanceToCurrencyAsOfDate(acc, balanceChange, xaccAccountGetCommodity(acc), cbdiff->currency, cbdiff->t2);
     cbdiff->balanceChange = gnc_numeric_add (cbdiff->balanceChange, balanceChange_conv,
                                 gnc_commodity_get_fraction (cbdiff->currency),
@@ -3862,10 +4201,9 @@ xaccAccountGetNoclosingBalanceChangeInCurrencyForPeriod (Account *acc, time64 t1
 {
     
 
-    gnc_numeric b1, b2;
-    b1 = GetBalanceAsOfDate(acc, t1, xaccSplitGetNoclosingBalance);
-    b2 = GetBalanceAsOfDate(acc, t2, xaccSplitGetNoclosingBalance);
-    gnc_numeric balanceChange = gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    auto bal{gnc_account_get_balances_as_of_dates (acc, {t1, t2},
+                                                   AccountBalanceKind::NOCLOSING)};
+    gnc_numeric balanceChange = gnc_numeric_sub(bal[1], bal[0], GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
 
     gnc_commodity *report_commodity = xaccAccountGetCommodity(acc);
     CurrencyBalanceChange cbdiff = { report_commodity, balanceChange, t1, t2 };
@@ -5290,6 +5628,174 @@ get_first_pass_probabilities(Account* acc, GList * tokens)
     return ret;
 }
 
+/* While a batch is open (see gnc_account_imap_begin_bayes_batch) the flat
+ * "import-map-bayes/<token>/<guid>" slots of each account used are loaded once
+ * into an ImapBayesIndex, which stores each token and account GUID once and
+ * keeps the counts for a token together. The index hangs off the account's
+ * private data. Counts added during the batch go to the index, which also
+ * remembers them so that they are written back to the account's KVP in one
+ * edit when the batch ends.
+ */
+struct ImapBayesCount
+{
+    uint32_t account; /* index into ImapBayesIndex::accounts */
+    int64_t count;
+};
+
+struct ImapBayesIndex
+{
+    std::unordered_map<std::string, uint32_t> token_ids;
+    std::vector<std::string const *> tokens;
+    std::unordered_map<std::string, uint32_t> account_ids;
+    std::vector<std::string const *> accounts;
+    /* The counts for each token id, in the slots' order: by account GUID. */
+    std::vector<std::vector<ImapBayesCount>> counts;
+    std::vector<int64_t> totals;
+    /* The new counts of the (token id, account id) pairs changed in the
+     * batch, not yet written to the KVP. */
+    std::map<std::pair<uint32_t, uint32_t>, int64_t> changed;
+};
+
+/* The accounts having an index, so that ending the batch can drop them. */
+static std::vector<Account*> imap_bayes_indexed;
+static int imap_bayes_batch_depth = 0;
+
+static uint32_t
+imap_bayes_intern (std::unordered_map<std::string, uint32_t> & ids,
+                   std::vector<std::string const *> & names, std::string && name)
+{
+    auto result = ids.emplace (std::move (name), names.size ());
+    if (result.second)
+        names.push_back (&result.first->first);
+    return result.first->second;
+}
+
+static uint32_t
+imap_bayes_token_id (ImapBayesIndex & index, std::string && token)
+{
+    auto id = imap_bayes_intern (index.token_ids, index.tokens, std::move (token));
+    if (id == index.counts.size ())
+    {
+        index.counts.emplace_back ();
+        index.totals.push_back (0);
+    }
+    return id;
+}
+
+/* Returns the token's new count for the account. */
+static int64_t
+imap_bayes_add_count (ImapBayesIndex & index, uint32_t token, uint32_t account,
+                      int64_t count)
+{
+    auto & counts = index.counts[token];
+    auto iter = std::lower_bound (counts.begin (), counts.end (), *index.accounts[account],
+                                  [&index] (ImapBayesCount const & entry, std::string const & guid)
+                                  { return *index.accounts[entry.account] < guid; });
+    if (iter != counts.end () && iter->account == account)
+        iter->count += count;
+    else
+        iter = counts.insert (iter, ImapBayesCount {account, count});
+    index.totals[token] += count;
+    return iter->count;
+}
+
+static void
+build_bayes_index (char const * suffix, KvpValue * value, ImapBayesIndex & index)
+{
+    /*By convention, the key ends with the account GUID.*/
+    auto len = strlen (suffix);
+    if (len <= GUID_ENCODING_LENGTH || suffix[len - GUID_ENCODING_LENGTH - 1] != '/' ||
+        value->get_type () != KvpValue::Type::INT64)
+        return;
+    auto token = imap_bayes_token_id (index, std::string {suffix, len - GUID_ENCODING_LENGTH - 1});
+    auto account = imap_bayes_intern (index.account_ids, index.accounts,
+                                      std::string {suffix + len - GUID_ENCODING_LENGTH});
+    imap_bayes_add_count (index, token, account, value->get<int64_t> ());
+}
+
+static ImapBayesIndex &
+imap_bayes_get_index (Account * acc)
+{
+    auto priv = GET_PRIVATE (acc);
+    if (priv->bayes_index)
+        return *priv->bayes_index;
+    priv->bayes_index = new ImapBayesIndex;
+    imap_bayes_indexed.push_back (acc);
+    qof_instance_foreach_slot_prefix (QOF_INSTANCE (acc), IMAP_FRAME_BAYES "/",
+                                      &build_bayes_index, *priv->bayes_index);
+    return *priv->bayes_index;
+}
+
+/* Writes the counts changed in the batch to the account's KVP. */
+static void
+imap_bayes_write_back (Account * acc)
+{
+    auto priv = GET_PRIVATE (acc);
+    if (!priv->bayes_index || priv->bayes_index->changed.empty ())
+        return;
+    auto & index = *priv->bayes_index;
+    xaccAccountBeginEdit (acc);
+    for (auto const & entry : index.changed)
+    {
+        auto path = std::string {IMAP_FRAME_BAYES} + '/' + *index.tokens[entry.first.first] +
+            '/' + *index.accounts[entry.first.second];
+        qof_instance_set_path_kvp<int64_t> (QOF_INSTANCE (acc), entry.second, {path});
+    }
+    xaccAccountCommitEdit (acc);
+    gnc_features_set_used (gnc_account_get_book (acc), GNC_FEATURE_GUID_FLAT_BAYESIAN);
+    index.changed.clear ();
+}
+
+/* Drops the account's index, when the batch ends or the account goes away,
+ * and before its Bayes slots are changed other than through the index so
+ * that the index is reloaded if it is needed again. Counts not written back
+ * are lost. */
+static void
+imap_bayes_forget (Account * acc)
+{
+    auto priv = GET_PRIVATE (acc);
+    if (!priv->bayes_index)
+        return;
+    delete priv->bayes_index;
+    priv->bayes_index = nullptr;
+    imap_bayes_indexed.erase (std::remove (imap_bayes_indexed.begin (),
+                                           imap_bayes_indexed.end (), acc),
+                              imap_bayes_indexed.end ());
+}
+
+/* Does what get_first_pass_probabilities does for the account's slots. */
+static ProbabilityVec
+get_first_pass_probabilities (ImapBayesIndex const & index, GList * tokens)
+{
+    ProbabilityVec ret;
+    std::vector<int> positions (index.accounts.size (), -1);
+    for (auto current_token = tokens; current_token; current_token = current_token->next)
+    {
+        auto id = index.token_ids.find (static_cast <char const *> (current_token->data));
+        if (id == index.token_ids.end ())
+            continue;
+        auto total_count = (double)index.totals[id->second];
+        for (auto const & entry : index.counts[id->second])
+        {
+            auto probability = (double)entry.count / total_count;
+            auto & position = positions[entry.account];
+            if (position >= 0)
+            {/* This account is already in the map */
+                auto & item = ret[position].second;
+                item.product = probability * item.product;
+                item.product_difference = ((double)1 - probability) * item.product_difference;
+            }
+            else
+            {
+                position = ret.size ();
+                ret.push_back ({*index.accounts[entry.account],
+                                AccountProbability {probability, 1 - probability}});
+            }
+        }
+    }
+    return ret;
+}
+
 static std::string
 look_for_old_separator_descendants (Account *root, std::string const & full_name, const gchar *separator)
 {
@@ -5461,7 +5967,9 @@ gnc_account_imap_find_account_bayes (Account *acc, GList *tokens)
         return nullptr;
     auto book = gnc_account_get_book(acc);
     check_import_map_data (book);
-    auto first_pass = get_first_pass_probabilities(acc, tokens);
+    auto first_pass = imap_bayes_batch_depth > 0 ?
+        get_first_pass_probabilities (imap_bayes_get_index (acc), tokens) :
+        get_first_pass_probabilities (acc, tokens);
     if (!first_pass.size())
         return nullptr;
     auto final_probabilities = build_probabilities(first_pass);
@@ -5519,13 +6027,33 @@ gnc_account_imap_add_account_bayes (Account *acc,
     check_import_map_data (gnc_account_get_book(acc));
 
     g_return_if_fail (added_acc != nullptr);
+
+    guid_string = guid_to_string (xaccAccountGetGUID (added_acc));
+    if (imap_bayes_batch_depth > 0)
+    {
+        /* Only the index learns the counts; the batch's end writes them. */
+        auto & index = imap_bayes_get_index (acc);
+        auto account = imap_bayes_intern (index.account_ids, index.accounts, guid_string);
+        for (current_token = g_list_first(tokens); current_token;
+                current_token = current_token->next)
+        {
+            char* token = static_cast<char*>(current_token->data);
+            if (!token || !token[0])
+                continue;
+            auto token_id = imap_bayes_token_id (index, token);
+            index.changed[{token_id, account}] =
+                imap_bayes_add_count (index, token_id, account, 1);
+        }
+        g_free (guid_string);
+        LEAVE(" ");
+        return;
+    }
+
     account_fullname = gnc_account_get_full_name(added_acc);
     xaccAccountBeginEdit (acc);
 
     PINFO("account name: '%s'", account_fullname);
 
-    guid_string = guid_to_string (xaccAccountGetGUID (added_acc));
-
     /* process each token in the list */
     for (current_token = g_list_first(tokens); current_token;
             current_token = current_token->next)
@@ -5552,6 +6080,26 @@ gnc_account_imap_add_account_bayes (Account *acc,
     LEAVE(" ");
 }
 
+void
+gnc_account_imap_begin_bayes_batch (void)
+{
+    ++imap_bayes_batch_depth;
+}
+
+void
+gnc_account_imap_end_bayes_batch (void)
+{
+    g_return_if_fail (imap_bayes_batch_depth > 0);
+    if (--imap_bayes_batch_depth > 0)
+        return;
+    while (!imap_bayes_indexed.empty ())
+    {
+        auto acc = imap_bayes_indexed.back ();
+        imap_bayes_write_back (acc);
+        imap_bayes_forget (acc);
+    }
+}
+
 /*******************************************************************************/
 
 static void
@@ -5625,6 +6173,7 @@ GList *
 gnc_account_imap_get_info_bayes (Account *acc)
 {
     check_import_map_data (gnc_account_get_book (acc));
+    imap_bayes_write_back (acc);
     /* A dummy object which is used to hold the specified account, and the list
      * of data about which we care. */
     GncImapInfo imapInfo {acc, nullptr};
@@ -5676,6 +6225,8 @@ gnc_account_delete_map_entry (Account *acc, char *head, char *category,
 {
     if (acc != nullptr)
     {
+        imap_bayes_write_back (acc);
+        imap_bayes_forget (acc);
         std::vector<std::string> path {head};
         if (category)
             path.emplace_back (category);
@@ -5702,6 +6253,7 @@ gnc_account_delete_all_bayes_maps (Account *acc)
 {
     if (acc != nullptr)
     {
+        imap_bayes_forget (acc);
         auto slots = qof_instance_get_slots_prefix (QOF_INSTANCE (acc), IMAP_FRAME_BAYES);
         if (!slots.size()) return;
         xaccAccountBeginEdit (acc);
@@ -5873,6 +6425,8 @@ gboolean xaccAccountRegister (void)
     };
 
     qof_class_register (GNC_ID_ACCOUNT, (QofSortFunc) qof_xaccAccountOrder, params);
+    for (auto name : {ACCOUNT_NAME_, ACCOUNT_CODE_, QOF_PARAM_BOOK, QOF_PARAM_GUID})
+        qof_query_register_thread_safe_param (GNC_ID_ACCOUNT, name);
 
     return qof_object_register (&account_object_def);
 }
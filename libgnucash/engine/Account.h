@@ -210,6 +210,20 @@ typedef enum
      *    (by calling xaccAccountBeginEdit()) before calling this routine.*/
     void xaccAccountDestroy (Account *account);
 
+    /** Load the splits of an account that a partial load from a database
+     *  left out, so that code which must see them, like scrubbing or a
+     *  report, can.  Destroying an account does this itself.
+     *
+     *  @param account The account.
+     *
+     *  @param since Load the splits posted from this date on; INT64_MIN
+     *  loads all of them.
+     *
+     *  @param include_descendants Whether to load those of the descendants
+     *  as well. */
+    void gnc_account_load_history (Account *account, time64 since,
+                                   gboolean include_descendants);
+
     /** Compare two accounts for equality - this is a deep compare. */
     gboolean xaccAccountEqual(const Account *a, const Account* b,
                               gboolean check_guids);
@@ -360,6 +374,17 @@ typedef enum
     void gnc_account_set_start_reconciled_balance (Account *acc,
             const gnc_numeric start_baln);
 
+    /** This function will set the starting commodity balance for this
+     *  account, ignoring closing transactions.  This routine is intended
+     *  for use with backends that do not return the complete list of
+     *  splits for an account, but rather return a partial list.  In such a
+     *  case, the backend will typically return all of the splits after
+     *  some certain date, and the 'starting noclosing balance' will
+     *  represent the summation of the splits up to that date, ignoring
+     *  closing splits. */
+    void gnc_account_set_start_noclosing_balance (Account *acc,
+            const gnc_numeric start_baln);
+
     /** Tell the account that the running balances may be incorrect and
      *  need to be recomputed.
      *
@@ -1604,6 +1629,20 @@ typedef enum
     void gnc_account_imap_add_account_bayes (Account* acc, GList* tokens,
                                              Account *added_acc);
 
+    /** Start a batch of Bayesian matching, e.g. one import. Until the batch
+     *  ends, gnc_account_imap_find_account_bayes and
+     *  gnc_account_imap_add_account_bayes work on an in-memory index of each
+     *  account's token counts that is loaded on first use. Counts added are
+     *  kept in the index until the batch ends. Batches may be nested.
+     */
+    void gnc_account_imap_begin_bayes_batch (void);
+
+    /** End a batch of Bayesian matching. When the outermost batch ends the
+     *  counts added in it are written to each account in one edit and the
+     *  indexes are dropped.
+     */
+    void gnc_account_imap_end_bayes_batch (void);
+
     typedef struct imap_info
     {
         Account        *source_account;
@@ -36,6 +36,7 @@
 #include <functional>
 
 #include <Account.h>
+#include <Split.h>
 
 using SplitsVec = std::vector<Split*>;
 using AccountVec = std::vector<Account*>;
@@ -49,6 +50,21 @@ void gnc_account_foreach_split (const Account*, std::function<void(Split*)>, boo
 void gnc_account_foreach_split_until_date (const Account *acc, time64 end_date,
                                            std::function<void(Split*)> f);
 
+/** Calls f on the account's splits whose transactions were posted from
+ *  start_date to end_date inclusive, in order.  The split list is
+ *  binary-searched unless it is waiting to be resorted.
+ *
+ *  @param acc The account.
+ *
+ *  @param start_date The earliest posted date.
+ *
+ *  @param end_date The latest posted date.
+ *
+ *  @param f The function to call on each split. */
+void gnc_account_foreach_split_in_range (const Account *acc, time64 start_date,
+                                         time64 end_date,
+                                         std::function<void(Split*)> f);
+
 /** scans account split list (in forward or reverse order) until
  *    predicate split->bool returns true. Maybe return the split.
  *
@@ -61,6 +77,34 @@ void gnc_account_foreach_split_until_date (const Account *acc, time64 end_date,
  *  @result Split* or nullptr if not found */
 Split* gnc_account_find_split (const Account*, std::function<bool(const Split*)>, bool);
 
+/** The running balances an account keeps in its splits. */
+enum class AccountBalanceKind
+{
+    ALL,            /**< xaccSplitGetBalance */
+    NOCLOSING,      /**< xaccSplitGetNoclosingBalance */
+    CLEARED,        /**< xaccSplitGetClearedBalance */
+    RECONCILED,     /**< xaccSplitGetReconciledBalance */
+};
+
+/** Computes the account's balance as of each of several dates, i.e. the
+ *  running balance of the latest split posted before each date. The
+ *  split list is binary-searched, each date continuing from where the
+ *  previous one stopped.
+ *
+ *  @param acc The account.
+ *
+ *  @param dates The dates, in any order; the search is quickest when they
+ *  are ascending.
+ *
+ *  @param kind The running balance to report.
+ *
+ *  @result A balance for each date, in the order of @a dates; dates before the first split get the
+ *  matching starting balance, which is zero unless a partial load from a
+ *  database left older splits out. */
+std::vector<gnc_numeric>
+gnc_account_get_balances_as_of_dates (Account *acc, const std::vector<time64>& dates,
+                                      AccountBalanceKind kind = AccountBalanceKind::ALL);
+
 #endif /* GNC_COMMODITY_HPP */
 /** @} */
 /** @} */
@@ -40,6 +40,7 @@
 #define XACC_ACCOUNT_P_H
 
 #include <vector>
+#include <unordered_set>
 #include <optional>
 
 #include "Account.h"
@@ -48,6 +49,8 @@
 
 /** STRUCTS *********************************************************/
 
+struct ImapBayesIndex;
+
 /** This is the data that describes an account.
  *
  * This is the *private* header for the account structure.
@@ -114,10 +117,18 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
  
     gboolean balance_dirty;     /* balances in splits incorrect */
+    size_t balance_dirty_from;  /* index of the first split with an
+                                 * incorrect balance */
 
     std::vector<Split*> splits;              /* list of split pointers */
     GHashTable* splits_hash;
     gboolean sort_dirty;        /* sort order of splits is bad */
+    std::unordered_set<Split*> unsorted_splits; /* splits that may be out
+                                                 * of order, if not
+                                                 * sort_dirty */
+    std::unordered_set<Split*> balance_dirty_splits; /* splits changed
+                                                      * since the balances
+                                                      * were computed */
 
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
@@ -135,6 +146,10 @@ typedef struct AccountPrivate
      * account tree. */
     short mark;
     gboolean defer_bal_computation;
+
+    /* The Bayesian import map token counts, while a batch of matching is
+     * open. See gnc_account_imap_begin_bayes_batch. */
+    ImapBayesIndex *bayes_index;
 } AccountPrivate;
 
 struct account_s
@@ -147,6 +162,12 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Mark the balances of the account dirty from the split onward, and
+ * note that the split may have to be moved to restore the sort order.
+ * Cheaper than setting both sort-dirty and balance-dirty, which cause a
+ * full sort and a recomputation of every running balance. */
+void gnc_account_set_split_dirty (Account *acc, Split *split);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
@@ -185,6 +185,12 @@ cleared_match_t xaccQueryGetClearedMatch(QofQuery * q);
 void xaccQueryAddGUIDMatch(QofQuery * q, const GncGUID *guid,
                            QofIdType id_type, QofQueryOp op);
 
+/** Load the splits a partial load from a database left out that a split
+ *  query could match: those of the accounts it is limited to, from the
+ *  start of its date range on.  A query not limited to some accounts, or
+ *  to a start date, needs those of every account, or all of them. */
+void xaccQueryLoadHistory (QofQuery *q);
+
 
 /*******************************************************************
  *  compatibility interface with old QofQuery API
@@ -380,6 +380,61 @@ recurrenceNextInstance(const Recurrence *r, const GDate *ref, GDate *next)
     }
 }
 
+/* Computes the date that is n periods after the start date, aligned
+   and adjusted for weekends the way recurrenceNextInstance() aligns
+   it.  Returns FALSE for recurrences that have to be stepped through
+   instead. */
+static gboolean
+nth_period_date(const Recurrence *r, guint n, GDate *date)
+{
+    const GDate *start = &r->start;
+    GDate month;
+    guint n_months, dim, day;
+
+    switch (r->ptype)
+    {
+    case PERIOD_DAY:
+        *date = *start;
+        g_date_add_days(date, n * r->mult);
+        return TRUE;
+    case PERIOD_WEEK:
+        *date = *start;
+        g_date_add_days(date, 7 * n * r->mult);
+        return TRUE;
+    case PERIOD_YEAR:
+        n_months = 12 * n * r->mult;
+        break;
+    case PERIOD_MONTH:
+    case PERIOD_NTH_WEEKDAY:
+    case PERIOD_LAST_WEEKDAY:
+    case PERIOD_END_OF_MONTH:
+        n_months = n * r->mult;
+        break;
+    default:
+        return FALSE;
+    }
+
+    /* Move from the first of the month so that short months don't
+       clamp the day. */
+    g_date_clear(&month, 1);
+    g_date_set_dmy(&month, 1, g_date_get_month(start), g_date_get_year(start));
+    g_date_add_months(&month, n_months);
+
+    dim = g_date_get_days_in_month(g_date_get_month(&month),
+                                   g_date_get_year(&month));
+    if (r->ptype == PERIOD_NTH_WEEKDAY || r->ptype == PERIOD_LAST_WEEKDAY)
+        day = 1 + nth_weekday_compare(start, &month, r->ptype);
+    else if (r->ptype == PERIOD_END_OF_MONTH || g_date_get_day(start) >= dim)
+        day = dim;
+    else
+        day = g_date_get_day(start);
+
+    g_date_clear(date, 1);
+    g_date_set_dmy(date, day, g_date_get_month(&month), g_date_get_year(&month));
+    adjust_for_weekend(r->ptype, r->wadj, date);
+    return TRUE;
+}
+
 /* Zero-based index */
 void
 recurrenceNthInstance(const Recurrence *r, guint n, GDate *date)
@@ -387,6 +442,19 @@ recurrenceNthInstance(const Recurrence *r, guint n, GDate *date)
     GDate ref;
     guint i;
 
+    if (n > 0 && g_date_valid(&r->start))
+    {
+        /* Stepping from a start date that is moved forward off a
+           weekend first lands on the moved start date itself. */
+        GDate adjusted_start = r->start;
+        adjust_for_weekend(r->ptype, r->wadj, &adjusted_start);
+        if (g_date_compare(&r->start, &adjusted_start) < 0 &&
+            nth_period_date(r, n - 1, date))
+            return;
+        if (nth_period_date(r, n, date))
+            return;
+    }
+
     for (*date = ref = r->start, i = 0; i < n; i++)
     {
         recurrenceNextInstance(r, &ref, date);
@@ -394,27 +462,54 @@ recurrenceNthInstance(const Recurrence *r, guint n, GDate *date)
     }
 }
 
+static time64
+period_start_time(GDate *date)
+{
+    return gnc_dmy2time64 (g_date_get_day(date),
+                           g_date_get_month(date),
+                           g_date_get_year (date));
+}
+
+static time64
+period_end_time(GDate *next_date)
+{
+    GDate date = *next_date;
+    g_date_subtract_days(&date, 1);
+    return gnc_dmy2time64_end (g_date_get_day(&date),
+                               g_date_get_month(&date),
+                               g_date_get_year (&date));
+}
+
 time64
 recurrenceGetPeriodTime(const Recurrence *r, guint period_num, gboolean end)
 {
     GDate date;
-    time64 time;
     recurrenceNthInstance(r, period_num + (end ? 1 : 0), &date);
-    if (end)
-    {
-        g_date_subtract_days(&date, 1);
-        time = gnc_dmy2time64_end (g_date_get_day(&date),
-                                   g_date_get_month(&date),
-                                   g_date_get_year (&date));
+    return end ? period_end_time(&date) : period_start_time(&date);
+}
 
-    }
-    else
+void
+recurrenceGetPeriodTimes(const Recurrence *r, guint n_periods,
+                         time64 *starts, time64 *ends)
+{
+    GDate date;
+
+    g_return_if_fail(r && starts);
+    if (n_periods == 0)
+        return;
+
+    recurrenceNthInstance(r, 0, &date);
+    starts[0] = period_start_time(&date);
+    /* The last end needs the instance after the last period. */
+    guint last = ends ? n_periods : n_periods - 1;
+    for (guint i = 1; i <= last; i++)
     {
-        time = gnc_dmy2time64 (g_date_get_day(&date),
-                               g_date_get_month(&date),
-                               g_date_get_year (&date));
+        recurrenceNthInstance(r, i, &date);
+        if (ends)
+            ends[i - 1] = period_end_time(&date);
+        if (i < n_periods)
+            starts[i] = period_start_time(&date);
     }
-    return time;
 }
 
 gnc_numeric
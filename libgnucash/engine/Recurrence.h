@@ -142,6 +142,13 @@ void recurrenceNthInstance(const Recurrence *r, guint n, GDate *date);
    of the nth instance of the recurrence. Also zero-based. */
 time64 recurrenceGetPeriodTime(const Recurrence *r, guint n, gboolean end);
 
+/* Get the beginning and end times of each of the first 'n_periods'
+   instances, as recurrenceGetPeriodTime() would.  'starts' and 'ends'
+   must each have room for 'n_periods' times; 'ends' may be NULL if only
+   the beginnings are wanted. */
+void recurrenceGetPeriodTimes(const Recurrence *r, guint n_periods,
+                              time64 *starts, time64 *ends);
+
 /**
  * @return the amount that an Account's value changed between the beginning
  * and end of the nth instance of the Recurrence. Please note this function
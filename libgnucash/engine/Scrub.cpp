@@ -96,6 +96,8 @@ using TransSet = std::unordered_set<Transaction*>;
 static TransSet
 get_all_transactions (Account *account, bool descendants)
 {
+    gnc_account_load_history (account, INT64_MIN, descendants);
+
     TransSet set;
     auto add_transactions = [&set](auto a)
     { gnc_account_foreach_split (a, [&set](auto s){ set.insert (xaccSplitGetParent (s)); }, false); };
@@ -222,6 +224,7 @@ xaccAccountTreeScrubSplits (Account *account)
 void
 xaccAccountScrubSplits (Account *account)
 {
+    gnc_account_load_history (account, INT64_MIN, FALSE);
     scrub_depth++;
     for (auto s : xaccAccountGetSplits (account))
     {
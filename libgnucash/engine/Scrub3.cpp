@@ -163,6 +163,7 @@ xaccAccountScrubLots (Account *acc)
     if (FALSE == xaccAccountHasTrades (acc)) return;
 
     ENTER ("(acc=%s)", xaccAccountGetName(acc));
+    gnc_account_load_history (acc, INT64_MIN, FALSE);
     xaccAccountBeginEdit(acc);
     xaccAccountAssignLots (acc);
 
@@ -47,6 +47,7 @@
 #include "qof.h"
 #include "qofbook.h"
 #include "Split.h"
+#include "Query.h"
 #include "AccountP.hpp"
 #include "Scrub.h"
 #include "TransactionP.hpp"
@@ -57,6 +58,15 @@
 #include "gnc-lot.h"
 #include "gnc-event.h"
 #include "qofinstance-p.h"
+#include "qofquery-p.h"
+#include "qofquery.hpp"
+#include "qofquerycore-p.h"
+#include "Account.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+#include <vector>
 
 const char *void_former_amt_str = "void-former-amount";
 const char *void_former_val_str = "void-former-value";
@@ -73,6 +83,11 @@ static QofLogModule log_module = GNC_MOD_ENGINE;
 #define GNC_SX_DEBIT_NUMERIC         "debit-numeric"
 #define GNC_SX_SHARES                "shares"
 
+/* Splits given an account that hasn't taken them in yet: the account
+ * inserts a split only when its transaction is committed.  Account split
+ * queries have to look at these as well as at the accounts' own splits. */
+static std::unordered_set<Split*> splits_pending_account;
+
 enum
 {
     PROP_0,
@@ -712,6 +727,7 @@ xaccFreeSplit (Split *split)
     }
     CACHE_REMOVE(split->memo);
     CACHE_REMOVE(split->action);
+    splits_pending_account.erase (split);
 
     if (split->inst.e_type) /* Don't do this for dupe splits. */
     {
@@ -764,12 +780,17 @@ xaccFreeSplit (Split *split)
 void mark_split (Split *s)
 {
     if (s->acc)
-    {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, nullptr);
-    }
+        gnc_account_set_split_dirty (s->acc, s);
+}
 
-    /* set dirty flag on lot too. */
-    if (s->lot) gnc_lot_set_closed_unknown(s->lot);
+/* Lots cache the sum of their splits' amounts, so the split's lot has
+ * to recompute it if the amount changes. */
+static void
+split_set_amount (Split *s, gnc_numeric amt)
+{
+    if (s->lot && !gnc_numeric_equal (s->amount, amt))
+        gnc_lot_set_closed_unknown (s->lot);
+    s->amount = amt;
 }
 
 /*
@@ -951,6 +972,10 @@ xaccSplitSetAccount (Split *s, Account *acc)
 
     s->acc = acc;
     qof_instance_set_dirty(QOF_INSTANCE(s));
+    if (acc != s->orig_acc)
+        splits_pending_account.insert (s);
+    else
+        splits_pending_account.erase (s);
 
     if (trans)
         xaccTransCommitEdit(trans);
@@ -1027,12 +1052,13 @@ xaccSplitCommitEdit(Split *s)
        original and new transactions, for the _next_ begin/commit cycle. */
     s->orig_acc = s->acc;
     s->orig_parent = s->parent;
+    splits_pending_account.erase (s);
     if (!qof_commit_edit_part2(QOF_INSTANCE(s), commit_err, nullptr, do_destroy))
         return;
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, nullptr);
+        gnc_account_set_split_dirty (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1047,6 +1073,7 @@ xaccSplitRollbackEdit(Split *s)
        the final commit. */
     if (s->acc != s->orig_acc)
         s->acc = s->orig_acc;
+    splits_pending_account.erase (s);
 
     /* Undestroy if needed */
     if (qof_instance_get_destroying(s) && s->parent)
@@ -1161,8 +1188,8 @@ xaccSplitSetSharePriceAndAmount (Split *s, gnc_numeric price, gnc_numeric amt)
     ENTER (" ");
     xaccTransBeginEdit (s->parent);
 
-    s->amount = gnc_numeric_convert(amt, get_commodity_denom(s),
-                                    GNC_HOW_RND_ROUND_HALF_UP);
+    split_set_amount (s, gnc_numeric_convert(amt, get_commodity_denom(s),
+                                             GNC_HOW_RND_ROUND_HALF_UP));
     s->value  = gnc_numeric_mul(s->amount, price,
                                 get_currency_denom(s), GNC_HOW_RND_ROUND_HALF_UP);
 
@@ -1210,12 +1237,12 @@ qofSplitSetAmount (Split *split, gnc_numeric amt)
     g_return_if_fail(split);
     if (split->acc)
     {
-        split->amount = gnc_numeric_convert(amt,
-                                            get_commodity_denom(split), GNC_HOW_RND_ROUND_HALF_UP);
+        split_set_amount (split, gnc_numeric_convert(amt,
+                                                     get_commodity_denom(split), GNC_HOW_RND_ROUND_HALF_UP));
     }
     else
     {
-        split->amount = amt;
+        split_set_amount (split, amt);
     }
 }
 
@@ -1232,12 +1259,12 @@ xaccSplitSetAmount (Split *s, gnc_numeric amt)
     xaccTransBeginEdit (s->parent);
     if (s->acc)
     {
-        s->amount = gnc_numeric_convert(amt, get_commodity_denom(s),
-                                        GNC_HOW_RND_ROUND_HALF_UP);
+        split_set_amount (s, gnc_numeric_convert(amt, get_commodity_denom(s),
+                                                 GNC_HOW_RND_ROUND_HALF_UP));
         g_assert (gnc_numeric_check (s->amount) == GNC_ERROR_OK);
     }
     else
-        s->amount = amt;
+        split_set_amount (s, amt);
 
     SET_GAINS_ADIRTY(s);
     mark_split (s);
@@ -1342,9 +1369,9 @@ xaccSplitSetBaseValue (Split *s, gnc_numeric value,
     {
         if (gnc_commodity_equiv(commodity, base_currency))
         {
-            s->amount = gnc_numeric_convert(value,
-                                            get_commodity_denom(s),
-                                            GNC_HOW_RND_ROUND_HALF_UP);
+            split_set_amount (s, gnc_numeric_convert(value,
+                                                     get_commodity_denom(s),
+                                                     GNC_HOW_RND_ROUND_HALF_UP));
         }
         s->value = gnc_numeric_convert(value,
                                        get_currency_denom(s),
@@ -1352,8 +1379,8 @@ xaccSplitSetBaseValue (Split *s, gnc_numeric value,
     }
     else if (gnc_commodity_equiv(commodity, base_currency))
     {
-        s->amount = gnc_numeric_convert(value, get_commodity_denom(s),
-                                        GNC_HOW_RND_ROUND_HALF_UP);
+        split_set_amount (s, gnc_numeric_convert(value, get_commodity_denom(s),
+                                                 GNC_HOW_RND_ROUND_HALF_UP));
     }
     else
     {
@@ -2180,6 +2207,175 @@ xaccSplitUnvoid(Split *split)
     qof_instance_set_dirty (QOF_INSTANCE (split));
 }
 
+/********************************************************************\
+\********************************************************************/
+/* Query planning */
+
+/* The accounts and posted dates that one OR clause of a query limits the
+ * splits it matches to. */
+struct split_query_range_t
+{
+    bool has_accounts = false;
+    std::vector<Account*> accounts;
+    time64 start = INT64_MIN;
+    time64 end = INT64_MAX;
+};
+
+static bool
+param_path_is (const QofQueryParamList *path, const char *first,
+               const char *second)
+{
+    return path && path->next && !path->next->next &&
+        !g_strcmp0 (static_cast<const char*>(path->data), first) &&
+        !g_strcmp0 (static_cast<const char*>(path->next->data), second);
+}
+
+static void
+limit_to_accounts (split_query_range_t& range, query_guid_t pdata, QofBook *book)
+{
+    std::vector<Account*> accounts;
+    for (auto node = pdata->guids; node; node = node->next)
+        if (auto acc = xaccAccountLookup (static_cast<GncGUID*>(node->data), book))
+            accounts.push_back (acc);
+    std::sort (accounts.begin(), accounts.end());
+    accounts.erase (std::unique (accounts.begin(), accounts.end()), accounts.end());
+
+    if (range.has_accounts)
+    {
+        std::vector<Account*> both;
+        std::set_intersection (range.accounts.begin(), range.accounts.end(),
+                               accounts.begin(), accounts.end(),
+                               std::back_inserter (both));
+        accounts = std::move (both);
+    }
+    range.accounts = std::move (accounts);
+    range.has_accounts = true;
+}
+
+/* A day match compares the days the dates fall on. */
+static void
+limit_to_dates (split_query_range_t& range, query_date_t pdata)
+{
+    auto day = pdata->options == QOF_DATE_MATCH_DAY;
+    auto start = day ? gnc_time64_get_day_start (pdata->date) : pdata->date;
+    auto end = day ? gnc_time64_get_day_end (pdata->date) : pdata->date;
+    switch (pdata->pd.how)
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+        range.end = std::min (range.end, end);
+        break;
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
+        range.start = std::max (range.start, start);
+        break;
+    case QOF_COMPARE_EQUAL:
+        range.start = std::max (range.start, start);
+        range.end = std::min (range.end, end);
+        break;
+    default:
+        break;
+    }
+}
+
+static split_query_range_t
+clause_range (GList *and_terms, QofBook *book)
+{
+    split_query_range_t range;
+    for (auto node = and_terms; node; node = node->next)
+    {
+        auto term = static_cast<QofQueryTerm*>(node->data);
+        if (qof_query_term_is_inverted (term))
+            continue;
+        auto path = qof_query_term_get_param_path (term);
+        auto pd = qof_query_term_get_pred_data (term);
+        if (!g_strcmp0 (pd->type_name, QOF_TYPE_GUID) &&
+            param_path_is (path, SPLIT_ACCOUNT, QOF_PARAM_GUID) &&
+            reinterpret_cast<query_guid_t>(pd)->options == QOF_GUID_MATCH_ANY)
+            limit_to_accounts (range, reinterpret_cast<query_guid_t>(pd), book);
+        else if (!g_strcmp0 (pd->type_name, QOF_TYPE_DATE) &&
+                 param_path_is (path, SPLIT_TRANS, TRANS_DATE_POSTED))
+            limit_to_dates (range, reinterpret_cast<query_date_t>(pd));
+    }
+    return range;
+}
+
+/* When every clause of a query is limited to some accounts, as those of
+ * xaccQueryAddAccountMatch() are, only those accounts' splits need to be
+ * tested, and a date range from xaccQueryAddDateMatchTT() narrows them
+ * down further because the accounts keep them sorted by date. */
+static gboolean
+split_query_candidates (QofBook *book, QofQuery *query,
+                        QofInstanceForeachCB cb, gpointer user_data)
+{
+    std::vector<split_query_range_t> ranges;
+    for (auto node = qof_query_get_terms (query); node; node = node->next)
+    {
+        ranges.push_back (clause_range (static_cast<GList*>(node->data), book));
+        if (!ranges.back().has_accounts)
+            return FALSE;
+    }
+    if (ranges.empty())
+        return FALSE;
+
+    /* A split can match more than one clause but mustn't be found twice. */
+    std::unordered_set<Split*> found;
+    auto visit = [&](Split *split)
+    {
+        if (ranges.size() == 1 || found.insert (split).second)
+            cb (QOF_INSTANCE (split), user_data);
+    };
+    for (const auto& range : ranges)
+        for (auto acc : range.accounts)
+            gnc_account_foreach_split_in_range (acc, range.start, range.end,
+                                                visit);
+
+    /* Splits of open transactions that were just moved to one of the
+     * accounts aren't in its list yet; the query's own terms sort out
+     * whether they match. */
+    for (auto split : splits_pending_account)
+    {
+        if (qof_instance_get_book (split) != book)
+            continue;
+        for (const auto& range : ranges)
+            if (std::find (range.accounts.begin(), range.accounts.end(),
+                           split->acc) != range.accounts.end())
+            {
+                if (ranges.size() == 1 || found.insert (split).second)
+                    cb (QOF_INSTANCE (split), user_data);
+                break;
+            }
+    }
+    return TRUE;
+}
+
+void
+xaccQueryLoadHistory (QofQuery *q)
+{
+    if (!q || g_strcmp0 (qof_query_get_search_for (q), GNC_ID_SPLIT))
+        return;
+
+    for (auto bnode = qof_query_get_books (q); bnode; bnode = bnode->next)
+    {
+        auto book = QOF_BOOK (bnode->data);
+        auto be = qof_book_get_backend (book);
+        if (!be)
+            continue;
+
+        auto clauses = qof_query_get_terms (q);
+        if (!clauses)
+            qof_backend_load_older (be, nullptr, INT64_MIN);
+        for (auto node = clauses; node; node = node->next)
+        {
+            auto range = clause_range (static_cast<GList*>(node->data), book);
+            if (!range.has_accounts)
+                qof_backend_load_older (be, nullptr, range.start);
+            for (auto acc : range.accounts)
+                qof_backend_load_older (be, QOF_INSTANCE (acc), range.start);
+        }
+    }
+}
+
 /********************************************************************\
 \********************************************************************/
 /* QofObject function implementation */
@@ -2206,6 +2402,7 @@ static QofObject split_object_def =
     DI(.foreach           = ) qof_collection_foreach,
     DI(.printable         = ) (const char * (*)(gpointer)) xaccSplitGetMemo,
     DI(.version_cmp       = ) (int (*)(gpointer, gpointer)) qof_instance_version_cmp,
+    DI(.query_candidates  = ) split_query_candidates,
 };
 
 static gpointer
@@ -2342,6 +2539,13 @@ gboolean xaccSplitRegister (void)
         };
 
     qof_class_register (GNC_ID_SPLIT, (QofSortFunc)xaccSplitOrder, params);
+    /* These getters only read a field, so queries through them are safe to
+     * run on several threads. */
+    for (auto name : {SPLIT_DATE_RECONCILED, SPLIT_MEMO, SPLIT_ACTION,
+                      SPLIT_RECONCILE, SPLIT_AMOUNT, SPLIT_VALUE, SPLIT_LOT,
+                      SPLIT_TRANS, SPLIT_ACCOUNT, SPLIT_ACCOUNT_GUID,
+                      QOF_PARAM_BOOK, QOF_PARAM_GUID})
+        qof_query_register_thread_safe_param (GNC_ID_SPLIT, name);
     qof_class_register (SPLIT_ACCT_FULLNAME,
                         (QofSortFunc)xaccSplitCompareAccountFullNames, nullptr);
     qof_class_register (SPLIT_CORR_ACCT_NAME,
@@ -59,6 +59,7 @@
 #include <qofinstance-p.h>
 #include "gncInvoice.h"
 #include "gncOwner.h"
+#include "qofquery.hpp"
 
 /* Notes about xaccTransBeginEdit(), xaccTransCommitEdit(), and
  *  xaccTransRollback():
@@ -273,6 +274,7 @@ gnc_transaction_init(Transaction* trans)
     trans->marker = 0;
     trans->orig = nullptr;
     trans->txn_type = TXN_TYPE_UNCACHED;
+    trans->is_closing_txn = TXN_CLOSING_UNCACHED;
     LEAVE (" ");
 }
 
@@ -1613,6 +1615,7 @@ xaccTransCommitEdit (Transaction *trans)
     }
 
     trans->txn_type = TXN_TYPE_UNCACHED;
+    trans->is_closing_txn = TXN_CLOSING_UNCACHED;
     qof_commit_edit_part2(QOF_INSTANCE(trans), trans_on_error,
                           trans_cleanup_commit, do_destroy);
     LEAVE ("(trans=%p)", trans);
@@ -1661,6 +1664,7 @@ xaccTransRollbackEdit (Transaction *trans)
     trans->date_posted = orig->date_posted;
     std::swap (trans->common_currency, orig->common_currency);
     qof_instance_swap_kvp (QOF_INSTANCE (trans), QOF_INSTANCE (orig));
+    trans->is_closing_txn = TXN_CLOSING_UNCACHED;
 
     /* The splits at the front of trans->splits are exactly the same
        splits as in the original, but some of them may have changed, so
@@ -1687,6 +1691,9 @@ xaccTransRollbackEdit (Transaction *trans)
             std::swap (s->memo, so->memo);
             qof_instance_copy_kvp (QOF_INSTANCE (s), QOF_INSTANCE (so));
             s->reconciled = so->reconciled;
+            /* Lots cache their balance */
+            if (s->lot) gnc_lot_set_closed_unknown (s->lot);
+            if (so->lot) gnc_lot_set_closed_unknown (so->lot);
             s->amount = so->amount;
             s->value = so->value;
             s->lot = so->lot;
@@ -2142,6 +2149,7 @@ xaccTransSetIsClosingTxn (Transaction *trans, gboolean is_closing)
     {
         qof_instance_set_kvp (QOF_INSTANCE (trans), nullptr, 1, trans_is_closing_str);
     }
+    trans->is_closing_txn = is_closing ? 1 : 0;
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
 }
@@ -2337,6 +2345,9 @@ xaccTransGetIsClosingTxn (const Transaction *trans)
 {
     if (!trans) return FALSE;
 
+    if (trans->is_closing_txn != TXN_CLOSING_UNCACHED)
+        return trans->is_closing_txn;
+
     GValue v = G_VALUE_INIT;
     gboolean rv;
     qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, trans_is_closing_str);
@@ -2346,6 +2357,7 @@ xaccTransGetIsClosingTxn (const Transaction *trans)
         rv = 0;
     g_value_unset (&v);
 
+    const_cast<Transaction*>(trans)->is_closing_txn = rv;
     return rv;
 }
 
@@ -3135,6 +3147,11 @@ gboolean xaccTransRegister (void)
         };
 
     qof_class_register (GNC_ID_TRANS, (QofSortFunc)xaccTransOrder, params);
+    /* Not TRANS_IS_CLOSING, whose getter caches what it finds in the
+     * transaction, nor the ones that read KVP. */
+    for (auto name : {TRANS_NUM, TRANS_DESCRIPTION, TRANS_DATE_ENTERED,
+                      TRANS_DATE_POSTED, QOF_PARAM_BOOK, QOF_PARAM_GUID})
+        qof_query_register_thread_safe_param (GNC_ID_TRANS, name);
 
     return qof_object_register (&trans_object_def);
 }
@@ -116,8 +116,15 @@ struct transaction_s
      */
     char txn_type;
 
+    /* Cached value of the "book_closing" slot, which balance computations
+     * and split sorting ask for over and over again. TXN_CLOSING_UNCACHED
+     * until the first lookup; reset at commit and rollback so slots that
+     * a backend loads between begin and commit edit are picked up. */
+    signed char is_closing_txn;
 };
 
+#define TXN_CLOSING_UNCACHED -1
+
 struct _TransactionClass
 {
     QofInstanceClass parent_class;
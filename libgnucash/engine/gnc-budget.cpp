@@ -658,6 +658,14 @@ gnc_budget_get_period_end_date(const GncBudget *budget, guint period_num)
     return recurrenceGetPeriodTime(&GET_PRIVATE(budget)->recurrence, period_num, TRUE);
 }
 
+void
+gnc_budget_get_period_dates(const GncBudget *budget, time64 *starts, time64 *ends)
+{
+    g_return_if_fail (GNC_IS_BUDGET(budget));
+    auto priv = GET_PRIVATE(budget);
+    recurrenceGetPeriodTimes(&priv->recurrence, priv->num_periods, starts, ends);
+}
+
 gnc_numeric
 gnc_budget_get_account_period_actual_value(
     const GncBudget *budget, Account *acc, guint period_num)
@@ -143,6 +143,11 @@ time64 gnc_budget_get_period_start_date(const GncBudget* budget, guint period_nu
 /** Get the ending date of the Budget period*/
 time64 gnc_budget_get_period_end_date(const GncBudget* budget, guint period_num);
 
+/** Get the starting and ending dates of all of the Budget periods.
+ *  starts and ends must each have room for gnc_budget_get_num_periods()
+ *  dates. ends may be NULL if only the starting dates are wanted. */
+void gnc_budget_get_period_dates(const GncBudget* budget, time64 *starts, time64 *ends);
+
 /* Period indices are zero-based. */
 void gnc_budget_set_account_period_value(
     GncBudget* budget, const Account* account, guint period_num, gnc_numeric val);
@@ -95,6 +95,11 @@ typedef struct GNCLotPrivate
     signed char is_closed;
 #define LOT_CLOSED_UNKNOWN (-1)
 
+    /* The sum of the amounts of the splits, kept up to date as splits
+     * are added and removed. Recomputed when balance_valid is FALSE. */
+    gnc_numeric balance;
+    gboolean balance_valid;
+
     /* traversal marker, handy for preventing recursion */
     unsigned char marker;
 } GNCLotPrivate;
@@ -119,6 +124,8 @@ gnc_lot_init(GNCLot* lot)
     priv->splits = nullptr;
     priv->cached_invoice = nullptr;
     priv->is_closed = LOT_CLOSED_UNKNOWN;
+    priv->balance = gnc_numeric_zero ();
+    priv->balance_valid = FALSE;
     priv->marker = 0;
 }
 
@@ -418,6 +425,7 @@ gnc_lot_set_closed_unknown(GNCLot* lot)
     {
         priv = GET_PRIVATE(lot);
         priv->is_closed = LOT_CLOSED_UNKNOWN;
+        priv->balance_valid = FALSE;
     }
 }
 
@@ -514,6 +522,12 @@ gnc_lot_get_balance (GNCLot *lot)
         return zero;
     }
 
+    if (priv->balance_valid)
+    {
+        priv->is_closed = gnc_numeric_zero_p (priv->balance);
+        return priv->balance;
+    }
+
     /* Sum over splits; because they all belong to same account
      * they will have same denominator.
      */
@@ -535,9 +549,25 @@ gnc_lot_get_balance (GNCLot *lot)
         priv->is_closed = FALSE;
     }
 
+    priv->balance = baln;
+    priv->balance_valid = TRUE;
     return baln;
 }
 
+/* Adds amount to the cached balance, if there is one, as a split is
+ * added to or removed from the lot. */
+static void
+gnc_lot_adjust_balance (GNCLotPrivate *priv, gnc_numeric amount)
+{
+    priv->is_closed = LOT_CLOSED_UNKNOWN;
+    if (!priv->balance_valid)
+        return;
+
+    priv->balance = gnc_numeric_add_fixed (priv->balance, amount);
+    if (gnc_numeric_check (priv->balance) != GNC_ERROR_OK)
+        priv->balance_valid = FALSE;
+}
+
 /* ============================================================= */
 
 void
@@ -634,8 +664,8 @@ gnc_lot_add_split (GNCLot *lot, Split *split)
 
     priv->splits = g_list_append (priv->splits, split);
 
-    /* for recomputation of is-closed */
-    priv->is_closed = LOT_CLOSED_UNKNOWN;
+    /* update the balance, for recomputation of is-closed */
+    gnc_lot_adjust_balance (priv, xaccSplitGetAmount (split));
     gnc_lot_commit_edit(lot);
 
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, nullptr);
@@ -646,15 +676,20 @@ void
 gnc_lot_remove_split (GNCLot *lot, Split *split)
 {
     GNCLotPrivate* priv;
+    GList *node;
     if (!lot || !split) return;
     priv = GET_PRIVATE(lot);
 
     ENTER ("(lot=%p, split=%p)", lot, split);
     gnc_lot_begin_edit(lot);
     qof_instance_set_dirty(QOF_INSTANCE(lot));
-    priv->splits = g_list_remove (priv->splits, split);
+    node = g_list_find (priv->splits, split);
+    if (node)
+    {
+        priv->splits = g_list_delete_link (priv->splits, node);
+        gnc_lot_adjust_balance (priv, gnc_numeric_neg (xaccSplitGetAmount (split)));
+    }
     xaccSplitSetLot(split, nullptr);
-    priv->is_closed = LOT_CLOSED_UNKNOWN;   /* force an is-closed computation */
 
     if (!priv->splits && priv->account)
     {
@@ -56,12 +56,17 @@ struct _GncPriceClass
     QofInstanceClass parent_class;
 };
 
+struct gnc_price_conversion_cache_s;
+
 struct gnc_price_db_s
 {
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
     gboolean reset_nth_price_cache;
+    /* Memoized conversion rates and commodity graph, cleared whenever a
+     * price is added, removed or changed. */
+    struct gnc_price_conversion_cache_s *conversion_cache;
 };
 
 struct _GncPriceDBClass
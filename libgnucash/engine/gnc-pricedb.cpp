@@ -32,6 +32,14 @@
 #include "gnc-pricedb-p.h"
 #include <qofinstance-p.h>
 
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_PRICE;
 
@@ -40,9 +48,85 @@ static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         time64 t, gboolean sameday);
+
+/* The prices for each commodity/currency pair are kept in a vector sorted
+ * newest to oldest (see compare_prices_by_date) so that lookups by time can
+ * bisect it instead of walking a list. */
+using PriceVec = std::vector<GNCPrice*>;
+
+/* Conversion rates already worked out by get_nearest_price, keyed by (from,
+ * to, time, before_date, multi_hop), and the graph of commodities having prices in terms
+ * of each other that multi_hop_price_conversion searches.  Reports ask for the
+ * same rates over and over, once per account and column.  The rates are keyed
+ * on the exact time, so only the most recently used max_rates of them are
+ * kept. */
+struct gnc_price_conversion_cache_s
+{
+    using Key = std::tuple<const gnc_commodity*, const gnc_commodity*, time64, bool, bool>;
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            auto hash = std::hash<const gnc_commodity*>{}(std::get<0>(key));
+            hash = hash * 31 + std::hash<const gnc_commodity*>{}(std::get<1>(key));
+            hash = hash * 31 + std::hash<time64>{}(std::get<2>(key));
+            hash = hash * 2 + std::get<3>(key);
+            return hash * 2 + std::get<4>(key);
+        }
+    };
+    using RateList = std::list<std::pair<Key, gnc_numeric>>;
+    static constexpr size_t max_rates = 4096;
+
+    RateList lru;               /* most recently used first */
+    std::unordered_map<Key, RateList::iterator, KeyHash> rates;
+    std::unordered_map<const gnc_commodity*, std::vector<const gnc_commodity*>> graph;
+    bool graph_valid = false;
+    bool multi_hop = false;
+
+    std::optional<gnc_numeric> find (const Key& key)
+    {
+        auto it = rates.find (key);
+        if (it == rates.end())
+            return std::nullopt;
+        lru.splice (lru.begin(), lru, it->second);
+        return it->second->second;
+    }
+
+    void insert (const Key& key, gnc_numeric rate)
+    {
+        lru.emplace_front (key, rate);
+        rates.emplace (key, lru.begin());
+        if (lru.size() > max_rates)
+        {
+            rates.erase (lru.back().first);
+            lru.pop_back();
+        }
+    }
+
+    void clear_rates ()
+    {
+        rates.clear();
+        lru.clear();
+    }
+};
+
+/* Forget the memoized rates; the graph only needs rebuilding when a
+ * commodity/currency pair gained its first or lost its last price. */
+static void
+pricedb_invalidate_conversions (GNCPriceDB *db, bool pairs_changed)
+{
+    if (!db || !db->conversion_cache)
+        return;
+    auto cache = db->conversion_cache;
+    if (!cache->rates.empty())
+        cache->clear_rates();
+    if (pairs_changed)
+        cache->graph_valid = false;
+}
+
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
+                            gboolean (*f)(const PriceVec& p, gpointer user_data),
                             gpointer user_data);
 
 enum
@@ -561,6 +645,7 @@ gnc_price_set_value(GNCPrice *p, gnc_numeric value)
         p->value = value;
         gnc_price_set_dirty(p);
         gnc_price_commit_edit (p);
+        pricedb_invalidate_conversions (p->db, false);
     }
 }
 
@@ -766,13 +851,77 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* The pricedb's own per commodity/currency price vectors. */
+
+static bool
+price_vec_order (const GNCPrice *a, const GNCPrice *b)
+{
+    return compare_prices_by_date (a, b) < 0;
+}
+
+/* Returns the position of the newest price whose time is not after t, or
+ * end() if all of the prices are newer than t. */
+static PriceVec::const_iterator
+price_vec_not_after (const PriceVec& prices, time64 t)
+{
+    return std::partition_point (prices.begin(), prices.end(),
+                                 [t](const GNCPrice *p)
+                                 { return gnc_price_get_time64 (p) > t; });
+}
+
+static void
+price_vec_insert (PriceVec& prices, GNCPrice *p, gboolean check_dupl)
+{
+    gnc_price_ref(p);
+
+    auto pos = std::upper_bound (prices.begin(), prices.end(), p, price_vec_order);
+    if (check_dupl)
+    {
+        /* Duplicates must be on the same day, and those are adjacent. */
+        auto day = time64CanonicalDayTime (gnc_price_get_time64 (p));
+        auto same_day = [day](const GNCPrice *q)
+        { return time64CanonicalDayTime (gnc_price_get_time64 (q)) == day; };
+        for (auto it = pos; it != prices.end() && same_day (*it); ++it)
+            if (!price_is_duplicate (*it, p))
+                return;
+        for (auto it = pos; it != prices.begin() && same_day (*(it - 1)); --it)
+            if (!price_is_duplicate (*(it - 1), p))
+                return;
+    }
+
+    prices.insert (pos, p);
+}
+
+static bool
+price_vec_remove (PriceVec& prices, GNCPrice *p)
+{
+    auto pos = std::lower_bound (prices.begin(), prices.end(), p, price_vec_order);
+    if (pos == prices.end() || *pos != p)
+        pos = std::find (prices.begin(), prices.end(), p);
+    if (pos == prices.end())
+        return false;
+
+    prices.erase (pos);
+    gnc_price_unref (p);
+    return true;
+}
+
+static PriceList*
+price_vec_to_list (const PriceVec& prices)
+{
+    PriceList *result = nullptr;
+    for (auto it = prices.rbegin(); it != prices.rend(); ++it)
+        result = g_list_prepend (result, *it);
+    return result;
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
+   type gnc_commodity*) to vectors of GNCPrices sorted from newest to
+   oldest (PriceVec, see above).  The top-level key is the commodity
    you want the prices for, and the second level key is the commodity
    that the value is expressed in terms of.
  */
@@ -826,6 +975,7 @@ gnc_pricedb_create(QofBook * book)
 
     result->commodity_hash = g_hash_table_new(nullptr, nullptr);
     g_return_val_if_fail (result->commodity_hash, nullptr);
+    result->conversion_cache = new gnc_price_conversion_cache_s;
     return result;
 }
 
@@ -834,18 +984,15 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
+    auto prices = static_cast<PriceVec*>(data);
 
-    for (node = price_list; node; node = node->next)
+    for (auto p : *prices)
     {
-        p = static_cast<GNCPrice*>(node->data);
-
         p->db = nullptr;
+        gnc_price_unref (p);
     }
 
-    gnc_price_list_destroy(price_list);
+    delete prices;
 }
 
 static void
@@ -873,6 +1020,8 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = nullptr;
+    delete db->conversion_cache;
+    db->conversion_cache = nullptr;
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -883,6 +1032,15 @@ gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update)
     db->bulk_update = bulk_update;
 }
 
+void
+gnc_pricedb_set_multi_hop_conversions (GNCPriceDB *db, gboolean multi_hop)
+{
+    g_return_if_fail (db && db->conversion_cache);
+    /* The memoized rates are keyed on the setting, so those worked out
+     * under either one stay valid. */
+    db->conversion_cache->multi_hop = multi_hop;
+}
+
 /* ==================================================================== */
 /* This is kind of weird, the way its done.  Each collection of prices
  * for a given commodity should get its own guid, be its own entity, etc.
@@ -955,15 +1113,16 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     auto equal_data = static_cast<GNCPriceDBEqualData*>(user_data);
     auto currency = static_cast<gnc_commodity*>(key);
-    auto price_list1 = static_cast<GList*>(val);
-    auto price_list2 = gnc_pricedb_get_prices (equal_data->db2,
-                                               equal_data->commodity,
-                                               currency);
-
-    if (!gnc_price_list_equal (price_list1, price_list2))
+    auto prices1 = static_cast<PriceVec*>(val);
+    auto currency_hash2 = static_cast<GHashTable*>
+        (g_hash_table_lookup (equal_data->db2->commodity_hash, equal_data->commodity));
+    auto prices2 = currency_hash2 ?
+        static_cast<PriceVec*>(g_hash_table_lookup (currency_hash2, currency)) : nullptr;
+
+    if (!prices2 ||
+        !std::equal (prices1->begin(), prices1->end(), prices2->begin(), prices2->end(),
+                     [](GNCPrice *a, GNCPrice *b){ return gnc_price_equal (a, b); }))
         equal_data->equal = FALSE;
-
-    gnc_price_list_destroy (price_list2);
 }
 
 static void
@@ -1012,7 +1171,6 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1075,21 +1233,17 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = static_cast<GList*>(g_hash_table_lookup(currency_hash, currency));
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
+    auto prices = static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, currency));
+    bool new_pair = !prices;
+    if (new_pair)
     {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
+        prices = new PriceVec;
+        g_hash_table_insert(currency_hash, currency, prices);
     }
 
-    if (!price_list)
-    {
-        LEAVE (" no price list");
-        return FALSE;
-    }
-
-    g_hash_table_insert(currency_hash, currency, price_list);
+    price_vec_insert(*prices, p, !db->bulk_update);
     p->db = db;
+    pricedb_invalidate_conversions (db, new_pair);
 
     qof_event_gen (&p->inst, QOF_EVENT_ADD, nullptr);
 
@@ -1132,6 +1286,146 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
     return TRUE;
 }
 
+/* Orders a batch of prices by commodity, currency and day, and within a
+ * day puts the preferred (lowest) source first. */
+static bool
+price_batch_order (const GNCPrice *a, const GNCPrice *b)
+{
+    if (a->commodity != b->commodity)
+        return a->commodity < b->commodity;
+    if (a->currency != b->currency)
+        return a->currency < b->currency;
+    auto day_a = time64CanonicalDayTime (a->tmspec);
+    auto day_b = time64CanonicalDayTime (b->tmspec);
+    if (day_a != day_b)
+        return day_a < day_b;
+    return a->source < b->source;
+}
+
+static bool
+price_batch_same_day (const GNCPrice *a, const GNCPrice *b)
+{
+    return a->commodity == b->commodity && a->currency == b->currency &&
+        time64CanonicalDayTime (a->tmspec) == time64CanonicalDayTime (b->tmspec);
+}
+
+guint
+gnc_pricedb_add_prices (GNCPriceDB *db, PriceList *prices)
+{
+    if (!db || !db->commodity_hash) return 0;
+    ENTER ("db=%p, %u prices", db, g_list_length (prices));
+
+    PriceVec batch;
+    for (auto node = prices; node; node = g_list_next (node))
+    {
+        auto p = static_cast<GNCPrice*>(node->data);
+        if (!p || !p->commodity || !p->currency)
+        {
+            PWARN ("skipping price %p without commodity or currency", p);
+            continue;
+        }
+        if (!qof_instance_books_equal (db, p))
+        {
+            PERR ("attempted to mix up prices across different books");
+            continue;
+        }
+        batch.push_back (p);
+    }
+
+    /* stable_sort keeps the given order among equally good prices for a
+     * day so that, as with successive calls to gnc_pricedb_add_price, the
+     * last of them is the one that is kept. */
+    std::stable_sort (batch.begin(), batch.end(), price_batch_order);
+
+    PriceVec accepted;
+    accepted.reserve (batch.size());
+    if (db->bulk_update)
+        accepted = batch;
+    else
+    {
+        /* Replacing a day's price would announce its removal; the single
+         * event at the end covers that too. */
+        qof_event_suspend ();
+        for (auto day_begin = batch.begin(); day_begin != batch.end();)
+        {
+            auto day_end = std::find_if (day_begin, batch.end(),
+                                         [day_begin](const GNCPrice *p)
+                                         { return !price_batch_same_day (*day_begin, p); });
+            auto best_source = (*day_begin)->source;
+            auto best = *std::find_if (std::make_reverse_iterator (day_end),
+                                       std::make_reverse_iterator (day_begin),
+                                       [best_source](const GNCPrice *p)
+                                       { return p->source == best_source; });
+            day_begin = day_end;
+
+            auto old_price = gnc_pricedb_lookup_day_t64 (db, best->commodity,
+                                                         best->currency, best->tmspec);
+            if (old_price)
+            {
+                bool keep_old = best->source > old_price->source;
+                if (!keep_old)
+                    gnc_pricedb_remove_price (db, old_price);
+                gnc_price_unref (old_price);
+                if (keep_old)
+                    continue;
+            }
+            accepted.push_back (best);
+        }
+        qof_event_resume ();
+    }
+
+    /* Merge each commodity/currency run of the (still sorted) accepted
+     * prices into its price vector at once. */
+    for (auto pair_begin = accepted.begin(); pair_begin != accepted.end();)
+    {
+        auto commodity = (*pair_begin)->commodity;
+        auto currency = (*pair_begin)->currency;
+        auto pair_end = std::find_if (pair_begin, accepted.end(),
+                                      [commodity, currency](const GNCPrice *p)
+                                      { return p->commodity != commodity ||
+                                              p->currency != currency; });
+
+        auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
+        if (!currency_hash)
+        {
+            currency_hash = g_hash_table_new(nullptr, nullptr);
+            g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
+        }
+        auto pair_prices = static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, currency));
+        if (!pair_prices)
+        {
+            pair_prices = new PriceVec;
+            g_hash_table_insert(currency_hash, currency, pair_prices);
+        }
+
+        auto old_size = pair_prices->size();
+        for (auto it = pair_begin; it != pair_end; ++it)
+        {
+            gnc_price_ref (*it);
+            (*it)->db = db;
+            pair_prices->push_back (*it);
+        }
+        auto old_end = pair_prices->begin() + old_size;
+        std::sort (old_end, pair_prices->end(), price_vec_order);
+        std::inplace_merge (pair_prices->begin(), old_end, pair_prices->end(),
+                            price_vec_order);
+        pair_begin = pair_end;
+    }
+
+    if (!accepted.empty())
+    {
+        pricedb_invalidate_conversions (db, true);
+        db->reset_nth_price_cache = TRUE;
+        gnc_pricedb_begin_edit(db);
+        qof_instance_set_dirty(&db->inst);
+        gnc_pricedb_commit_edit(db);
+        qof_event_gen (&db->inst, QOF_EVENT_MODIFY, nullptr);
+    }
+
+    LEAVE ("db=%p, added %zu prices", db, accepted.size());
+    return accepted.size();
+}
+
 /* remove_price() is a utility; its only function is to remove the price
  * from the double-hash tables.
  */
@@ -1139,7 +1433,6 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1175,24 +1468,18 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, nullptr);
-    price_list = static_cast<GList*>(g_hash_table_lookup(currency_hash, currency));
+    auto prices = static_cast<PriceVec*>(g_hash_table_lookup(currency_hash, currency));
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
-    {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
-    }
+    if (prices)
+        price_vec_remove(*prices, p);
+    pricedb_invalidate_conversions (db, !prices || prices->empty());
 
     /* if the price list is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (!prices || prices->empty())
     {
         g_hash_table_remove(currency_hash, currency);
+        delete prices;
 
         if (cleanup)
         {
@@ -1300,14 +1587,14 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    auto prices = static_cast<PriceVec*>(val);
     remove_info *data = (remove_info *) user_data;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
     /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    for (auto price : *prices)
+        check_one_price_date (price, data);
 
     LEAVE(" ");
 }
@@ -1618,30 +1905,32 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     auto l = static_cast<GList**>(data);
+    auto value_list = price_vec_to_list (*static_cast<PriceVec*>(value));
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, static_cast<PriceList*>(value));
+        new_l = pricedb_price_list_merge(*l, value_list);
         g_list_free (*l);
+        g_list_free (value_list);
         *l = new_l;
     }
     else
-        *l = g_list_copy (static_cast<GList*>(value));
+        *l = value_list;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = nullptr, *result = nullptr ;
+    GList *result = nullptr ;
     if (currency)
     {
-        price_list = static_cast<GList*>(g_hash_table_lookup(hash, currency));
-        if (!price_list)
+        auto prices = static_cast<PriceVec*>(g_hash_table_lookup(hash, currency));
+        if (!prices)
         {
             LEAVE (" no price list");
             return nullptr;
         }
-        result = g_list_copy (price_list);
+        result = price_vec_to_list (*prices);
     }
     else
     {
@@ -1730,24 +2019,78 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     return forward_list;
 }
 
+/* The single-pair lookups below work directly on the price vectors for
+ * commodity->currency and currency->commodity rather than on a merged copy
+ * of them: each vector is bisected and the candidates from the two are then
+ * compared the same way pricedb_price_list_merge would order them. */
+
+static const PriceVec*
+pricedb_get_price_vec (GNCPriceDB *db, const gnc_commodity *commodity,
+                       const gnc_commodity *currency)
+{
+    if (!db->commodity_hash)
+        return nullptr;
+    auto currency_hash = static_cast<GHashTable*>(g_hash_table_lookup(db->commodity_hash, commodity));
+    if (!currency_hash)
+        return nullptr;
+    return static_cast<const PriceVec*>(g_hash_table_lookup(currency_hash, currency));
+}
+
+/* The newest price in prices whose time isn't after t. */
+static GNCPrice*
+price_vec_price_not_after (const PriceVec *prices, time64 t)
+{
+    if (!prices)
+        return nullptr;
+    auto pos = price_vec_not_after (*prices, t);
+    return pos == prices->end() ? nullptr : *pos;
+}
+
+/* The oldest price in prices whose time is after t. */
+static GNCPrice*
+price_vec_price_after (const PriceVec *prices, time64 t)
+{
+    if (!prices)
+        return nullptr;
+    auto pos = price_vec_not_after (*prices, t);
+    return pos == prices->begin() ? nullptr : *(pos - 1);
+}
+
+/* Whichever of a and b would come first in a newest-to-oldest list. */
+static GNCPrice*
+price_first_of (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) < 0 ? a : b;
+}
+
+/* Whichever of a and b would come last in a newest-to-oldest list. */
+static GNCPrice*
+price_last_of (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) < 0 ? b : a;
+}
+
 GNCPrice *gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
     GNCPrice *result;
 
     if (!db || !commodity || !currency) return nullptr;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return nullptr;
     /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = static_cast<GNCPrice*>(price_list->data);
+     * order, and the latest date always comes first. */
+    auto forward = pricedb_get_price_vec (db, commodity, currency);
+    auto reverse = pricedb_get_price_vec (db, currency, commodity);
+    result = price_first_of (forward && !forward->empty() ? forward->front() : nullptr,
+                             reverse && !reverse->empty() ? reverse->front() : nullptr);
+    if (!result) return nullptr;
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE("price is %p", result);
     return result;
 }
@@ -1770,16 +2113,16 @@ typedef struct
 */
 
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_list_scan_any_currency(const PriceVec& prices, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
     gnc_commodity *com;
     gnc_commodity *cur;
 
-    if (!price_list)
+    if (prices.empty())
         return TRUE;
 
-    auto price = static_cast<GNCPrice*>(price_list->data);
+    auto price = prices.front();
     com = gnc_price_get_commodity(price);
     cur = gnc_price_get_currency(price);
 
@@ -1791,32 +2134,30 @@ price_list_scan_any_currency(GList *price_list, gpointer data)
     /* The price list is sorted in decreasing order of time.  Find the first
        price on it that is older than the requested time and add it and the
        previous price to the result list. */
-    for (auto node = price_list; node; node = g_list_next (node))
+    auto t = helper->t;
+    auto pos = std::partition_point (prices.begin(), prices.end(),
+                                     [t](const GNCPrice *p)
+                                     { return gnc_price_get_time64 (p) >= t; });
+    if (pos == prices.end())
+    {
+        /* The last price is later than given time, add it */
+        price = prices.back();
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
+        return TRUE;
+    }
+
+    /* If there is a previous price add it to the results. */
+    if (pos != prices.begin())
     {
-        price = static_cast<GNCPrice*>(node->data);
-        time64 price_t = gnc_price_get_time64(price);
-        if (price_t < helper->t)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                auto prev_price = static_cast<GNCPrice*>(node->prev->data);
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == nullptr)
-        {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-        }
+        auto prev_price = *(pos - 1);
+        gnc_price_ref(prev_price);
+        *helper->list = g_list_prepend(*helper->list, prev_price);
     }
+    /* Add the first price before the desired time */
+    price = *pos;
+    gnc_price_ref(price);
+    *helper->list = g_list_prepend(*helper->list, price);
 
     return TRUE;
 }
@@ -2011,7 +2352,6 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
     GHashTable *currency_hash;
     gint size;
 
@@ -2026,8 +2366,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = static_cast<GList*>(g_hash_table_lookup(currency_hash, currency));
-        if (price_list)
+        if (g_hash_table_lookup(currency_hash, currency))
         {
             LEAVE("yes");
             return TRUE;
@@ -2065,9 +2404,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     auto result = static_cast<int*>(data);
-    auto price_list = static_cast<GList*>(value);
+    auto prices = static_cast<PriceVec*>(value);
 
-    *result += g_list_length(price_list);
+    *result += prices->size();
 }
 
 int
@@ -2090,19 +2429,13 @@ gnc_pricedb_num_prices(GNCPriceDB *db,
     return result;
 }
 
-/* Helper function for combining the price lists in gnc_pricedb_nth_price. */
+/* Helper function for combining the price vectors in gnc_pricedb_nth_price. */
 static void
-list_combine (gpointer element, gpointer data)
+price_vec_combine (gpointer key, gpointer value, gpointer data)
 {
-    GList *list = *(GList**)data;
-    auto lst = static_cast<GList*>(element);
-    if (list == nullptr)
-        *(GList**)data = g_list_copy (lst);
-    else
-    {
-        GList *new_list = g_list_concat (list, g_list_copy (lst));
-        *(GList**)data = new_list;
-    }
+    auto result = static_cast<PriceVec*>(data);
+    auto prices = static_cast<PriceVec*>(value);
+    result->insert (result->end(), prices->begin(), prices->end());
 }
 
 /* This function is used by gnc-tree-model-price.c for iterating through the
@@ -2123,7 +2456,7 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
                        const int n)
 {
     static const gnc_commodity *last_c = nullptr;
-    static GList *prices = nullptr;
+    static PriceVec prices;
 
     GNCPrice *result = nullptr;
     GHashTable *currency_hash;
@@ -2132,30 +2465,23 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
     if (!db || !c || n < 0) return nullptr;
     ENTER ("db=%p commodity=%s index=%d", db, gnc_commodity_get_mnemonic(c), n);
 
-    if (last_c && prices && last_c == c && db->reset_nth_price_cache == FALSE)
+    if (last_c && !prices.empty() && last_c == c && db->reset_nth_price_cache == FALSE)
     {
-        result = static_cast<GNCPrice*>(g_list_nth_data (prices, n));
+        result = static_cast<size_t>(n) < prices.size() ? prices[n] : nullptr;
         LEAVE ("price=%p", result);
         return result;
     }
 
     last_c = c;
-
-    if (prices)
-    {
-        g_list_free (prices);
-        prices = nullptr;
-    }
+    prices.clear();
 
     db->reset_nth_price_cache = FALSE;
 
     currency_hash = static_cast<GHashTable*>(g_hash_table_lookup (db->commodity_hash, c));
     if (currency_hash)
     {
-        GList *currencies = g_hash_table_get_values (currency_hash);
-        g_list_foreach (currencies, list_combine, &prices);
-        result = static_cast<GNCPrice*>(g_list_nth_data (prices, n));
-        g_list_free (currencies);
+        g_hash_table_foreach (currency_hash, price_vec_combine, &prices);
+        result = static_cast<size_t>(n) < prices.size() ? prices[n] : nullptr;
     }
 
     LEAVE ("price=%p", result);
@@ -2185,7 +2511,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        time64 t,
                        gboolean sameday)
 {
-    GList *price_list;
     GNCPrice *current_price = nullptr;
     GNCPrice *next_price = nullptr;
     GNCPrice *result = nullptr;
@@ -2193,25 +2518,21 @@ lookup_nearest_in_time(GNCPriceDB *db,
     if (!db || !c || !currency) return nullptr;
     if (t == INT64_MAX) return nullptr;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return nullptr;
+    auto forward = pricedb_get_price_vec (db, c, currency);
+    auto reverse = pricedb_get_price_vec (db, currency, c);
 
-    /* default answer */
-    current_price = static_cast<GNCPrice*>(price_list->data);
+    /* next_price is the first candidate past the one we want and
+       current_price the one just before it.  Remember that prices are in
+       most-recent-first order. */
+    next_price = price_first_of (price_vec_price_not_after (forward, t),
+                                 price_vec_price_not_after (reverse, t));
+    current_price = price_last_of (price_vec_price_after (forward, t),
+                                   price_vec_price_after (reverse, t));
 
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    for (auto item = price_list; item; item = g_list_next (item))
-    {
-        auto p = static_cast<GNCPrice*>(item->data);
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time <= t)
-        {
-            next_price = static_cast<GNCPrice*>(item->data);
-            break;
-        }
-        current_price = static_cast<GNCPrice*>(item->data);
-    }
+    /* default answer */
+    if (!current_price)
+        current_price = next_price;
+    if (!current_price) return nullptr;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2283,7 +2604,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2297,12 +2617,6 @@ gnc_pricedb_lookup_nearest_in_time64(GNCPriceDB *db,
     return lookup_nearest_in_time(db, c, currency, t, FALSE);
 }
 
-// return 0 if price's time is less or equal to time
-static int price_time64_less_or_equal (GNCPrice *p, time64 *time)
-{
-    return !(gnc_price_get_time64 (p) <= *time);
-}
-
 GNCPrice *
 gnc_pricedb_lookup_nearest_before_t64 (GNCPriceDB *db,
                                        const gnc_commodity *c,
@@ -2312,15 +2626,12 @@ gnc_pricedb_lookup_nearest_before_t64 (GNCPriceDB *db,
     GNCPrice *current_price = nullptr;
     if (!db || !c || !currency) return nullptr;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    auto price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return nullptr;
-    auto p = g_list_find_custom (price_list, &t, (GCompareFunc)price_time64_less_or_equal);
-    if (p)
-    {
-        current_price = GNC_PRICE (p->data);
+    auto forward = pricedb_get_price_vec (db, c, currency);
+    auto reverse = pricedb_get_price_vec (db, currency, c);
+    current_price = price_first_of (price_vec_price_not_after (forward, t),
+                                    price_vec_price_not_after (reverse, t));
+    if (current_price)
         gnc_price_ref (current_price);
-    }
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
@@ -2477,6 +2788,76 @@ direct_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
     return retval;
 }
 
+static const std::unordered_map<const gnc_commodity*, std::vector<const gnc_commodity*>>&
+pricedb_conversion_graph (GNCPriceDB *db)
+{
+    auto cache = db->conversion_cache;
+    if (cache->graph_valid)
+        return cache->graph;
+
+    cache->graph.clear();
+    for (const auto& commodity_entry : hash_table_to_vector (db->commodity_hash))
+    {
+        auto currency_hash = static_cast<GHashTable*>(commodity_entry.second);
+        for (const auto& currency_entry : hash_table_to_vector (currency_hash))
+        {
+            cache->graph[commodity_entry.first].push_back (currency_entry.first);
+            cache->graph[currency_entry.first].push_back (commodity_entry.first);
+        }
+    }
+    for (auto& node : cache->graph)
+    {
+        std::sort (node.second.begin(), node.second.end());
+        node.second.erase (std::unique (node.second.begin(), node.second.end()),
+                           node.second.end());
+    }
+    cache->graph_valid = true;
+    return cache->graph;
+}
+
+/* Breadth-first search of the commodity graph for the shortest chain of
+ * direct prices from "from" to "to", for when neither a direct price nor
+ * one through a single intermediate commodity exists. */
+static gnc_numeric
+multi_hop_price_conversion (GNCPriceDB *db, const gnc_commodity *from,
+                            const gnc_commodity *to, time64 t, gboolean before_date)
+{
+    gnc_numeric zero = gnc_numeric_zero();
+    if (!db || !db->conversion_cache || !db->conversion_cache->multi_hop ||
+        !from || !to)
+        return zero;
+
+    const auto& graph = pricedb_conversion_graph (db);
+    if (graph.find (from) == graph.end() || graph.find (to) == graph.end())
+        return zero;
+
+    int no_round = GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER;
+    std::unordered_map<const gnc_commodity*, gnc_numeric> rate_from {{from, gnc_numeric_create (1, 1)}};
+    std::deque<const gnc_commodity*> queue {from};
+    while (!queue.empty())
+    {
+        auto com = queue.front();
+        queue.pop_front();
+        auto com_rate = rate_from.at (com);
+        for (auto next : graph.at (com))
+        {
+            if (rate_from.find (next) != rate_from.end())
+                continue;
+            auto rate = direct_price_conversion (db, com, next, t, before_date);
+            if (gnc_numeric_zero_p (rate))
+                continue;
+            rate = gnc_numeric_mul (com_rate, rate, GNC_DENOM_AUTO, no_round);
+            if (gnc_numeric_check (rate))
+                continue;
+            if (next == to)
+                return rate;
+            rate_from.emplace (next, rate);
+            queue.push_back (next);
+        }
+    }
+    return zero;
+}
+
 static gnc_numeric
 get_nearest_price (GNCPriceDB *pdb,
                    const gnc_commodity *orig_curr,
@@ -2489,6 +2870,17 @@ get_nearest_price (GNCPriceDB *pdb,
     if (gnc_commodity_equiv (orig_curr, new_curr))
         return gnc_numeric_create (1, 1);
 
+    /* The latest indirect prices are found relative to the current time, so
+     * those aren't remembered. */
+    auto cache = pdb && t != INT64_MAX ? pdb->conversion_cache : nullptr;
+    gnc_price_conversion_cache_s::Key key {orig_curr, new_curr, t, before,
+                                          cache && cache->multi_hop};
+    if (cache)
+    {
+        if (auto cached = cache->find (key))
+            return *cached;
+    }
+
     /* Look for a direct price. */
     price = direct_price_conversion (pdb, orig_curr, new_curr, t, before);
 
@@ -2498,7 +2890,14 @@ get_nearest_price (GNCPriceDB *pdb,
     if (gnc_numeric_zero_p (price))
         price = indirect_price_conversion (pdb, orig_curr, new_curr, t, before);
 
-    return gnc_numeric_reduce (price);
+    /* nor through a single other currency, try a longer chain if asked to */
+    if (gnc_numeric_zero_p (price))
+        price = multi_hop_price_conversion (pdb, orig_curr, new_curr, t, before);
+
+    price = gnc_numeric_reduce (price);
+    if (cache)
+        cache->insert (key, price);
+    return price;
 }
 
 gnc_numeric
@@ -2600,12 +2999,13 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    auto prices = static_cast<PriceVec*>(val);
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
 
     /* stop traversal when func returns FALSE */
-    foreach_data->ok = g_list_find_custom (price_list, foreach_data->user_data, (GCompareFunc)foreach_data->func)
-        != nullptr;
+    foreach_data->ok = std::any_of (prices->begin(), prices->end(),
+                                    [foreach_data](GNCPrice *p)
+                                    { return !foreach_data->func (p, foreach_data->user_data); });
 }
 
 static void
@@ -2641,18 +3041,18 @@ unstable_price_traversal(GNCPriceDB *db,
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(const PriceVec& p, gpointer user_data);
     gpointer user_data;
 } GNCPriceListForeachData;
 
 static void
 pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    auto prices = static_cast<PriceVec*>(val);
     GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(*prices, foreach_data->user_data);
     }
 }
 
@@ -2665,7 +3065,7 @@ pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer u
 
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+                         gboolean (*f)(const PriceVec& p, gpointer user_data),
                          gpointer user_data)
 {
     GNCPriceListForeachData foreach_data;
@@ -2721,8 +3121,12 @@ stable_price_traversal(GNCPriceDB *db,
         std::sort (price_lists.begin(), price_lists.end(), compare_hash_entries_by_commodity_key);
 
         for (const auto& pricelist_entry : price_lists)
-            if (g_list_find_custom (static_cast<GList*>(pricelist_entry.second), user_data, (GCompareFunc)f))
+        {
+            auto prices = static_cast<PriceVec*>(pricelist_entry.second);
+            if (std::any_of (prices->begin(), prices->end(),
+                             [f, user_data](GNCPrice *p){ return !f (p, user_data); }))
                 return false;
+        }
     }
 
     return true;
@@ -2864,10 +3268,12 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    /* Iterate over a copy, func may remove the price from the vector. */
+    auto prices = *static_cast<PriceVec*>(val);
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
 
-    g_list_foreach (price_list, (GFunc)foreach_data->func, foreach_data->user_data);
+    for (auto p : prices)
+        foreach_data->func (p, foreach_data->user_data);
 }
 
 static void
@@ -362,6 +362,20 @@ void gnc_pricedb_commit_edit (GNCPriceDB *);
  */
 void gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update);
 
+/** @brief Set whether conversions may chain prices through more than one
+ * intermediate commodity.
+ *
+ * By default gnc_pricedb_get_nearest_price and friends only use a direct
+ * price or a price through a single other currency, and return zero if
+ * neither exists.  With multi-hop conversions enabled they then look for the
+ * shortest chain of direct prices connecting the two commodities.  Reports
+ * are rendered with them enabled only if their "Chain Price Conversions"
+ * option is set.  Changing the setting keeps the rates already memoized.
+ * @param db The pricedb
+ * @param multi_hop TRUE to search for longer chains, FALSE not to.
+ */
+void gnc_pricedb_set_multi_hop_conversions (GNCPriceDB *db, gboolean multi_hop);
+
 /** @brief Add a price to the pricedb.
  *
  * You may drop your reference to the price (i.e. call unref) after this
@@ -372,6 +386,26 @@ void gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update);
  */
 gboolean     gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p);
 
+/** @brief Add many prices to the pricedb at once.
+ *
+ * The prices are sorted and, unless bulk update is set, reduced to one per
+ * commodity, currency and day keeping the one with the preferred source (the
+ * last given among equals) in a single pass, then merged into the pricedb. A
+ * price is dropped if the pricedb already has a better one for that day and
+ * otherwise replaces it, as with gnc_pricedb_add_price(). Instead of the
+ * QOF_EVENT_ADD and QOF_EVENT_REMOVE events gnc_pricedb_add_price() would
+ * generate for each price, a single QOF_EVENT_MODIFY is generated for the
+ * pricedb once the prices are in, and only if any were added; views of the
+ * pricedb should reload when they get it.
+ *
+ * The pricedb takes its own reference to each price it adds, so you should
+ * unref your prices (and free the list) when you're done with them.
+ * @param db The pricedb
+ * @param prices The PriceList of GNCPrices to add.
+ * @return The number of prices that were added.
+ */
+guint        gnc_pricedb_add_prices(GNCPriceDB *db, PriceList *prices);
+
 /** @brief Remove a price from the pricedb and unref the price.
  * @param db The Pricedb
  * @param p The price to remove.
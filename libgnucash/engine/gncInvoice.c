@@ -1268,6 +1268,7 @@ gncInvoiceDetachFromLot (GNCLot *lot)
     qof_instance_set (QOF_INSTANCE (lot), "invoice", NULL, NULL);
     gnc_lot_commit_edit (lot);
     gnc_lot_set_cached_invoice (lot, NULL);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 void
@@ -1284,6 +1285,7 @@ gncInvoiceAttachToLot (GncInvoice *invoice, GNCLot *lot)
     gnc_lot_commit_edit (lot);
     gnc_lot_set_cached_invoice (lot, invoice);
     gncInvoiceSetPostedLot (invoice, lot);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 GncInvoice * gncInvoiceGetInvoiceFromLot (GNCLot *lot)
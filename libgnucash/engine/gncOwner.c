@@ -631,6 +631,7 @@ void gncOwnerAttachToLot (const GncOwner *owner, GNCLot *lot)
 		      GNC_OWNER_GUID, gncOwnerGetGUID (owner),
 		      NULL);
     gnc_lot_commit_edit (lot);
+    gncOwnerLotIndexUpdate (lot);
 }
 
 gboolean gncOwnerGetOwnerFromLot (GNCLot *lot, GncOwner *owner)
@@ -702,28 +703,257 @@ gboolean gncOwnerIsValid (const GncOwner *owner)
     return (owner->owner.undefined != NULL);
 }
 
-gboolean
-gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data)
+/* Determine the end owner associated to the lot, using lot_owner as
+ * storage for the owner of a pre-payment lot. */
+static const GncOwner *
+lot_get_end_owner (GNCLot *lot, GncOwner *lot_owner)
 {
-    const GncOwner *req_owner = user_data;
-    GncOwner lot_owner;
-    const GncOwner *end_owner;
     GncInvoice *invoice = gncInvoiceGetInvoiceFromLot (lot);
 
-    /* Determine the owner associated to the lot */
     if (invoice)
         /* Invoice lots */
-        end_owner = gncOwnerGetEndOwner (gncInvoiceGetOwner (invoice));
-    else if (gncOwnerGetOwnerFromLot (lot, &lot_owner))
+        return gncOwnerGetEndOwner (gncInvoiceGetOwner (invoice));
+    else if (gncOwnerGetOwnerFromLot (lot, lot_owner))
         /* Pre-payment lots */
-        end_owner = gncOwnerGetEndOwner (&lot_owner);
-    else
+        return gncOwnerGetEndOwner (lot_owner);
+
+    return NULL;
+}
+
+gboolean
+gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data)
+{
+    const GncOwner *req_owner = user_data;
+    GncOwner lot_owner;
+    const GncOwner *end_owner = lot_get_end_owner (lot, &lot_owner);
+
+    if (!end_owner)
         return FALSE;
 
     /* Is this a lot for the requested owner ? */
     return gncOwnerEqual (end_owner, req_owner);
 }
 
+/*********************************************************************/
+/* Owner lot index                                                   */
+
+/* Each book keeps an index from end owners (customers, vendors and
+ * employees) to the lots attached to them, directly, through one of
+ * their jobs or through a posted invoice, so that an owner's
+ * documents can be found without testing every lot of every A/R and
+ * A/P account.  The index is built the first time it is needed and
+ * then kept current from lot events and from the functions that
+ * attach owners and invoices to lots.  Whether a lot is open is read
+ * from the lot's own cached state at lookup time, so closing or
+ * reopening a lot needs no work here.
+ *
+ * Lots are also loaded and given their owner without any event being
+ * emitted.  The index therefore rebuilds itself whenever the number
+ * of lots it knows differs from the number in the book.  Attaching an
+ * owner or invoice only ever changes the lot it is attached to, so
+ * that is the only lot those functions recheck.
+ */
+#define GNC_OWNER_LOT_INDEX "gncOwnerLotIndex"
+
+typedef struct
+{
+    GHashTable *owner_lots;     /* end owner -> set of its lots */
+    GHashTable *lot_owner;      /* every known lot -> its end owner or NULL */
+} OwnerLotIndex;
+
+static gint owner_lot_qof_event_handler_id = 0;
+
+static void
+owner_lot_index_remove (OwnerLotIndex *index, GNCLot *lot)
+{
+    gpointer owner_inst = NULL;
+
+    if (g_hash_table_lookup_extended (index->lot_owner, lot, NULL, &owner_inst)
+        && owner_inst)
+    {
+        GHashTable *lots = g_hash_table_lookup (index->owner_lots, owner_inst);
+        if (lots)
+            g_hash_table_remove (lots, lot);
+    }
+    g_hash_table_remove (index->lot_owner, lot);
+}
+
+static void
+owner_lot_index_update (OwnerLotIndex *index, GNCLot *lot)
+{
+    GncOwner lot_owner;
+    const GncOwner *end_owner = lot_get_end_owner (lot, &lot_owner);
+    gpointer owner_inst = end_owner ? end_owner->owner.undefined : NULL;
+
+    owner_lot_index_remove (index, lot);
+    g_hash_table_insert (index->lot_owner, lot, owner_inst);
+
+    if (owner_inst)
+    {
+        GHashTable *lots = g_hash_table_lookup (index->owner_lots, owner_inst);
+        if (!lots)
+        {
+            lots = g_hash_table_new (g_direct_hash, g_direct_equal);
+            g_hash_table_insert (index->owner_lots, owner_inst, lots);
+        }
+        g_hash_table_add (lots, lot);
+    }
+}
+
+static void
+owner_lot_index_add_cb (QofInstance *inst, gpointer user_data)
+{
+    owner_lot_index_update ((OwnerLotIndex *) user_data, GNC_LOT (inst));
+}
+
+static void
+owner_lot_index_free (OwnerLotIndex *index)
+{
+    if (!index) return;
+
+    g_hash_table_destroy (index->owner_lots);
+    g_hash_table_destroy (index->lot_owner);
+    g_free (index);
+}
+
+static void
+owner_lot_index_drop (QofBook *book)
+{
+    owner_lot_index_free (qof_book_get_data (book, GNC_OWNER_LOT_INDEX));
+    qof_book_set_data (book, GNC_OWNER_LOT_INDEX, NULL);
+}
+
+static void
+owner_lot_index_book_end (QofBook *book, gpointer key, gpointer user_data)
+{
+    owner_lot_index_drop (book);
+}
+
+/** Keeps the owner lot index of the entity's book, if it has one,
+ *  current.
+ *
+ * @param entity Entity for the event
+ * @param event_type Event type
+ * @param user_data User data registered with the handler
+ * @param event_data Event data passed with the event.
+ */
+static void
+owner_lot_handle_qof_events (QofInstance *entity, QofEventId event_type,
+                             gpointer user_data, gpointer event_data)
+{
+    QofBook *book = qof_instance_get_book (entity);
+    OwnerLotIndex *index;
+
+    if (!book || qof_book_shutting_down (book))
+        return;
+
+    index = qof_book_get_data (book, GNC_OWNER_LOT_INDEX);
+    if (!index)
+        return;
+
+    if (GNC_IS_LOT (entity))
+    {
+        if (event_type & QOF_EVENT_DESTROY)
+            owner_lot_index_remove (index, GNC_LOT (entity));
+        else if (event_type & (QOF_EVENT_CREATE | QOF_EVENT_MODIFY | QOF_EVENT_ADD))
+            owner_lot_index_update (index, GNC_LOT (entity));
+    }
+    else if (GNC_IS_INVOICE (entity) && (event_type & QOF_EVENT_MODIFY))
+    {
+        /* The invoice's owner may have changed */
+        GNCLot *lot = gncInvoiceGetPostedLot (GNC_INVOICE (entity));
+        if (lot)
+            owner_lot_index_update (index, lot);
+    }
+    else if ((GNC_IS_JOB (entity) && (event_type & QOF_EVENT_MODIFY)) ||
+             ((GNC_IS_CUSTOMER (entity) || GNC_IS_VENDOR (entity) ||
+               GNC_IS_EMPLOYEE (entity) || GNC_IS_JOB (entity)) &&
+              (event_type & QOF_EVENT_DESTROY)))
+    {
+        /* A job may have moved to another owner, or an owner gone
+         * away. Both are rare, so just start over. */
+        owner_lot_index_drop (book);
+    }
+}
+
+static OwnerLotIndex *
+owner_lot_index_get (QofBook *book)
+{
+    QofCollection *col = qof_book_get_collection (book, GNC_ID_LOT);
+    OwnerLotIndex *index = qof_book_get_data (book, GNC_OWNER_LOT_INDEX);
+
+    if (index &&
+        g_hash_table_size (index->lot_owner) != qof_collection_count (col))
+    {
+        owner_lot_index_drop (book);
+        index = NULL;
+    }
+
+    if (!index)
+    {
+        if (owner_lot_qof_event_handler_id == 0)
+            owner_lot_qof_event_handler_id =
+                qof_event_register_handler (owner_lot_handle_qof_events, NULL);
+
+        index = g_new0 (OwnerLotIndex, 1);
+        index->owner_lots = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                   (GDestroyNotify) g_hash_table_destroy);
+        index->lot_owner = g_hash_table_new (g_direct_hash, g_direct_equal);
+        qof_collection_foreach (col, owner_lot_index_add_cb, index);
+        qof_book_set_data_fin (book, GNC_OWNER_LOT_INDEX, index,
+                               owner_lot_index_book_end);
+    }
+
+    return index;
+}
+
+void
+gncOwnerLotIndexUpdate (GNCLot *lot)
+{
+    OwnerLotIndex *index;
+
+    if (!lot) return;
+
+    index = qof_book_get_data (gnc_lot_get_book (lot), GNC_OWNER_LOT_INDEX);
+    if (index)
+        owner_lot_index_update (index, lot);
+}
+
+LotList *
+gncOwnerFindOpenLots (const GncOwner *owner, const Account *account,
+                      GCompareFunc sort_func)
+{
+    OwnerLotIndex *index;
+    GHashTable *lots;
+    GHashTableIter iter;
+    gpointer lot;
+    LotList *retval = NULL;
+
+    if (!owner || !owner->owner.undefined) return NULL;
+
+    index = owner_lot_index_get (qof_instance_get_book (owner->owner.undefined));
+    lots = g_hash_table_lookup (index->owner_lots, owner->owner.undefined);
+    if (!lots) return NULL;
+
+    g_hash_table_iter_init (&iter, lots);
+    while (g_hash_table_iter_next (&iter, &lot, NULL))
+    {
+        /* If this lot is closed, then ignore it */
+        if (gnc_lot_is_closed (lot))
+            continue;
+
+        if (account && gnc_lot_get_account (lot) != account)
+            continue;
+
+        retval = g_list_prepend (retval, lot);
+    }
+
+    if (sort_func)
+        retval = g_list_sort (retval, sort_func);
+
+    return retval;
+}
+
 gint
 gncOwnerLotsSortFunc (GNCLot *lotA, GNCLot *lotB)
 {
@@ -1253,9 +1483,86 @@ static void gncOwnerOffsetLots (GNCLot *from_lot, GNCLot *to_lot, const GncOwner
 
 }
 
+void
+gncOwnerOffsetLotPair (GNCLot *left_lot, gnc_numeric left_lot_bal,
+                       GNCLot *right_lot, gnc_numeric right_lot_bal,
+                       const GncOwner *owner)
+{
+    gboolean left_lot_has_doc = (gncInvoiceGetInvoiceFromLot (left_lot) != NULL);
+    gboolean right_lot_has_doc = (gncInvoiceGetInvoiceFromLot (right_lot) != NULL);
+    GncInvoice *this_invoice;
+
+    /* Depending on the lot types, a different action is needed to
+     * offset the two lots.
+     * 1. Both lots are document lots (invoices/credit notes)
+     *    -> Create a lot linking transaction between the lots
+     * 2. Both lots are payment lots (lots without a document attached)
+     *    -> Use part of the bigger lot to the close the smaller lot
+     * 3. One document lot with one payment lot
+     *    -> Use (part of) the payment to offset (part of) the document lot,
+     *       Which one will be closed depends on which is the bigger one
+     */
+    if (left_lot_has_doc && right_lot_has_doc)
+        gncOwnerCreateLotLink (left_lot, right_lot, owner);
+    else if (!left_lot_has_doc && !right_lot_has_doc)
+    {
+        gint cmp = gnc_numeric_compare (gnc_numeric_abs (left_lot_bal),
+                                        gnc_numeric_abs (right_lot_bal));
+        if (cmp >= 0)
+            gncOwnerOffsetLots (left_lot, right_lot, owner);
+        else
+            gncOwnerOffsetLots (right_lot, left_lot, owner);
+    }
+    else
+    {
+        GNCLot *doc_lot = left_lot_has_doc ? left_lot : right_lot;
+        GNCLot *pay_lot = left_lot_has_doc ? right_lot : left_lot;
+        // Ok, let's try to move a payment from pay_lot to doc_lot
+        gncOwnerOffsetLots (pay_lot, doc_lot, owner);
+    }
+
+    /* If we get here, then right_lot was modified
+     * If the lot has a document, send an event for it as well
+     * so it gets potentially updated as paid */
+    this_invoice = gncInvoiceGetInvoiceFromLot (right_lot);
+    if (this_invoice)
+        qof_event_gen (QOF_INSTANCE(this_invoice), QOF_EVENT_MODIFY, NULL);
+}
+
+/* A lot taking part in gncOwnerAutoApplyPaymentsWithLots. Its balance
+ * is cached and only refreshed when the lot takes part in an offset. */
+typedef struct
+{
+    GList *node;            /* The lot's node in the caller's list */
+    GNCLot *lot;
+    guint index;            /* Position in the caller's list */
+    gnc_numeric balance;
+} ApplyLot;
+
+/* The open lots of one account, in the caller's order, by the sign of
+ * their balance. */
+typedef struct
+{
+    GQueue positive;
+    GQueue negative;
+} ApplyQueues;
+
+static void
+apply_queues_free (gpointer data)
+{
+    ApplyQueues *queues = data;
+
+    g_queue_clear (&queues->positive);
+    g_queue_clear (&queues->negative);
+    g_free (queues);
+}
+
 void gncOwnerAutoApplyPaymentsWithLots (const GncOwner *owner, GList *lots)
 {
-    GList *left_iter;
+    GHashTable *acct_queues;
+    ApplyLot *apply;
+    GList *node;
+    guint n_lots, i;
 
     /* General note: in the code below the term "payment" can
      * both mean a true payment or a document of
@@ -1269,114 +1576,115 @@ void gncOwnerAutoApplyPaymentsWithLots (const GncOwner *owner, GList *lots)
     if (!owner) return;
     if (!lots) return;
 
-    for (left_iter = lots; left_iter; left_iter = left_iter->next)
+    /* Only lots of the opposite sign in the same account can offset
+     * each other, so sort the open lots into a queue per account and
+     * sign once. Each lot's balance is computed once here and then
+     * only for the lots an offset touched, rather than for every pair
+     * of lots. */
+    n_lots = g_list_length (lots);
+    apply = g_new0 (ApplyLot, n_lots);
+    acct_queues = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                         NULL, apply_queues_free);
+
+    for (node = lots, i = 0; node; node = node->next, i++)
+    {
+        ApplyLot *al = &apply[i];
+        Account *acct;
+        ApplyQueues *queues;
+
+        al->node = node;
+        al->lot = node->data;
+        al->index = i;
+        al->balance = gnc_numeric_zero ();
+        if (!al->lot || gnc_lot_count_splits (al->lot) == 0)
+            continue;
+
+        al->balance = gnc_lot_get_balance (al->lot);
+        if (gnc_numeric_zero_p (al->balance))
+            continue;
+
+        acct = gnc_lot_get_account (al->lot);
+        queues = g_hash_table_lookup (acct_queues, acct);
+        if (!queues)
+        {
+            queues = g_new0 (ApplyQueues, 1);
+            g_hash_table_insert (acct_queues, acct, queues);
+        }
+        g_queue_push_tail (gnc_numeric_positive_p (al->balance) ?
+                           &queues->positive : &queues->negative, al);
+    }
+
+    for (i = 0; i < n_lots; i++)
     {
-        GNCLot *left_lot = left_iter->data;
-        gnc_numeric left_lot_bal;
-        gboolean left_lot_has_doc;
+        ApplyLot *left = &apply[i];
+        gboolean left_positive;
         gboolean left_modified = FALSE;
         Account *acct;
-        GList *right_iter;
+        ApplyQueues *queues;
+        GQueue *queue;
+        GList *qnode;
 
         /* Only attempt to apply payments to open lots.
          * Note that due to the iterative nature of this function lots
          * in the list may become empty/closed before they are evaluated as
          * base lot, so we should check this for each lot. */
-        if (!left_lot)
+        if (!left->lot)
             continue;
-        if (gnc_lot_count_splits (left_lot) == 0)
+        if (gnc_lot_count_splits (left->lot) == 0)
         {
-            gnc_lot_destroy (left_lot);
-            left_iter->data = NULL;
+            gnc_lot_destroy (left->lot);
+            left->node->data = NULL;
+            left->lot = NULL;
             continue;
         }
-        if (gnc_lot_is_closed (left_lot))
+        if (gnc_numeric_zero_p (left->balance))
             continue;
 
-        acct = gnc_lot_get_account (left_lot);
-        xaccAccountBeginEdit (acct);
-
-        left_lot_bal = gnc_lot_get_balance (left_lot);
-        left_lot_has_doc = (gncInvoiceGetInvoiceFromLot (left_lot) != NULL);
+        acct = gnc_lot_get_account (left->lot);
+        queues = g_hash_table_lookup (acct_queues, acct);
+        if (!queues)
+            continue;
 
-        /* Attempt to offset left_lot with any of the remaining lots. To do so
-         * iterate over the remaining lots adding lot links or moving payments
-         * around.
-         */
-        for (right_iter = left_iter->next; right_iter; right_iter = right_iter->next)
-        {
-            GNCLot *right_lot = right_iter->data;
-            gnc_numeric right_lot_bal;
-            gboolean right_lot_has_doc;
-
-            /* Only attempt to use open lots to balance the base lot.
-             * Note that due to the iterative nature of this function lots
-             * in the list may become empty/closed before they are evaluated as
-             * base lot, so we should check this for each lot. */
-            if (!right_lot)
-                continue;
-            if (gnc_lot_count_splits (right_lot) == 0)
-            {
-                gnc_lot_destroy (right_lot);
-                right_iter->data = NULL;
-                continue;
-            }
-            if (gnc_lot_is_closed (right_lot))
-                continue;
+        /* Only attempt to balance if the base lot and balancing lot are
+         * of the opposite sign. (Otherwise we would increase the balance
+         * of the lot - Duh */
+        left_positive = gnc_numeric_positive_p (left->balance);
+        queue = left_positive ? &queues->negative : &queues->positive;
 
-            /* Balancing transactions for invoice/payments can only happen
-             * in the same account. */
-            if (acct != gnc_lot_get_account (right_lot))
-                continue;
+        /* The lots preceding left_lot have had their turn as base lot */
+        while (!g_queue_is_empty (queue) &&
+               ((ApplyLot *) g_queue_peek_head (queue))->index <= i)
+            g_queue_pop_head (queue);
 
+        xaccAccountBeginEdit (acct);
 
-            /* Only attempt to balance if the base lot and balancing lot are
-             * of the opposite sign. (Otherwise we would increase the balance
-             * of the lot - Duh */
-            right_lot_bal = gnc_lot_get_balance (right_lot);
-            if (gnc_numeric_positive_p (left_lot_bal) == gnc_numeric_positive_p (right_lot_bal))
-                continue;
+        /* Attempt to offset left_lot with the remaining lots until it
+         * is balanced. Lots that get closed on the way are dropped from
+         * the queue so later base lots won't look at them again. */
+        qnode = queue->head;
+        while (qnode && !gnc_numeric_zero_p (left->balance) &&
+               gnc_numeric_positive_p (left->balance) == left_positive)
+        {
+            ApplyLot *right = qnode->data;
+            GList *next = qnode->next;
 
-            /* Ok we found two lots than can (partly) offset each other.
-             * Depending on the lot types, a different action is needed to accomplish this.
-             * 1. Both lots are document lots (invoices/credit notes)
-             *    -> Create a lot linking transaction between the lots
-             * 2. Both lots are payment lots (lots without a document attached)
-             *    -> Use part of the bigger lot to the close the smaller lot
-             * 3. One document lot with one payment lot
-             *    -> Use (part of) the payment to offset (part of) the document lot,
-             *       Which one will be closed depends on which is the bigger one
-             */
-            right_lot_has_doc = (gncInvoiceGetInvoiceFromLot (right_lot) != NULL);
-            if (left_lot_has_doc && right_lot_has_doc)
-                gncOwnerCreateLotLink (left_lot, right_lot, owner);
-            else if (!left_lot_has_doc && !right_lot_has_doc)
+            if (gnc_numeric_zero_p (right->balance) ||
+                gnc_numeric_positive_p (right->balance) == left_positive)
             {
-                gint cmp = gnc_numeric_compare (gnc_numeric_abs (left_lot_bal),
-                                                gnc_numeric_abs (right_lot_bal));
-                if (cmp >= 0)
-                    gncOwnerOffsetLots (left_lot, right_lot, owner);
-                else
-                    gncOwnerOffsetLots (right_lot, left_lot, owner);
-            }
-            else
-            {
-                GNCLot *doc_lot = left_lot_has_doc ? left_lot : right_lot;
-                GNCLot *pay_lot = left_lot_has_doc ? right_lot : left_lot;
-                // Ok, let's try to move a payment from pay_lot to doc_lot
-                gncOwnerOffsetLots (pay_lot, doc_lot, owner);
+                g_queue_delete_link (queue, qnode);
+                qnode = next;
+                continue;
             }
 
-            /* If we get here, then right_lot was modified
-             * If the lot has a document, send an event for send an event for it as well
-             * so it gets potentially updated as paid */
-
-            {
-                GncInvoice *this_invoice = gncInvoiceGetInvoiceFromLot(right_lot);
-                if (this_invoice)
-                    qof_event_gen (QOF_INSTANCE(this_invoice), QOF_EVENT_MODIFY, NULL);
-            }
+            gncOwnerOffsetLotPair (left->lot, left->balance,
+                                   right->lot, right->balance, owner);
             left_modified = TRUE;
+
+            left->balance = gnc_lot_get_balance (left->lot);
+            right->balance = gnc_lot_get_balance (right->lot);
+            if (gnc_numeric_zero_p (right->balance))
+                g_queue_delete_link (queue, qnode);
+            qnode = next;
         }
 
         /* If left_lot was modified and the lot has a document,
@@ -1384,13 +1692,15 @@ void gncOwnerAutoApplyPaymentsWithLots (const GncOwner *owner, GList *lots)
          * so it gets potentially updated as paid */
         if (left_modified)
         {
-            GncInvoice *this_invoice = gncInvoiceGetInvoiceFromLot(left_lot);
+            GncInvoice *this_invoice = gncInvoiceGetInvoiceFromLot(left->lot);
             if (this_invoice)
                 qof_event_gen (QOF_INSTANCE(this_invoice), QOF_EVENT_MODIFY, NULL);
         }
         xaccAccountCommitEdit (acct);
-
     }
+
+    g_hash_table_destroy (acct_queues);
+    g_free (apply);
 }
 
 /*
@@ -1418,8 +1728,8 @@ gncOwnerApplyPaymentSecs (const GncOwner *owner, Transaction **preset_txn,
     if (lots)
         selected_lots = lots;
     else if (auto_pay)
-        selected_lots = xaccAccountFindOpenLots (posted_acc, gncOwnerLotMatchOwnerFunc,
-                        (gpointer)owner, NULL);
+        selected_lots = gncOwnerFindOpenLots (owner, posted_acc,
+                                              (GCompareFunc)gncOwnerLotsSortFunc);
 
     /* If there's a real amount to transfer create a lot for this payment */
     if (!gnc_numeric_zero_p (amount))
@@ -1495,41 +1805,34 @@ gncOwnerGetBalanceInCurrency (const GncOwner *owner,
     else
     {
         /* No valid cache value found for balance. Let's recalculate */
-        GList *acct_list  = gnc_account_get_descendants (gnc_book_get_root_account (book));
         GList *acct_types = gncOwnerGetAccountTypesList (owner);
-        GList *acct_node;
+        GList *lot_list = gncOwnerFindOpenLots (owner, NULL, NULL);
+        GList *lot_node;
 
-        /* For each account */
-        for (acct_node = acct_list; acct_node; acct_node = acct_node->next)
+        /* For each open lot of this owner */
+        for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
         {
-            Account *account = acct_node->data;
-            GList *lot_list = NULL, *lot_node;
-
-            /* Check if this account can have lots for the owner, otherwise skip to next */
-            if (g_list_index (acct_types, (gpointer)xaccAccountGetType (account))
+            GNCLot *lot = lot_node->data;
+            Account *account = gnc_lot_get_account (lot);
+            gnc_numeric lot_balance;
+            GncInvoice *invoice;
+
+            /* Check if this lot's account can hold the owner's documents */
+            if (!account ||
+                g_list_index (acct_types, (gpointer)xaccAccountGetType (account))
                     == -1)
                 continue;
 
-
             if (!gnc_commodity_equal (owner_currency, xaccAccountGetCommodity (account)))
                 continue;
 
-            /* Get a list of open lots for this owner and account */
-            lot_list = xaccAccountFindOpenLots (account, gncOwnerLotMatchOwnerFunc,
-                                                (gpointer)owner, NULL);
-            /* For each lot */
-            for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
-            {
-                GNCLot *lot = lot_node->data;
-                gnc_numeric lot_balance = gnc_lot_get_balance (lot);
-                GncInvoice *invoice = gncInvoiceGetInvoiceFromLot(lot);
-                if (invoice)
+            lot_balance = gnc_lot_get_balance (lot);
+            invoice = gncInvoiceGetInvoiceFromLot(lot);
+            if (invoice)
                 balance = gnc_numeric_add (balance, lot_balance,
-                                            gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
-            }
-            g_list_free (lot_list);
+                                           gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
         }
-        g_list_free (acct_list);
+        g_list_free (lot_list);
         g_list_free (acct_types);
 
         gncOwnerSetCachedBalance (owner, &balance);
@@ -191,6 +191,24 @@ void gncOwnerAttachToLot (const GncOwner *owner, GNCLot *lot);
  */
 gboolean gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data);
 
+/** Returns the open lots attached to the owner, directly, through one
+ * of its jobs or through an invoice, without searching all the lots
+ * of the book.  The owner must be a customer, vendor or employee, as
+ * with gncOwnerLotMatchOwnerFunc.  The lots are looked up in an index
+ * maintained per book.
+ *
+ * @param owner The owner whose lots to find.
+ *
+ * @param account If not NULL, only lots in this account are returned.
+ *
+ * @param sort_func If not NULL, sorts the returned list, otherwise its
+ * order is undefined.
+ *
+ * @return A list of lots. The caller must free the list but not the lots.
+ */
+LotList * gncOwnerFindOpenLots (const GncOwner *owner, const Account *account,
+                                GCompareFunc sort_func);
+
 /** Helper function used to sort lots by date. If the lot is
  * linked to an invoice, use the invoice posted date, otherwise
  * use the lot's opened date.
@@ -234,11 +252,13 @@ gncOwnerCreatePaymentLotSecs (const GncOwner *owner, Transaction **preset_txn,
  *
  * The function starts with the first lot in the list and tries to
  * create balancing transactions to the remainder of the lots in the
- * list. If it reaches the end of the list, it will find the next
+ * list, until that lot is balanced. Then it will find the next
  * still open lot in the list and tries to balance it with all lots
  * that follow it (the ones that precede it are either already closed
  * or not suitable or they would have been processed in a previous
- * iteration).
+ * iteration). Only lots in the same account with a balance of the
+ * opposite sign are considered, so a list of many documents and a
+ * few payments is processed in roughly linear time.
  *
  * By intelligently sorting the list of lots, you can play with the
  * order of precedence in which the lots should be processed. For
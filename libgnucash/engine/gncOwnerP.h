@@ -33,6 +33,15 @@
 gboolean gncOwnerRegister (void);
 const gnc_numeric *gncOwnerGetCachedBalance (const GncOwner *owner);
 void gncOwnerSetCachedBalance (const GncOwner *owner, const gnc_numeric *new_bal);
+/** Refreshes the owner lot index entry of a lot whose owner or invoice
+ *  was just set or cleared. */
+void gncOwnerLotIndexUpdate (GNCLot *lot);
+/** Offsets two lots of opposite sign against each other as far as
+ *  possible, the way gncOwnerAutoApplyPaymentsWithLots does for each
+ *  pair of lots it matches. */
+void gncOwnerOffsetLotPair (GNCLot *left_lot, gnc_numeric left_lot_bal,
+                            GNCLot *right_lot, gnc_numeric right_lot_bal,
+                            const GncOwner *owner);
 
 
 #endif /* GNC_OWNERP_H_ */
@@ -57,6 +57,136 @@
 #include <sstream>
 #include <string>
 #include <algorithm>
+#include <array>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Hex encoding and decoding of the 16 GUID bytes.  A GUID is exactly one
+ * SSE2 register, so where SSE2 is available all 32 digits are converted at
+ * once without branching on individual characters. */
+
+#ifdef __SSE2__
+/* Nibbles 0-15 to '0'-'9', 'a'-'f'. */
+static inline __m128i
+hex_digits (__m128i nibbles)
+{
+    auto letters = _mm_cmpgt_epi8 (nibbles, _mm_set1_epi8 (9));
+    auto digits = _mm_add_epi8 (nibbles, _mm_set1_epi8 ('0'));
+    return _mm_add_epi8 (digits, _mm_and_si128 (letters,
+                                                _mm_set1_epi8 ('a' - '0' - 10)));
+}
+
+/* The values of 16 hex digits, either case; lanes holding anything else are
+ * cleared in valid. */
+static inline __m128i
+hex_values (__m128i chars, __m128i& valid)
+{
+    auto digit = _mm_sub_epi8 (chars, _mm_set1_epi8 ('0'));
+    auto is_digit = _mm_and_si128 (_mm_cmpgt_epi8 (digit, _mm_set1_epi8 (-1)),
+                                   _mm_cmplt_epi8 (digit, _mm_set1_epi8 (10)));
+    auto letter = _mm_sub_epi8 (_mm_or_si128 (chars, _mm_set1_epi8 (0x20)),
+                                _mm_set1_epi8 ('a'));
+    auto is_letter = _mm_and_si128 (_mm_cmpgt_epi8 (letter, _mm_set1_epi8 (-1)),
+                                    _mm_cmplt_epi8 (letter, _mm_set1_epi8 (6)));
+    valid = _mm_or_si128 (is_digit, is_letter);
+    return _mm_or_si128 (_mm_and_si128 (is_digit, digit),
+                         _mm_and_si128 (is_letter,
+                                        _mm_add_epi8 (letter, _mm_set1_epi8 (10))));
+}
+
+/* Pairs of digit values, high nibble first, to 8 bytes in the low half. */
+static inline __m128i
+hex_pack (__m128i values)
+{
+    auto high = _mm_slli_epi16 (_mm_and_si128 (values, _mm_set1_epi16 (0x00ff)), 4);
+    return _mm_or_si128 (high, _mm_srli_epi16 (values, 8));
+}
+
+static void
+encode_hex (const unsigned char* data, char* str) noexcept
+{
+    auto bytes = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (data));
+    auto mask = _mm_set1_epi8 (0x0f);
+    auto high = hex_digits (_mm_and_si128 (_mm_srli_epi16 (bytes, 4), mask));
+    auto low = hex_digits (_mm_and_si128 (bytes, mask));
+    _mm_storeu_si128 (reinterpret_cast<__m128i*> (str),
+                      _mm_unpacklo_epi8 (high, low));
+    _mm_storeu_si128 (reinterpret_cast<__m128i*> (str + 16),
+                      _mm_unpackhi_epi8 (high, low));
+}
+
+static bool
+decode_hex (const char* str, unsigned char* data) noexcept
+{
+    __m128i valid1, valid2;
+    auto values1 = hex_values (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (str)), valid1);
+    auto values2 = hex_values (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (str + 16)), valid2);
+    if (_mm_movemask_epi8 (_mm_and_si128 (valid1, valid2)) != 0xffff)
+        return false;
+    _mm_storeu_si128 (reinterpret_cast<__m128i*> (data),
+                      _mm_packus_epi16 (hex_pack (values1), hex_pack (values2)));
+    return true;
+}
+
+#else /* __SSE2__ */
+
+/* The value of each hex digit, -1 for any other character. */
+static const auto hex_value_table = [] {
+    std::array<signed char, 256> table;
+    table.fill (-1);
+    for (int i = 0; i < 10; ++i)
+        table['0' + i] = i;
+    for (int i = 0; i < 6; ++i)
+        table['a' + i] = table['A' + i] = 10 + i;
+    return table;
+} ();
+
+static void
+encode_hex (const unsigned char* data, char* str) noexcept
+{
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < GUID_DATA_SIZE; ++i)
+    {
+        *str++ = digits[data[i] >> 4];
+        *str++ = digits[data[i] & 0x0f];
+    }
+}
+
+static bool
+decode_hex (const char* str, unsigned char* data) noexcept
+{
+    unsigned char bytes[GUID_DATA_SIZE];
+    int bad = 0;
+    for (int i = 0; i < GUID_DATA_SIZE; ++i)
+    {
+        int high = hex_value_table[static_cast<unsigned char> (*str++)];
+        int low = hex_value_table[static_cast<unsigned char> (*str++)];
+        bad |= high | low;
+        bytes[i] = (high << 4) | (low & 0x0f);
+    }
+    if (bad < 0)
+        return false;
+    memcpy (data, bytes, GUID_DATA_SIZE);
+    return true;
+}
+
+#endif /* __SSE2__ */
+
+void
+guid_encode_hex (const GncGUID& guid, char* str) noexcept
+{
+    encode_hex (guid.reserved, str);
+}
+
+bool
+guid_decode_hex (const char* str, GncGUID& guid) noexcept
+{
+    if (!str || strnlen (str, GUID_ENCODING_LENGTH + 1) != GUID_ENCODING_LENGTH)
+        return false;
+    return decode_hex (str, guid.reserved);
+}
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -164,9 +294,9 @@ gchar *
 guid_to_string (const GncGUID * guid)
 {
     if (!guid) return nullptr;
-    gnc::GUID temp {*guid};
-    auto temp_str = temp.to_string ();
-    return g_strdup (temp_str.c_str ());
+    auto str = static_cast<gchar*> (g_malloc (GUID_ENCODING_LENGTH + 1));
+    guid_to_string_buff (guid, str);
+    return str;
 }
 
 gchar *
@@ -174,13 +304,9 @@ guid_to_string_buff (const GncGUID * guid, gchar *str)
 {
     if (!str || !guid) return nullptr;
 
-    gnc::GUID temp {*guid};
-    auto val = temp.to_string ();
-    /*We need to be sure to copy the terminating null character.
-     * The standard guarantees that std::basic_string::c_str ()
-     * returns with a terminating null character, too.*/
-    std::copy (val.c_str (), val.c_str () + val.size () + 1, str);
-    return str + val.size ();
+    encode_hex (guid->reserved, str);
+    str[GUID_ENCODING_LENGTH] = '\0';
+    return str + GUID_ENCODING_LENGTH;
 }
 
 gboolean
@@ -188,6 +314,10 @@ string_to_guid (const char * str, GncGUID * guid)
 {
     if (!guid || !str || !*str) return false;
 
+    /* Everything we write is plain hex; anything else goes through boost,
+     * which also understands the dashed and braced forms. */
+    if (guid_decode_hex (str, *guid))
+        return true;
     try
     {
         guid_assign (*guid, gnc::GUID::from_string (str));
@@ -205,9 +335,7 @@ guid_equal (const GncGUID *guid_1, const GncGUID *guid_2)
 {
     if (!guid_1 || !guid_2)
         return !guid_1 && !guid_2;
-    gnc::GUID temp1 {*guid_1};
-    gnc::GUID temp2 {*guid_2};
-    return temp1 == temp2;
+    return memcmp (guid_1->reserved, guid_2->reserved, GUID_DATA_SIZE) == 0;
 }
 
 gint
@@ -232,22 +360,14 @@ guid_hash_to_guint (gconstpointer ptr)
         PERR ("received nullptr guid pointer.");
         return 0;
     }
-    GncGUID const & guid = * reinterpret_cast <GncGUID const *> (ptr);
-    gnc::GUID const & temp {guid};
-
-    guint hash {0};
-    std::for_each (temp.begin (), temp.end (), [&hash] (unsigned char a) {
-        hash <<=4;
-        hash |= a;
-    });
-    return hash;
+    auto hash = guid_hash (* reinterpret_cast <GncGUID const *> (ptr));
+    return static_cast<guint> (hash ^ (hash >> 32));
 }
 
 gint
 guid_g_hash_table_equal (gconstpointer guid_a, gconstpointer guid_b)
 {
-    return guid_equal (reinterpret_cast<const GncGUID*> (guid_a),
-		       reinterpret_cast<const GncGUID*> (guid_b));
+    return memcmp (guid_a, guid_b, GUID_DATA_SIZE) == 0;
 }
 
 GHashTable *
@@ -304,7 +424,9 @@ namespace gnc
 GUID
 GUID::create_random () noexcept
 {
-    static boost::uuids::random_generator gen;
+    /* One generator per thread; the XML loader reads GUIDs on worker
+     * threads and random_generator isn't safe to share. */
+    static thread_local boost::uuids::random_generator gen;
     return {gen ()};
 }
 
@@ -322,11 +444,8 @@ GUID::null_guid () noexcept
 std::string
 GUID::to_string () const noexcept
 {
-    auto const & val = boost::uuids::to_string (implementation);
-    std::string ret;
-    std::for_each (val.begin (), val.end (), [&ret] (char a) {
-        if (a != '-') ret.push_back (a);
-    });
+    std::string ret (GUID_ENCODING_LENGTH, '\0');
+    encode_hex (implementation.begin (), &ret[0]);
     return ret;
 }
 
@@ -335,6 +454,9 @@ GUID::from_string (const char* str)
 {
     if (!str)
         throw guid_syntax_exception {};
+    GncGUID guid;
+    if (guid_decode_hex (str, guid))
+        return guid;
     try
     {
         static boost::uuids::string_generator strgen;
@@ -349,6 +471,9 @@ GUID::from_string (const char* str)
 bool
 GUID::is_valid_guid (const char* str)
 {
+    GncGUID guid;
+    if (guid_decode_hex (str, guid))
+        return true;
     try
     {
         static boost::uuids::string_generator strgen;
@@ -427,5 +552,5 @@ GUID::operator GncGUID () const noexcept
 bool
 operator==(const GncGUID& lhs, const GncGUID& rhs)
 {
-    return gnc::GUID{lhs} == gnc::GUID{rhs};
+    return memcmp (lhs.reserved, rhs.reserved, GUID_DATA_SIZE) == 0;
 }
@@ -23,6 +23,8 @@
 #define GUID_HPP_HEADER
 
 #include <boost/uuid/uuid.hpp>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
@@ -68,4 +70,34 @@ bool operator == (GUID const &, GncGUID const &) noexcept;
 } // namespace gnc
 
 bool operator== (const GncGUID&, const GncGUID&);
+
+/** Write the GUID_ENCODING_LENGTH lower-case hex digits of a GUID to @a str,
+ *  which is not null-terminated.  Never allocates.
+ */
+void guid_encode_hex (const GncGUID& guid, char* str) noexcept;
+
+/** Read a GUID from a string of exactly GUID_ENCODING_LENGTH hex digits of
+ *  either case.  Never allocates or throws.
+ *  @return false, leaving @a guid unchanged, for any other string.
+ */
+bool guid_decode_hex (const char* str, GncGUID& guid) noexcept;
+
+/** A hash of all 128 bits of a GUID, mixed so that GUIDs that aren't random,
+ *  e.g. ones differing only in a few bytes, still spread over a hash table.
+ */
+inline uint64_t
+guid_hash (const GncGUID& guid) noexcept
+{
+    uint64_t lo, hi;
+    std::memcpy (&lo, guid.reserved, sizeof lo);
+    std::memcpy (&hi, guid.reserved + sizeof lo, sizeof hi);
+    /* Combine the halves, then mix with MurmurHash3's 64-bit finalizer. */
+    auto hash = lo ^ (hi * UINT64_C(0x9e3779b97f4a7c15));
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+    return hash;
+}
 #endif
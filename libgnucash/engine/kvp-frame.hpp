@@ -238,18 +238,28 @@ struct KvpFrameImpl
     KvpValue * set_impl (std::string const &, KvpValue *) noexcept;
 };
 
+/* Keys sharing a prefix sort together, starting at the first key that is not
+ * less than the prefix itself, so only the matching range is visited. */
 template<typename func_type, typename data_type>
 void KvpFrame::for_each_slot_prefix(std::string const & prefix,
         func_type const & func, data_type & data) const noexcept
 {
-    std::for_each (m_valuemap.begin(), m_valuemap.end(),
-        [&prefix,&func,&data](const KvpFrameImpl::map_type::value_type & a)
-        {
-            /* Testing for prefix matching */
-            if (strncmp(a.first, prefix.c_str(), prefix.size()) == 0)
-                func (&a.first[prefix.size()], a.second, data);
-        }
-    );
+    for (auto iter = m_valuemap.lower_bound (prefix.c_str());
+         iter != m_valuemap.end() &&
+             strncmp(iter->first, prefix.c_str(), prefix.size()) == 0;
+         ++iter)
+        func (&iter->first[prefix.size()], iter->second, data);
+}
+
+template<typename func_type>
+void KvpFrame::for_each_slot_prefix(std::string const & prefix,
+        func_type const & func) const noexcept
+{
+    for (auto iter = m_valuemap.lower_bound (prefix.c_str());
+         iter != m_valuemap.end() &&
+             strncmp(iter->first, prefix.c_str(), prefix.size()) == 0;
+         ++iter)
+        func (&iter->first[prefix.size()], iter->second);
 }
 
 template <typename func_type>
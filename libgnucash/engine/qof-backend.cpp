@@ -168,6 +168,27 @@ qof_backend_rollback_instance (QofBackend* qof_be, QofInstance* inst)
     ((QofBackend*)qof_be)->rollback(inst);
 }
 
+void
+qof_backend_begin_group_commit (QofBackend* qof_be)
+{
+    if (qof_be == nullptr) return;
+    qof_be->begin_group_commit();
+}
+
+gboolean
+qof_backend_end_group_commit (QofBackend* qof_be)
+{
+    if (qof_be == nullptr) return TRUE;
+    return qof_be->end_group_commit();
+}
+
+void
+qof_backend_load_older (QofBackend* qof_be, QofInstance* inst, time64 since)
+{
+    if (qof_be == nullptr) return;
+    qof_be->load_older(inst, since);
+}
+
 gboolean
 qof_load_backend_library (const char *directory, const char* module_name)
 {
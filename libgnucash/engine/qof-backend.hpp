@@ -210,6 +210,30 @@ public:
  *    better to wait for the query).
  */
     virtual void load (QofBook*, QofBackendLoadType) = 0;
+/**
+ *    Load the data belonging to inst that dates from since or later but was
+ *    left out by load(). A null inst stands for everything.
+ */
+    virtual void load_older(QofInstance*, time64) {}
+/**
+ *    Translate a query into the backend's own form so that run_query() can
+ *    find its candidates without the engine visiting every object. Return
+ *    nullptr if the query can't be translated; the engine then searches
+ *    everything itself.
+ */
+    virtual void* compile_query(QofQuery*) { return nullptr; }
+/**
+ *    Fill candidates with the objects that might match a query compiled by
+ *    compile_query(), loading them if need be. They needn't all match: the
+ *    engine still applies the query's terms, sort and limit to them, but any
+ *    object left out won't be found.
+ *    @return false if the engine must search everything after all.
+ */
+    virtual bool run_query(void*, std::vector<QofInstance*>&) { return false; }
+/**
+ *    Free a query compiled by compile_query().
+ */
+    virtual void free_query(void*) {}
 /**
  *    Called when the engine is about to make a change to a data structure. It
  *    could provide an advisory lock on data, but no backend does this.
@@ -223,6 +247,16 @@ public:
  *    Revert changes in the engine and unlock the backend.
  */
     virtual void rollback(QofInstance*) {}
+/**
+ *    Hold commits until the matching end_group_commit() so that they can be
+ *    stored together. Calls nest; only the outermost pair matters.
+ */
+    virtual void begin_group_commit() {}
+/**
+ *    Store everything committed since the outermost begin_group_commit().
+ *    @return false if that failed.
+ */
+    virtual bool end_group_commit() { return true; }
 /**
  *    Synchronizes the engine contents to the backend.
  *    This should done by using version numbers (hack alert -- the engine
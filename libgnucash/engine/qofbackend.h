@@ -138,6 +138,28 @@ typedef struct QofBackend QofBackend;
     gboolean qof_backend_can_rollback (QofBackend*);
     void qof_backend_rollback_instance (QofBackend*, QofInstance*);
 
+/** Store the instances committed until the matching
+ *  qof_backend_end_group_commit() together instead of one at a time; a
+ *  database backend uses a single transaction for them.  Calls nest, and
+ *  both do nothing without a backend.  Use this around loops that commit
+ *  many instances, e.g. creating scheduled transactions or importing.
+ */
+    void qof_backend_begin_group_commit (QofBackend*);
+/** End a group begun with qof_backend_begin_group_commit().  At the
+ *  outermost level the group is stored.
+ *  @return FALSE if storing it failed, in which case the instances committed
+ *  in the group are left dirty and the backend error is set.
+ */
+    gboolean qof_backend_end_group_commit (QofBackend*);
+
+/** Load the data belonging to an instance that dates from @a since or later
+ *  but was left out of the initial load.  Only the SQL backend leaves data
+ *  out, and only the splits of an account can be loaded this way; a NULL
+ *  instance loads them for every account, and a @a since of INT64_MIN
+ *  loads everything that was left out.
+ */
+    void qof_backend_load_older (QofBackend*, QofInstance*, time64 since);
+
 /** \brief Load a QOF-compatible backend shared library.
 
     \param directory Can be NULL if filename is a complete path.
@@ -30,15 +30,133 @@
 #include "qof.h"
 #include "qofid-p.h"
 #include "qofinstance-p.h"
+#include "guid.hpp"
+
+#include <vector>
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
+/* The instances of a collection by GUID: an open-addressing hash table with
+ * linear probing whose slots hold a copy of the GUID, so that a lookup only
+ * reads the contiguous slot array. Removal shifts the following entries back
+ * instead of leaving tombstones.
+ */
+class QofEntityTable
+{
+public:
+    QofInstance* lookup (const GncGUID& guid) const noexcept;
+    /** Replaces any instance already stored under guid. */
+    void insert (const GncGUID& guid, QofInstance* inst);
+    void remove (const GncGUID& guid) noexcept;
+    guint size () const noexcept { return m_size; }
+    /** The instances, in no particular order. Free the list. */
+    GList* values () const noexcept;
+
+private:
+    struct Slot
+    {
+        GncGUID guid;
+        QofInstance* inst;      /* nullptr for an empty slot */
+    };
+    size_t find (const GncGUID& guid) const noexcept;
+    void grow ();
+
+    std::vector<Slot> m_slots;  /* The size is always a power of two. */
+    guint m_size = 0;
+};
+
+/* Returns the index of the slot holding guid or of the empty slot where it
+ * would go. There must be at least one empty slot. */
+size_t
+QofEntityTable::find (const GncGUID& guid) const noexcept
+{
+    auto mask = m_slots.size () - 1;
+    for (auto index = guid_hash (guid) & mask; ; index = (index + 1) & mask)
+    {
+        auto& slot = m_slots[index];
+        if (!slot.inst || memcmp (&slot.guid, &guid, sizeof guid) == 0)
+            return index;
+    }
+}
+
+QofInstance*
+QofEntityTable::lookup (const GncGUID& guid) const noexcept
+{
+    if (m_slots.empty ())
+        return nullptr;
+    return m_slots[find (guid)].inst;
+}
+
+void
+QofEntityTable::grow ()
+{
+    std::vector<Slot> old_slots (m_slots.empty () ? 16 : 2 * m_slots.size (),
+                                 Slot {{}, nullptr});
+    m_slots.swap (old_slots);
+    for (auto const& slot : old_slots)
+        if (slot.inst)
+            m_slots[find (slot.guid)] = slot;
+}
+
+void
+QofEntityTable::insert (const GncGUID& guid, QofInstance* inst)
+{
+    /* Keep the table at most three quarters full. */
+    if (4 * (m_size + 1) > 3 * m_slots.size ())
+        grow ();
+    auto& slot = m_slots[find (guid)];
+    if (!slot.inst)
+    {
+        slot.guid = guid;
+        ++m_size;
+    }
+    slot.inst = inst;
+}
+
+void
+QofEntityTable::remove (const GncGUID& guid) noexcept
+{
+    if (m_slots.empty ())
+        return;
+    auto hole = find (guid);
+    if (!m_slots[hole].inst)
+        return;
+
+    /* Move back each following entry of the run that may do so without
+     * getting in front of its home slot. */
+    auto mask = m_slots.size () - 1;
+    for (auto index = (hole + 1) & mask; m_slots[index].inst;
+         index = (index + 1) & mask)
+    {
+        auto home = guid_hash (m_slots[index].guid) & mask;
+        auto stays = hole <= index ? (hole < home && home <= index) :
+            (hole < home || home <= index);
+        if (!stays)
+        {
+            m_slots[hole] = m_slots[index];
+            hole = index;
+        }
+    }
+    m_slots[hole].inst = nullptr;
+    --m_size;
+}
+
+GList*
+QofEntityTable::values () const noexcept
+{
+    GList* list = nullptr;
+    for (auto const& slot : m_slots)
+        if (slot.inst)
+            list = g_list_prepend (list, slot.inst);
+    return list;
+}
+
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    QofEntityTable * entities;
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
@@ -50,7 +168,7 @@ qof_collection_new (QofIdType type)
     QofCollection *col;
     col = g_new0(QofCollection, 1);
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
-    col->hash_of_entities = guid_hash_table_new();
+    col->entities = new QofEntityTable;
     col->data = NULL;
     return col;
 }
@@ -59,9 +177,9 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
+    delete col->entities;
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
+    col->entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
@@ -87,7 +205,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    col->entities->remove (*guid);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -101,7 +219,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    col->entities->insert (*guid, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -127,7 +245,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    coll->entities->insert (*guid, ent);
     return TRUE;
 }
 
@@ -214,8 +332,7 @@ qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
     QofInstance *ent;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
+    ent = col->entities->lookup (*guid);
     if (ent != NULL && qof_instance_get_destroying(ent)) return NULL;	
     return ent;
 }
@@ -245,7 +362,7 @@ qof_collection_count (const QofCollection *col)
 {
     guint c;
 
-    c = g_hash_table_size(col->hash_of_entities);
+    c = col->entities->size();
     return c;
 }
 
@@ -311,15 +428,15 @@ qof_collection_foreach_sorted (const QofCollection *col, QofInstanceForeachCB cb
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s before is %d", col->e_type, col->entities->size());
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
+    entries = col->entities->values ();
     if (sort_fn)
         entries = g_list_sort (entries, sort_fn);
     g_list_foreach (entries, (GFunc)cb_func, user_data);
     g_list_free (entries);
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s after is %d", col->e_type, col->entities->size());
 }
 
 void
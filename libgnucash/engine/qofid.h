@@ -118,7 +118,7 @@ print error message if its bad  */
 
 @param e_type QofIdType
 @param is_dirty gboolean
-@param hash_of_entities GHashTable
+@param entities The instances, by GUID
 @param data gpointer, place where object class can hang arbitrary data
 
 */
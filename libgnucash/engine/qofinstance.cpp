@@ -1324,9 +1324,8 @@ std::vector <std::pair <std::string, KvpValue*>>
 qof_instance_get_slots_prefix (QofInstance const * inst, std::string const & prefix)
 {
     std::vector <std::pair <std::string, KvpValue*>> ret;
-    inst->kvp_data->for_each_slot_temp ([&prefix, &ret] (std::string const & key, KvpValue * val) {
-        if (key.find (prefix) == 0)
-            ret.emplace_back (key, val);
+    inst->kvp_data->for_each_slot_prefix (prefix, [&prefix, &ret] (char const * suffix, KvpValue * val) {
+        ret.emplace_back (prefix + suffix, val);
     });
     return ret;
 }
@@ -212,6 +212,22 @@ qof_object_foreach (QofIdTypeConst type_name, QofBook *book,
     return;
 }
 
+gboolean
+qof_object_query_candidates (QofIdTypeConst type_name, QofBook *book,
+                             QofQuery *query, QofInstanceForeachCB cb,
+                             gpointer user_data)
+{
+    const QofObject *obj;
+
+    if (!book || !type_name || !query)
+        return FALSE;
+
+    obj = qof_object_lookup (type_name);
+    if (!obj || !obj->query_candidates)
+        return FALSE;
+    return obj->query_candidates (book, query, cb, user_data);
+}
+
 static void
 do_prepend (QofInstance *qof_p, gpointer list_p)
 {
@@ -50,6 +50,7 @@
 
 #include "qofbook.h"
 #include "qofid.h"
+#include "qofquery.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -123,6 +124,14 @@ struct _QofObject
      *  to or later than than 'instance_right'.
      */
     int                 (*version_cmp)(gpointer instance_left, gpointer instance_right);
+
+    /** Call the callback on the items in the book that might match the
+     *  query, found e.g. with an index the object keeps, and return TRUE.
+     *  Return FALSE without calling it if the query can't be narrowed down
+     *  that way; it then visits every item.  May be NULL.
+     */
+    gboolean            (*query_candidates)(QofBook *, QofQuery *,
+                                            QofInstanceForeachCB, gpointer);
 };
 
 /* -------------------------------------------------------------- */
@@ -166,6 +175,15 @@ void qof_object_foreach_type (QofForeachTypeCB cb, gpointer user_data);
 void qof_object_foreach (QofIdTypeConst type_name, QofBook *book,
                          QofInstanceForeachCB cb, gpointer user_data);
 
+/** Invoke the callback 'cb' on the instances of a particular object
+ *  type in the book that might match the query, if the object type can
+ *  find them without visiting every instance.
+ *  @return FALSE, without invoking the callback, if it can't.
+ */
+gboolean qof_object_query_candidates (QofIdTypeConst type_name, QofBook *book,
+                                      QofQuery *query, QofInstanceForeachCB cb,
+                                      gpointer user_data);
+
 /** Invoke callback 'cb' on each instance in guid orted order */
 void qof_object_foreach_sorted (QofIdTypeConst type_name, QofBook *book,
                                 QofInstanceForeachCB cb, gpointer user_data);
@@ -29,10 +29,19 @@
 #include <regex.h>
 #include <string.h>
 
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "qof.h"
 #include "qof-backend.hpp"
 #include "qofbook-p.h"
 #include "qofclass-p.h"
+#include "qofquery.hpp"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
 
@@ -103,12 +112,23 @@ struct _QofQuery
     GList *           results;
 };
 
-typedef struct _QofQueryCB
+/* Collects the objects a query run should test. */
+struct QofQueryCB
 {
-    QofQuery *        query;
-    GList *           list;
-    gint              count;
-} QofQueryCB;
+    QofQuery *                query;
+    std::vector<gpointer>     objects;
+};
+
+/* Below this many objects starting threads to test them costs more than
+ * it saves. */
+#define QUERY_PARALLEL_MIN_OBJECTS 100000
+#define QUERY_MAX_THREADS 8
+
+static size_t parallel_min_objects = QUERY_PARALLEL_MIN_OBJECTS;
+
+/* The object type and name of each parameter whose getter only reads the
+ * object it's given. */
+static std::set<std::pair<std::string, std::string>> thread_safe_params;
 
 /* Query Print functions for use with qof_log_set_level, static prototypes */
 static GList *qof_query_printSearchFor (QofQuery * query, GList * output);
@@ -372,6 +392,30 @@ sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
     }
 }
 
+/* Sort the objects and keep the last max_results of them, without
+ * sorting the rest.  Ties are broken by position, so the result is the
+ * same as that of a stable sort followed by the crop. */
+static void
+select_last_sorted (std::vector<gpointer>& objects, QofQuery *q)
+{
+    std::vector<std::pair<gpointer, size_t>> items;
+    items.reserve (objects.size());
+    for (auto object : objects)
+        items.emplace_back (object, items.size());
+
+    auto later = [q](const auto& a, const auto& b)
+    {
+        auto cmp = sort_func (a.first, b.first, q);
+        return cmp ? cmp > 0 : a.second > b.second;
+    };
+    auto last = items.begin() + std::min<size_t> (q->max_results, items.size());
+    std::partial_sort (items.begin(), last, items.end(), later);
+
+    objects.clear();
+    for (auto it = last; it != items.begin();)
+        objects.push_back ((--it)->first);
+}
+
 /* ==================================================================== */
 /* This is the main workhorse for performing the query.  For each
  * object, it walks over all of the query terms to see if the
@@ -564,37 +608,148 @@ static void compile_terms (QofQuery *q)
     compile_sort (&(q->tertiary_sort), q->search_for);
 
     q->defaultSort = qof_class_get_default_sort (q->search_for);
-#ifdef QOF_BACKEND_QUERY
+
     /* Now compile the backend instances */
-    for (node = q->books; node; node = node->next)
+    for (auto node = q->books; node; node = node->next)
     {
         QofBook* book = static_cast<QofBook*>(node->data);
-        QofBackend* be = book->backend;
+        QofBackend* be = qof_book_get_backend (book);
 
-        if (be && be->compile_query)
+        if (be)
         {
-            gpointer result = (be->compile_query)(be, q);
+            gpointer result = be->compile_query (q);
             if (result)
                 g_hash_table_insert (q->be_compiled, book, result);
         }
-
     }
-#endif
     LEAVE (" query=%p", q);
 }
 
-static void check_item_cb (gpointer object, gpointer user_data)
+static void collect_item_cb (gpointer object, gpointer user_data)
 {
     QofQueryCB* ql = static_cast<QofQueryCB*>(user_data);
 
     if (!object || !ql) return;
 
-    if (check_object (ql->query, object))
+    ql->objects.push_back (object);
+}
+
+void
+qof_query_register_thread_safe_param (QofIdTypeConst obj_type,
+                                      const char *param_name)
+{
+    g_return_if_fail (obj_type && param_name);
+    thread_safe_params.emplace (obj_type, param_name);
+}
+
+size_t
+qof_query_set_parallel_min_objects (size_t min_objects)
+{
+    return std::exchange (parallel_min_objects, min_objects);
+}
+
+/* Walk a term's parameter path from the searched-for type; every getter
+ * along it must have been registered as thread safe. */
+static bool
+param_path_is_thread_safe (QofIdTypeConst obj_type, const QofQueryTerm *qt)
+{
+    if (g_slist_length (qt->param_fcns) != g_slist_length (qt->param_list))
+        return false;
+    for (auto node = qt->param_fcns; node; node = node->next)
     {
-        ql->list = g_list_prepend (ql->list, object);
-        ql->count++;
+        auto param = static_cast<const QofParam*>(node->data);
+        if (!thread_safe_params.count ({obj_type, param->param_name}))
+            return false;
+        obj_type = param->param_type;
     }
-    return;
+    return true;
+}
+
+/* The predicates of these types only read the objects they're given, so
+ * terms of them can be tested on several threads at once as long as their
+ * parameters' getters don't write either. */
+static bool
+query_is_thread_safe (const QofQuery *q)
+{
+    static const char* safe_types[] =
+    {
+        QOF_TYPE_STRING, QOF_TYPE_DATE, QOF_TYPE_NUMERIC, QOF_TYPE_GUID,
+        QOF_TYPE_INT32, QOF_TYPE_INT64, QOF_TYPE_DOUBLE, QOF_TYPE_BOOLEAN,
+        QOF_TYPE_CHAR
+    };
+
+    for (auto or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+        for (auto and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
+             and_ptr = and_ptr->next)
+        {
+            auto qt = static_cast<QofQueryTerm*>(and_ptr->data);
+            auto type = qt->pdata->type_name;
+            if (std::none_of (std::begin (safe_types), std::end (safe_types),
+                              [type](auto safe) { return !g_strcmp0 (type, safe); }) ||
+                !param_path_is_thread_safe (q->search_for, qt))
+                return false;
+        }
+    return true;
+}
+
+struct query_chunk_t
+{
+    const QofQuery *  query;
+    const gpointer *  begin;
+    const gpointer *  end;
+    char *            matches;
+};
+
+static gpointer
+check_chunk (gpointer data)
+{
+    auto chunk = static_cast<query_chunk_t*>(data);
+    auto match = chunk->matches;
+    for (auto object = chunk->begin; object != chunk->end; ++object, ++match)
+        *match = check_object (chunk->query, *object) ? 1 : 0;
+    return nullptr;
+}
+
+/* Keep only the objects that match the query's terms, in order.  Many
+ * objects are split into chunks that are tested on separate threads. */
+static void
+filter_objects (const QofQuery *q, std::vector<gpointer>& objects)
+{
+    auto n_threads = std::min<size_t> (g_get_num_processors (),
+                                       QUERY_MAX_THREADS);
+    if (objects.size() < parallel_min_objects || n_threads < 2 ||
+        !query_is_thread_safe (q))
+    {
+        objects.erase (std::remove_if (objects.begin(), objects.end(),
+                                       [q](gpointer object)
+                                       { return !check_object (q, object); }),
+                       objects.end());
+        return;
+    }
+
+    std::vector<char> matches (objects.size());
+    std::vector<query_chunk_t> chunks;
+    auto chunk_size = (objects.size() + n_threads - 1) / n_threads;
+    for (size_t first = 0; first < objects.size(); first += chunk_size)
+    {
+        auto last = std::min (first + chunk_size, objects.size());
+        chunks.push_back ({q, objects.data() + first, objects.data() + last,
+                           matches.data() + first});
+    }
+
+    /* This thread tests the first chunk itself. */
+    std::vector<GThread*> threads;
+    for (auto chunk = chunks.begin() + 1; chunk != chunks.end(); ++chunk)
+        threads.push_back (g_thread_new ("query", check_chunk, &*chunk));
+    check_chunk (&chunks.front());
+    for (auto thread : threads)
+        g_thread_join (thread);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < objects.size(); ++i)
+        if (matches[i])
+            objects[kept++] = objects[i];
+    objects.resize (kept);
 }
 
 static int param_list_cmp (const QofQueryParamList *l1, const QofQueryParamList *l2)
@@ -639,13 +794,11 @@ static GList * merge_books (GList *l1, GList *l2)
 static gboolean
 query_free_compiled (gpointer key, gpointer value, gpointer not_used)
 {
-#ifdef QOF_BACKEND_QUERY
     QofBook* book = static_cast<QofBook*>(key);
-    QofBackend* be = book->backend;
+    QofBackend* be = qof_book_get_backend (book);
 
-    if (be && be->free_query)
-        (be->free_query)(be, value);
-#endif
+    if (be)
+        be->free_query (value);
     return TRUE;
 }
 
@@ -740,17 +893,17 @@ void qof_query_purge_terms (QofQuery *q, QofQueryParamList *param_list)
     }
 }
 
-static GList * qof_query_run_internal (QofQuery *q,
-                                       void(*run_cb)(QofQueryCB*, gpointer),
-                                       gpointer cb_arg)
+static std::vector<gpointer>
+qof_query_run_internal (QofQuery *q,
+                        void(*run_cb)(QofQueryCB*, gpointer),
+                        gpointer cb_arg)
 {
-    GList *matching_objects = nullptr;
-    int        object_count = 0;
+    using ObjectVec = std::vector<gpointer>;
 
-    if (!q) return nullptr;
-    g_return_val_if_fail (q->search_for, nullptr);
-    g_return_val_if_fail (q->books, nullptr);
-    g_return_val_if_fail (run_cb, nullptr);
+    if (!q) return ObjectVec{};
+    g_return_val_if_fail (q->search_for, ObjectVec{});
+    g_return_val_if_fail (q->books, ObjectVec{});
+    g_return_val_if_fail (run_cb, ObjectVec{});
     ENTER (" q=%p", q);
 
     /* XXX: Prioritize the query terms? */
@@ -767,70 +920,47 @@ static GList * qof_query_run_internal (QofQuery *q,
         qof_query_print (q);
 
     /* Now run the query over all the objects and save the results */
-    {
-        QofQueryCB qcb;
-
-        memset (&qcb, 0, sizeof (qcb));
-        qcb.query = q;
-
-        /* Run the query callback */
-        run_cb(&qcb, cb_arg);
-
-        matching_objects = qcb.list;
-        object_count = qcb.count;
-    }
-    PINFO ("matching objects=%p count=%d", matching_objects, object_count);
-
-    /* There is no absolute need to reverse this list, since it's being
-     * sorted below. However, in the common case, we will be searching
-     * in a confined location where the objects are already in order,
-     * thus reversing will put us in the correct order we want and make
-     * the sorting go much faster.
-     */
-    matching_objects = g_list_reverse(matching_objects);
-
-    /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
-    {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
-    }
-
-    /* Crop the list to limit the number of splits. */
-    if ((object_count > q->max_results) && (q->max_results > -1))
-    {
-        if (q->max_results > 0)
-        {
-            GList *mptr;
-
-            /* mptr is set to the first node of what will be the new list */
-            mptr = g_list_nth(matching_objects, object_count - q->max_results);
-            /* mptr should not be nullptr, but let's be safe */
-            if (mptr != nullptr)
-            {
-                if (mptr->prev != nullptr) mptr->prev->next = nullptr;
-                mptr->prev = nullptr;
-            }
-            g_list_free(matching_objects);
-            matching_objects = mptr;
-        }
-        else
-        {
-            /* q->max_results == 0 */
-            g_list_free(matching_objects);
-            matching_objects = nullptr;
-        }
-    }
+    QofQueryCB qcb{q, ObjectVec{}};
+    run_cb(&qcb, cb_arg);
+    auto matching_objects{std::move (qcb.objects)};
+    filter_objects (q, matching_objects);
+    PINFO ("matching objects=%zu", matching_objects.size());
+
+    /* Now sort the matching objects based on the search criteria, and
+     * crop them to max_results. If they're to be cropped, only the ones
+     * kept need sorting. */
+    auto sorted = q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+        (q->primary_sort.use_default && q->defaultSort);
+    auto crop = q->max_results > -1 &&
+        matching_objects.size() > static_cast<size_t>(q->max_results);
+    if (crop && q->max_results == 0)
+        matching_objects.clear();
+    else if (crop && sorted)
+        select_last_sorted (matching_objects, q);
+    else if (crop)
+        matching_objects.erase (matching_objects.begin(),
+                                matching_objects.end() - q->max_results);
+    else if (sorted)
+        std::stable_sort (matching_objects.begin(), matching_objects.end(),
+                          [q](gpointer a, gpointer b)
+                          { return sort_func (a, b, q) < 0; });
 
     q->changed = 0;
 
-    g_list_free(q->results);
-    q->results = matching_objects;
-
     LEAVE (" q=%p", q);
     return matching_objects;
 }
 
+/* Save a run's results for qof_query_last_run(). */
+static GList *
+query_set_results (QofQuery *q, const std::vector<gpointer>& objects)
+{
+    g_list_free (q->results);
+    q->results = std::accumulate (objects.rbegin(), objects.rend(),
+                                  static_cast<GList*>(nullptr), g_list_prepend);
+    return q->results;
+}
+
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
@@ -841,30 +971,42 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
     for (node = qcb->query->books; node; node = node->next)
     {
         QofBook* book = static_cast<QofBook*>(node->data);
-#ifdef QOF_BACKEND_QUERY
-        QofBackend* be = book->backend;
+        QofBackend* be = qof_book_get_backend (book);
+        gpointer compiled_query = g_hash_table_lookup (qcb->query->be_compiled,
+                                                       book);
 
-
-        if (be)
+        /* Let the backend find the candidates if it can... */
+        std::vector<QofInstance*> candidates;
+        if (be && compiled_query && be->run_query (compiled_query, candidates))
         {
-            gpointer compiled_query = g_hash_table_lookup (qcb->query->be_compiled,
-                                      book);
-
-            if (compiled_query && be->run_query)
-            {
-                (be->run_query) (be, compiled_query);
-            }
+            for (auto inst : candidates)
+                collect_item_cb (inst, qcb);
+            continue;
         }
-#endif
-        /* And then iterate over all the objects */
+
+        /* ...or else the object, which may have an index... */
+        if (qof_object_query_candidates (qcb->query->search_for, book,
+                                         qcb->query,
+                                         (QofInstanceForeachCB) collect_item_cb,
+                                         qcb))
+            continue;
+
+        /* ...or else iterate over all the objects */
         qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+                            (QofInstanceForeachCB) collect_item_cb, qcb);
     }
 }
 
 GList * qof_query_run (QofQuery *q)
 {
-    /* Just a wrapper */
+    if (!q) return nullptr;
+    return query_set_results (q, qof_query_run_internal(q, qof_query_run_cb,
+                                                        nullptr));
+}
+
+std::vector<gpointer>
+qof_query_run_vector (QofQuery *q)
+{
     return qof_query_run_internal(q, qof_query_run_cb, nullptr);
 }
 
@@ -873,7 +1015,7 @@ static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
     QofQuery* pq = static_cast<QofQuery*>(cb_arg);
 
     g_return_if_fail(pq);
-    g_list_foreach(qof_query_last_run(pq), check_item_cb, qcb);
+    g_list_foreach(qof_query_last_run(pq), collect_item_cb, qcb);
 }
 
 GList *
@@ -889,8 +1031,9 @@ qof_query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
                          nullptr);
 
     /* Perform the subquery */
-    return qof_query_run_internal(subq, qof_query_run_subq_cb,
-                                  (gpointer)primaryq);
+    return query_set_results (subq,
+                              qof_query_run_internal(subq, qof_query_run_subq_cb,
+                                                     (gpointer)primaryq));
 }
 
 GList *
@@ -0,0 +1,59 @@
+/**********************************************************************
+ * qofquery.hpp                                                       *
+ *                                                                    *
+ * This program is free software; you can redistribute it and/or      *
+ * modify it under the terms of the GNU General Public License as     *
+ * published by the Free Software Foundation; either version 2 of     *
+ * the License, or (at your option) any later version.                *
+ *                                                                    *
+ * This program is distributed in the hope that it will be useful,    *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of     *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the      *
+ * GNU General Public License for more details.                       *
+ *                                                                    *
+ * You should have received a copy of the GNU General Public License  *
+ * along with this program; if not, contact:                          *
+ *                                                                    *
+ * Free Software Foundation           Voice:  +1-617-542-5942         *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652         *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                     *
+ *                                                                    *
+ *********************************************************************/
+
+/** @addtogroup Query
+    @{ */
+/** @file qofquery.hpp
+ *  @brief Query public routines (C++ api)
+ */
+
+#ifndef QOF_QUERY_HPP
+#define QOF_QUERY_HPP
+
+#include <vector>
+
+#include "qofquery.h"
+
+/** Perform the query like qof_query_run(), returning the matching objects
+ *  in a vector instead of a GList.  The vector belongs to the caller, and
+ *  qof_query_last_run() still returns the results of the last
+ *  qof_query_run().
+ */
+std::vector<gpointer> qof_query_run_vector (QofQuery *q);
+
+/** Declare that the getter of an object type's parameter only reads the
+ *  object.  A query run tests large numbers of objects on several threads
+ *  at once only if every parameter its terms go through was declared
+ *  this way.
+ */
+void qof_query_register_thread_safe_param (QofIdTypeConst obj_type,
+                                           const char *param_name);
+
+/** Set how many objects a query run must test before it uses several
+ *  threads, so that tests can compare parallel and serial runs.
+ *
+ *  @return The previous setting.
+ */
+size_t qof_query_set_parallel_min_objects (size_t min_objects);
+
+#endif /* QOF_QUERY_HPP */
+/** @} */
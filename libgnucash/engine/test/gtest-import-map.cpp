@@ -27,7 +27,9 @@
 #include <qofinstance-p.h>
 #include <kvp-frame.hpp>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 class ImapTest : public testing::Test
 {
@@ -404,3 +406,96 @@ TEST_F (ImapBayesTest, get_bayes_info)
     g_free (acct1_guid);
 }
 
+TEST_F (ImapBayesTest, bayes_batch)
+{
+    auto root = qof_instance_get_slots(QOF_INSTANCE(t_bank_account));
+    auto acct1_guid = guid_to_string (xaccAccountGetGUID(t_expense_account1));
+    auto acct2_guid = guid_to_string (xaccAccountGetGUID(t_expense_account2));
+    root->set_path({std::string{IMAP_FRAME_BAYES} + "/" + foo + "/" + acct1_guid}, new KvpValue{INT64_C(2)});
+    root->set_path({std::string{IMAP_FRAME_BAYES} + "/" + baz + "/" + acct2_guid}, new KvpValue{INT64_C(2)});
+
+    gnc_account_imap_begin_bayes_batch ();
+    EXPECT_EQ(t_expense_account1, gnc_account_imap_find_account_bayes(t_acc, t_list1));
+    EXPECT_EQ(t_expense_account2, gnc_account_imap_find_account_bayes(t_acc, t_list2));
+    gnc_account_imap_add_account_bayes(t_acc, t_list1, t_expense_account2);
+    gnc_account_imap_add_account_bayes(t_acc, t_list3, t_expense_account2);
+    gnc_account_imap_add_account_bayes(t_acc, t_list3, t_expense_account2);
+    // The new counts are used for matching but only written when the batch ends
+    EXPECT_EQ(t_expense_account2, gnc_account_imap_find_account_bayes(t_acc, t_list1));
+    EXPECT_EQ(t_expense_account2, gnc_account_imap_find_account_bayes(t_acc, t_list3));
+    EXPECT_EQ(nullptr, root->get_slot({std::string{IMAP_FRAME_BAYES} + "/" + pepper + "/" + acct2_guid}));
+    gnc_account_imap_end_bayes_batch ();
+
+    auto value = root->get_slot({std::string{IMAP_FRAME_BAYES} + "/" + foo + "/" + acct1_guid});
+    EXPECT_EQ(2, value->get<int64_t>());
+    value = root->get_slot({std::string{IMAP_FRAME_BAYES} + "/" + foo + "/" + acct2_guid});
+    EXPECT_EQ(1, value->get<int64_t>());
+    value = root->get_slot({std::string{IMAP_FRAME_BAYES} + "/" + bar + "/" + acct2_guid});
+    EXPECT_EQ(1, value->get<int64_t>());
+    value = root->get_slot({std::string{IMAP_FRAME_BAYES} + "/" + pepper + "/" + acct2_guid});
+    EXPECT_EQ(2, value->get<int64_t>());
+    EXPECT_EQ(t_expense_account2, gnc_account_imap_find_account_bayes(t_acc, t_list1));
+    EXPECT_EQ(t_expense_account2, gnc_account_imap_find_account_bayes(t_acc, t_list3));
+    g_free (acct1_guid);
+    g_free (acct2_guid);
+}
+
+/* An account destroyed during a batch takes its index with it. */
+TEST_F (ImapBayesTest, bayes_batch_account_destroyed)
+{
+    auto book = gnc_account_get_book (t_bank_account);
+    auto card = xaccMallocAccount (book);
+    xaccAccountSetName (card, "Card");
+    xaccAccountSetType (card, ACCT_TYPE_CREDIT);
+    gnc_account_append_child (t_asset_account1, card);
+
+    gnc_account_imap_begin_bayes_batch ();
+    gnc_account_imap_add_account_bayes (card, t_list1, t_expense_account1);
+    EXPECT_EQ (t_expense_account1, gnc_account_imap_find_account_bayes (card, t_list1));
+    gnc_account_imap_add_account_bayes (t_acc, t_list3, t_expense_account2);
+    xaccAccountBeginEdit (card);
+    xaccAccountDestroy (card);
+    gnc_account_imap_end_bayes_batch ();
+
+    auto root = qof_instance_get_slots (QOF_INSTANCE (t_acc));
+    auto acct2_guid = guid_to_string (xaccAccountGetGUID (t_expense_account2));
+    auto value = root->get_slot ({std::string{IMAP_FRAME_BAYES} + "/" + pepper + "/" + acct2_guid});
+    ASSERT_NE (nullptr, value);
+    EXPECT_EQ (1, value->get<int64_t>());
+    g_free (acct2_guid);
+}
+
+/* Looking up a token should only visit the map entries for that token,
+ * however many other tokens the account has learned. */
+TEST_F (ImapBayesTest, for_each_slot_prefix_visits_only_token_slots)
+{
+    auto root = qof_instance_get_slots(QOF_INSTANCE(t_bank_account));
+    auto acct1_guid = guid_to_string (xaccAccountGetGUID(t_expense_account1));
+    auto acct2_guid = guid_to_string (xaccAccountGetGUID(t_expense_account2));
+    root->set_path({std::string{IMAP_FRAME_BAYES} + "/" + foo + "/" + acct1_guid}, new KvpValue{INT64_C(42)});
+    root->set_path({std::string{IMAP_FRAME_BAYES} + "/" + foo + "/" + acct2_guid}, new KvpValue{INT64_C(1)});
+    root->set_path({std::string{IMAP_FRAME_BAYES} + "/" + bar + "/" + acct1_guid}, new KvpValue{INT64_C(42)});
+    for (auto i = 0; i < 10000; ++i)
+        root->set_path({std::string{IMAP_FRAME_BAYES} + "/filler" + std::to_string(i) + "/" + acct2_guid},
+                       new KvpValue{INT64_C(1)});
+
+    auto prefix = std::string{IMAP_FRAME_BAYES} + "/" + foo + "/";
+    std::vector<std::string> visited;
+    root->for_each_slot_prefix (prefix, [&visited] (const char* key, KvpValue*) {
+            visited.emplace_back (key); });
+    // The callback gets the rest of the key, in key order.
+    ASSERT_EQ (2u, visited.size());
+    EXPECT_TRUE (std::is_sorted (visited.begin(), visited.end()));
+    EXPECT_NE (visited.end(), std::find (visited.begin(), visited.end(), acct1_guid));
+    EXPECT_NE (visited.end(), std::find (visited.begin(), visited.end(), acct2_guid));
+
+    auto count = 0u;
+    root->for_each_slot_prefix (std::string{IMAP_FRAME_BAYES} + "/filler9",
+                                [] (const char*, KvpValue*, unsigned& count) { ++count; },
+                                count);
+    EXPECT_EQ (1111u, count); // filler9, 90-99, 900-999 and 9000-9999
+
+    EXPECT_EQ (t_expense_account1, gnc_account_imap_find_account_bayes (t_acc, t_list1));
+    g_free (acct1_guid);
+    g_free (acct2_guid);
+}
@@ -24,7 +24,10 @@
 
 #include "../guid.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <random>
+#include <vector>
 #include <sstream>
 #include <iomanip>
 #include <string>
@@ -90,3 +93,67 @@ TEST (GncGUID, round_trip)
     EXPECT_EQ (guid1, guid2);
 }
 
+
+TEST (GncGUID, hex_encoding)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        GncGUID guid = gnc::GUID::create_random ();
+        std::ostringstream expected;
+        for (auto byte : guid.reserved)
+            expected << std::hex << std::setw (2) << std::setfill ('0')
+                     << static_cast<int> (byte);
+        char buf[GUID_ENCODING_LENGTH + 1] = "";
+        guid_encode_hex (guid, buf);
+        EXPECT_EQ (expected.str (), buf);
+
+        GncGUID decoded;
+        EXPECT_TRUE (guid_decode_hex (buf, decoded));
+        EXPECT_EQ (guid, decoded);
+        std::transform (buf, buf + GUID_ENCODING_LENGTH, buf, ::toupper);
+        EXPECT_TRUE (guid_decode_hex (buf, decoded));
+        EXPECT_EQ (guid, decoded);
+    }
+
+    GncGUID guid = gnc::GUID::null_guid ();
+    std::string good (GUID_ENCODING_LENGTH, 'f');
+    for (int c = 1; c < 256; ++c)
+    {
+        auto bad = good;
+        bad[17] = static_cast<char> (c);
+        EXPECT_EQ (guid_decode_hex (bad.c_str (), guid), isxdigit (c) != 0)
+            << "character " << c;
+    }
+    EXPECT_FALSE (guid_decode_hex (good.substr (1).c_str (), guid));
+    EXPECT_FALSE (guid_decode_hex ((good + "0").c_str (), guid));
+
+    /* The dashed form is still accepted, just not by the fast path. */
+    auto dashed = "4b0f6e8c-1d3a-4c1e-9f2b-7a6d5c4b3a29";
+    EXPECT_FALSE (guid_decode_hex (dashed, guid));
+    EXPECT_TRUE (gnc::GUID::is_valid_guid (dashed));
+}
+
+TEST (GncGUID, hex_encoding_round_trip)
+{
+    constexpr int count = 1000;
+    std::vector<GncGUID> guids;
+    guids.reserve (count);
+    for (int i = 0; i < count; ++i)
+        guids.push_back (gnc::GUID::create_random ());
+
+    /* Encode back to back; each encoding must leave its neighbours alone. */
+    std::vector<char> text (count * GUID_ENCODING_LENGTH + 1);
+    for (int i = 0; i < count; ++i)
+        guid_encode_hex (guids[i], &text[i * GUID_ENCODING_LENGTH]);
+
+    for (int i = count - 1; i >= 0; --i)
+    {
+        /* Each decode sees a null-terminated string, as callers do. */
+        auto str = &text[i * GUID_ENCODING_LENGTH];
+        str[GUID_ENCODING_LENGTH] = '\0';
+        EXPECT_EQ (gnc::GUID {guids[i]}.to_string (), str);
+        GncGUID guid;
+        EXPECT_TRUE (guid_decode_hex (str, guid));
+        EXPECT_EQ (guids[i], guid);
+    }
+}
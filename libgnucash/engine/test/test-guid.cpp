@@ -39,6 +39,7 @@
 #include "test-engine-stuff.h"
 #include "qof.h"
 #define NENT 50123
+#define NREMOVE 5000
 
 static void test_null_guid(void)
 {
@@ -93,6 +94,50 @@ run_test (void)
     qof_session_destroy(sess);
 }
 
+/* Fill a collection with enough instances to grow its table a few times,
+ * look every one of them up, then remove every other one and check that the
+ * rest are still found. */
+static void
+run_removal_test (void)
+{
+    auto sess = get_random_session ();
+    auto book = qof_session_get_book (sess);
+    auto col = qof_book_get_collection (book, "removal");
+    auto type = CACHE_INSERT (qof_collection_get_type (col));
+    std::vector<GncGUID> guids (NREMOVE);
+    std::vector<QofInstance*> insts (NREMOVE);
+
+    for (int i = 0; i < NREMOVE; i++)
+    {
+        guid_replace (&guids[i]);
+        insts[i] = QOF_INSTANCE(g_object_new (QOF_TYPE_INSTANCE, "guid",
+                                              &guids[i], NULL));
+        insts[i]->e_type = type;
+        qof_collection_insert_entity (col, insts[i]);
+    }
+    do_test (qof_collection_count (col) == NREMOVE, "collection count");
+
+    int found = 0;
+    for (int i = 0; i < NREMOVE; i++)
+        if (qof_collection_lookup_entity (col, &guids[i]) == insts[i])
+            ++found;
+    do_test (found == NREMOVE, "all entities found");
+
+    for (int i = 0; i < NREMOVE; i += 2)
+        qof_collection_remove_entity (insts[i]);
+    found = 0;
+    for (int i = 0; i < NREMOVE; i++)
+        if (qof_collection_lookup_entity (col, &guids[i]) == (i % 2 ? insts[i] : nullptr))
+            ++found;
+    do_test (found == NREMOVE, "lookups after removal");
+    do_test (qof_collection_count (col) == NREMOVE / 2,
+             "collection count after removal");
+
+    for (auto inst : insts)
+        g_object_unref (G_OBJECT(inst));
+    qof_session_destroy (sess);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -101,6 +146,7 @@ main (int argc, char **argv)
     {
         test_null_guid();
         run_test ();
+        run_removal_test ();
         print_test_results();
     }
     qof_close();
@@ -82,6 +82,94 @@ test_lot_kvp ()
     qof_session_destroy (sess);
 }
 
+/* Creates a stock account and a cash account with their commodities,
+ * both in the book's account tree. */
+static void
+make_trading_accounts (QofBook *book, Account **stock, Account **cash,
+                       gnc_commodity **currency)
+{
+    Account *root = gnc_book_get_root_account (book);
+    gnc_commodity *acme = gnc_commodity_new (book, "Acme", "NASDAQ", "ACME", "", 1000);
+
+    *currency = gnc_commodity_new (book, "US Dollar", GNC_COMMODITY_NS_CURRENCY,
+                                   "USD", "", 100);
+    *stock = xaccMallocAccount (book);
+    *cash = xaccMallocAccount (book);
+    xaccAccountBeginEdit (*stock);
+    xaccAccountSetType (*stock, ACCT_TYPE_STOCK);
+    xaccAccountSetCommodity (*stock, acme);
+    xaccAccountCommitEdit (*stock);
+    xaccAccountBeginEdit (*cash);
+    xaccAccountSetType (*cash, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (*cash, *currency);
+    xaccAccountCommitEdit (*cash);
+    gnc_account_append_child (root, *stock);
+    gnc_account_append_child (root, *cash);
+}
+
+/* Trades shares at 10 per share on the given day, returning the split
+ * in the stock account. */
+static Split *
+add_trade (QofBook *book, Account *stock, Account *cash,
+           gnc_commodity *currency, int day, gint64 shares)
+{
+    Transaction *trans = xaccMallocTransaction (book);
+    Split *stock_split = xaccMallocSplit (book);
+    Split *cash_split = xaccMallocSplit (book);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, currency);
+    xaccTransSetDatePostedSecsNormalized (trans, gnc_dmy2time64 (1, 1, 2000) + day * 86400);
+
+    xaccSplitSetParent (stock_split, trans);
+    xaccSplitSetAccount (stock_split, stock);
+    xaccSplitSetAmount (stock_split, gnc_numeric_create (shares, 1));
+    xaccSplitSetValue (stock_split, gnc_numeric_create (shares * 10, 1));
+
+    xaccSplitSetParent (cash_split, trans);
+    xaccSplitSetAccount (cash_split, cash);
+    xaccSplitSetAmount (cash_split, gnc_numeric_create (-shares * 10, 1));
+    xaccSplitSetValue (cash_split, gnc_numeric_create (-shares * 10, 1));
+    xaccTransCommitEdit (trans);
+
+    return stock_split;
+}
+
+static void
+test_lot_balance_cache ()
+{
+    QofBook *book = qof_book_new ();
+    Account *stock, *cash;
+    gnc_commodity *currency;
+
+    make_trading_accounts (book, &stock, &cash, &currency);
+
+    GNCLot *lot = gnc_lot_new (book);
+    Split *buy = add_trade (book, stock, cash, currency, 0, 10);
+    Split *sell = add_trade (book, stock, cash, currency, 1, -4);
+
+    gnc_lot_add_split (lot, buy);
+    do_test (gnc_numeric_equal (gnc_lot_get_balance (lot), gnc_numeric_create (10, 1)),
+             "lot balance of one split");
+
+    gnc_lot_add_split (lot, sell);
+    do_test (gnc_numeric_equal (gnc_lot_get_balance (lot), gnc_numeric_create (6, 1)),
+             "lot balance after adding a split");
+    do_test (!gnc_lot_is_closed (lot), "lot open after adding a split");
+
+    xaccSplitSetAmount (sell, gnc_numeric_create (-10, 1));
+    do_test (gnc_numeric_zero_p (gnc_lot_get_balance (lot)),
+             "lot balance after changing a split's amount");
+    do_test (gnc_lot_is_closed (lot), "lot closed after changing a split's amount");
+
+    gnc_lot_remove_split (lot, sell);
+    do_test (gnc_numeric_equal (gnc_lot_get_balance (lot), gnc_numeric_create (10, 1)),
+             "lot balance after removing a split");
+    do_test (!gnc_lot_is_closed (lot), "lot open after removing a split");
+
+    qof_book_destroy (book);
+}
+
 static void
 run_test (void)
 {
@@ -136,6 +224,7 @@ main (int argc, char **argv)
     }
 
     test_lot_kvp ();
+    test_lot_balance_cache ();
 
     /* 'erase' the recurring tag line with dummy spaces. */
     fprintf(stdout, "Lots: Test series complete.\n");
@@ -26,6 +26,9 @@
 #include "qof.h"
 #include "cashobjects.h"
 #include "Transaction.h"
+#include "Account.h"
+#include "Query.h"
+#include "qofquery.hpp"
 #include "TransLog.h"
 #include "gnc-engine.h"
 #include "test-engine-stuff.h"
@@ -64,6 +67,156 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* A query for an account's splits in a date range is answered from the
+ * account's sorted splits; check it against the splits themselves. */
+static void
+test_account_query (Account *acc, gpointer data)
+{
+    QofBook *book = QOF_BOOK(data);
+    GList *splits, *list, *node;
+    guint expected = 0;
+    Split *latest = NULL;
+    time64 start, end;
+
+    splits = xaccAccountGetSplitList (acc);
+    if (!splits)
+        return;
+    start = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT(splits->data)));
+    end = xaccTransGetDate (xaccSplitGetParent
+                            (GNC_SPLIT(g_list_nth_data (splits, g_list_length (splits) / 2))));
+    for (node = splits; node; node = node->next)
+    {
+        time64 date = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT(node->data)));
+        if (date >= start && date <= end)
+        {
+            ++expected;
+            latest = GNC_SPLIT(node->data);
+        }
+    }
+    g_list_free (splits);
+
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (q, TRUE, start, TRUE, end, QOF_QUERY_AND);
+    list = qof_query_run (q);
+    if (g_list_length (list) != expected)
+    {
+        failure_args ("account query", __FILE__, __LINE__,
+                      "number of matching splits %d not %d",
+                      g_list_length (list), expected);
+        qof_query_destroy (q);
+        return;
+    }
+    for (node = list; node; node = node->next)
+        if (xaccSplitGetAccount (GNC_SPLIT(node->data)) != acc)
+        {
+            failure ("account query found another account's split");
+            qof_query_destroy (q);
+            return;
+        }
+
+    auto objects = qof_query_run_vector (q);
+    node = list;
+    for (auto object : objects)
+    {
+        if (!node || node->data != object)
+            break;
+        node = node->next;
+    }
+    if (objects.size() != expected || node)
+    {
+        failure ("vector results differ from the list");
+        qof_query_destroy (q);
+        return;
+    }
+
+    qof_query_set_max_results (q, 1);
+    list = qof_query_run (q);
+    if (g_list_length (list) != 1 || list->data != latest)
+        failure ("limited account query didn't find the latest split");
+    else
+        success ("account query found the right splits");
+    qof_query_destroy (q);
+}
+
+/* A split moved to another account in a still open transaction only
+ * joins that account's splits on commit; the query must find it anyway. */
+static void
+test_open_trans_query (QofBook *book, Account *root)
+{
+    auto from = gnc_account_nth_child (root, 0);
+    auto to = gnc_account_nth_child (root, 1);
+    auto splits = from ? xaccAccountGetSplitList (from) : nullptr;
+    if (!to || !splits)
+    {
+        g_list_free (splits);
+        return;
+    }
+    auto split = GNC_SPLIT(splits->data);
+    auto trans = xaccSplitGetParent (split);
+    g_list_free (splits);
+
+    xaccTransBeginEdit (trans);
+    xaccSplitSetAccount (split, to);
+
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, to, QOF_QUERY_AND);
+    auto list = qof_query_run (q);
+    if (!g_list_find (list, split))
+        failure ("account query missed a split moved in an open transaction");
+    else
+        success ("account query found a split moved in an open transaction");
+    qof_query_destroy (q);
+
+    xaccTransRollbackEdit (trans);
+}
+
+/* Run a query with every object tested on this thread, then with them
+ * split between threads; the results must be the same. */
+static void
+check_parallel_query (QofQuery *q, const char *what)
+{
+    auto serial = qof_query_run_vector (q);
+    auto old_min = qof_query_set_parallel_min_objects (0);
+    auto parallel = qof_query_run_vector (q);
+    qof_query_set_parallel_min_objects (old_min);
+
+    if (parallel != serial)
+        failure_args ("parallel query", __FILE__, __LINE__,
+                      "%s: parallel results differ from serial", what);
+    else
+        success ("parallel query matches serial");
+}
+
+static void
+test_parallel_query (QofBook *book, Account *root)
+{
+    auto acc = gnc_account_nth_child (root, 0);
+    auto splits = acc ? xaccAccountGetSplitList (acc) : nullptr;
+    time64 start = 0, end = gnc_time (nullptr);
+    if (splits)
+    {
+        start = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT(splits->data)));
+        end = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT(g_list_last (splits)->data)));
+    }
+    g_list_free (splits);
+
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDateMatchTT (q, TRUE, start, TRUE, end, QOF_QUERY_AND);
+    xaccQueryAddClearedMatch (q, static_cast<cleared_match_t>(CLEARED_NO | CLEARED_CLEARED),
+                              QOF_QUERY_OR);
+    check_parallel_query (q, "date or cleared");
+
+    /* The closing transaction getter isn't thread safe, so this one stays
+     * on this thread; it must still match. */
+    xaccQueryAddClosingTransMatch (q, FALSE, QOF_QUERY_AND);
+    check_parallel_query (q, "not closing");
+    qof_query_destroy (q);
+}
+
 static void
 run_test (void)
 {
@@ -78,6 +231,9 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    gnc_account_foreach_descendant (root, test_account_query, book);
+    test_parallel_query (book, root);
+    test_open_trans_query (book, root);
 
     qof_session_destroy (session);
 }
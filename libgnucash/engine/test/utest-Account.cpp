@@ -20,6 +20,8 @@
  * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
  ********************************************************************/
 #include <cstddef>
+#include <algorithm>
+#include <vector>
 #include <glib.h>
 
 #include <config.h>
@@ -31,6 +33,7 @@
 #include "gnc-glib-utils.h"
 #include "../Account.h"
 #include "../AccountP.hpp"
+#include "../Account.hpp"
 #include "../Split.h"
 #include "../Transaction.h"
 #include "../gnc-lot.h"
@@ -1630,6 +1633,108 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert_true (!priv->balance_dirty);
 }
 
+static void
+check_running_balances (AccountPrivate *priv)
+{
+    gnc_numeric bal = priv->starting_balance;
+    gnc_numeric clr_bal = priv->starting_cleared_balance;
+    gnc_numeric rec_bal = priv->starting_reconciled_balance;
+    for (auto split : priv->splits)
+    {
+        bal = gnc_numeric_add_fixed (bal, split->amount);
+        if (split->reconciled != NREC)
+            clr_bal = gnc_numeric_add_fixed (clr_bal, split->amount);
+        if (split->reconciled == YREC || split->reconciled == FREC)
+            rec_bal = gnc_numeric_add_fixed (rec_bal, split->amount);
+        g_assert_true (gnc_numeric_eq (split->balance, bal));
+        g_assert_true (gnc_numeric_eq (split->cleared_balance, clr_bal));
+        g_assert_true (gnc_numeric_eq (split->reconciled_balance, rec_bal));
+    }
+    g_assert_true (gnc_numeric_eq (priv->balance, bal));
+    g_assert_true (gnc_numeric_eq (priv->cleared_balance, clr_bal));
+    g_assert_true (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
+}
+
+static void
+test_xaccAccountRecomputeBalance_incremental (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    auto book = gnc_account_get_book (fixture->acct);
+    auto root = gnc_account_get_root (fixture->acct);
+    SplitParms parms = {"salt_meh", "meh", CREC, {1000, 100}, {0, 1}, 0};
+
+    priv->balance_dirty = TRUE;
+    xaccAccountRecomputeBalance (fixture->acct);
+    check_running_balances (priv);
+    auto last = priv->splits.back ();
+
+    /* A back-dated split only invalidates the splits from its own
+     * position onward. */
+    auto txn = xaccMallocTransaction (book);
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecsNormalized (txn, gnc_time (NULL) - 8 * 24 * 3600);
+    auto split = insert_split (root, txn, &parms);
+    qof_commit_edit (QOF_INSTANCE (txn));
+    g_assert_true (priv->splits[1] == split);
+    g_assert_true (priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, ==, 1);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert_true (!priv->balance_dirty);
+    check_running_balances (priv);
+
+    /* Changing the last split's amount only touches the last split. */
+    xaccTransBeginEdit (xaccSplitGetParent (last));
+    xaccSplitSetAmount (last, gnc_numeric_create (2000, 100));
+    g_assert_true (priv->balance_dirty_splits.count (last));
+    g_assert_cmpuint (priv->balance_dirty_from, ==, priv->splits.size ());
+    qof_commit_edit (QOF_INSTANCE (xaccSplitGetParent (last)));
+    xaccAccountRecomputeBalance (fixture->acct);
+    check_running_balances (priv);
+
+    /* Moving the new split to the end of the ledger keeps the vector
+     * sorted and the balances right. */
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecsNormalized (txn, gnc_time (NULL) + 8 * 24 * 3600);
+    qof_commit_edit (QOF_INSTANCE (txn));
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert_true (priv->splits.back () == split);
+    check_running_balances (priv);
+
+    /* Removing it restores the original running balances. */
+    gnc_account_remove_split (fixture->acct, split);
+    g_assert_true (!priv->balance_dirty);
+    check_running_balances (priv);
+
+    /* Re-dating many transactions, more than are moved one at a time,
+     * keeps the vector sorted and the balances right. */
+    std::vector<Transaction*> txns;
+    for (int i = 0; i < 20; ++i)
+    {
+        auto t = xaccMallocTransaction (book);
+        xaccTransBeginEdit (t);
+        xaccTransSetDatePostedSecsNormalized (t, gnc_time (NULL) - (i + 20) * 24 * 3600);
+        insert_split (root, t, &parms);
+        qof_commit_edit (QOF_INSTANCE (t));
+        txns.push_back (t);
+    }
+    xaccAccountRecomputeBalance (fixture->acct);
+    xaccAccountBeginEdit (fixture->acct);
+    for (size_t i = 0; i < txns.size (); ++i)
+    {
+        xaccTransBeginEdit (txns[i]);
+        xaccTransSetDatePostedSecsNormalized (txns[i], gnc_time (NULL) - (40 - i) * 24 * 3600);
+        xaccTransCommitEdit (txns[i]);
+    }
+    xaccAccountCommitEdit (fixture->acct);
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert_true (std::is_sorted (priv->splits.begin (), priv->splits.end (),
+                                   [](auto a, auto b) { return xaccSplitOrder (a, b) < 0; }));
+    g_assert_true (priv->unsorted_splits.empty ());
+    check_running_balances (priv);
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -2257,6 +2362,57 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+
+/* gnc_account_get_balances_as_of_dates */
+static void
+test_gnc_account_get_balances_as_of_dates (Fixture *fixture, gconstpointer pData)
+{
+    auto sdata = static_cast<SetupData*>(const_cast<void*>(pData));
+    auto t_arr = (TxnParms*)sdata->txns;
+    auto splits{xaccAccountGetSplits (fixture->acct)};
+    /* One date before the first split, then one just after each split. */
+    std::vector<time64> dates{xaccTransGetDate (xaccSplitGetParent (splits.front())) - 1};
+    for (auto split : splits)
+        dates.push_back (xaccTransGetDate (xaccSplitGetParent (split)) + 1);
+
+    auto balances{gnc_account_get_balances_as_of_dates (fixture->acct, dates)};
+    g_assert_cmpuint (balances.size(), ==, dates.size());
+    for (size_t i = 0; i < dates.size(); ++i)
+    {
+        auto bal = gnc_numeric_zero ();
+        for (size_t ind = 0; ind < i; ind++)
+            bal = gnc_numeric_add_fixed (bal, t_arr[ind].splits[1].amount);
+        g_assert_true (gnc_numeric_equal (balances[i], bal));
+        g_assert_true (gnc_numeric_equal (balances[i],
+                                          xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                                                         dates[i])));
+    }
+
+    auto reconciled{gnc_account_get_balances_as_of_dates (fixture->acct, dates,
+                                                          AccountBalanceKind::RECONCILED)};
+    for (size_t i = 0; i < dates.size(); ++i)
+        g_assert_true (gnc_numeric_equal (reconciled[i],
+                                          xaccAccountGetReconciledBalanceAsOfDate (fixture->acct,
+                                                                                   dates[i])));
+
+    /* A partial load seeds the starting balances with the splits it left
+     * out; every balance includes them, even before the first split. */
+    auto start = gnc_numeric_create (1000, 100);
+    gnc_account_set_start_balance (fixture->acct, start);
+    gnc_account_set_start_reconciled_balance (fixture->acct, start);
+    auto seeded{gnc_account_get_balances_as_of_dates (fixture->acct, dates)};
+    for (size_t i = 0; i < dates.size(); ++i)
+    {
+        auto bal = gnc_numeric_add_fixed (balances[i], start);
+        g_assert_true (gnc_numeric_equal (seeded[i], bal));
+        g_assert_true (gnc_numeric_equal (seeded[i],
+                                          xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                                                         dates[i])));
+    }
+    g_assert_true (gnc_numeric_equal (xaccAccountGetReconciledBalanceAsOfDate (fixture->acct,
+                                                                               dates.front()),
+                                      start));
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -2866,6 +3022,7 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance incremental", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance_incremental,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2885,6 +3042,7 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "gnc_account_get_balances_as_of_dates", Fixture, &some_data, setup, test_gnc_account_get_balances_as_of_dates,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
@@ -115,6 +115,7 @@ test_gnc_set_budget_recurrence()
     const Recurrence* r;
     GDate period_start;
     GDate period_end;
+    time64 starts[12], ends[12], starts_only[12];
     int i;
     typedef struct
     {
@@ -139,8 +140,14 @@ test_gnc_set_budget_recurrence()
     g_assert_cmpint(r->mult, ==, 1);
     g_assert_cmpint(r->wadj, ==, WEEKEND_ADJ_NONE);
 
+    gnc_budget_get_period_dates(budget, starts, ends);
+    gnc_budget_get_period_dates(budget, starts_only, NULL);
     for (i = 0; i < 12; ++i)
     {
+        g_assert_cmpint(starts_only[i], ==, starts[i]);
+        g_assert_cmpint(starts[i], ==, gnc_budget_get_period_start_date(budget, i));
+        g_assert_cmpint(ends[i], ==, gnc_budget_get_period_end_date(budget, i));
+
         period_start = time64_to_gdate(gnc_budget_get_period_start_date(budget, i));
         period_end = time64_to_gdate(gnc_budget_get_period_end_date(budget, i));
 
@@ -25,6 +25,7 @@
 #include <qof.h>
 #include <unittest-support.h>
 #include "../gncInvoice.h"
+#include "../gncOwnerP.h"
 #include "../Transaction.h"
 
 static const gchar *suitename = "/engine/gncInvoice";
@@ -384,6 +385,215 @@ test_xaccTransGetTxnTypeLink (Fixture *fixture, gconstpointer pData)
 }
 
 
+static void
+test_owner_find_open_lots (Fixture *fixture, gconstpointer pData)
+{
+    GNCLot *lot = gncInvoiceGetPostedLot (fixture->invoice);
+    GList *lots = gncOwnerFindOpenLots (&fixture->owner, NULL, NULL);
+    GList *acct_lots = xaccAccountFindOpenLots (fixture->account2, gncOwnerLotMatchOwnerFunc,
+                                                &fixture->owner, NULL);
+
+    g_assert_cmpint (g_list_length (lots), ==, 1);
+    g_assert_true (lots->data == lot);
+    g_assert_cmpint (g_list_length (acct_lots), ==, 1);
+    g_assert_true (acct_lots->data == lot);
+    g_list_free (lots);
+    g_list_free (acct_lots);
+
+    lots = gncOwnerFindOpenLots (&fixture->owner, fixture->account, NULL);
+    g_assert_null (lots);
+}
+
+static void
+test_owner_find_open_lots_closed (Fixture *fixture, gconstpointer pData)
+{
+    /* The invoice and credit note cancel each other out */
+    g_assert_null (gncOwnerFindOpenLots (&fixture->owner, NULL, NULL));
+}
+
+/* A vendor with many bills and some credit notes, followed in the list
+ * of lots by a few payments that don't cover all of them. */
+typedef struct
+{
+    QofBook *book;
+    gnc_commodity *commodity;
+    GncVendor *vendor;
+    GncOwner owner;
+    GList *lots;
+} ApplyScenario;
+
+static GNCLot *
+apply_scenario_post_bill (ApplyScenario *sc, Account *expense, Account *payable,
+                          gnc_numeric amount, gboolean is_cn, time64 date)
+{
+    GncInvoice *bill = gncInvoiceCreate (sc->book);
+    GncEntry *entry = gncEntryCreate (sc->book);
+
+    gncInvoiceSetCurrency (bill, sc->commodity);
+    gncInvoiceSetOwner (bill, &sc->owner);
+    gncInvoiceSetIsCreditNote (bill, is_cn);
+
+    gncEntrySetDate (entry, date);
+    gncEntrySetDateEntered (entry, date);
+    gncEntrySetDescription (entry, "Test description");
+    gncEntrySetDocQuantity (entry, gnc_numeric_create (1, 1), is_cn);
+    gncEntrySetBillPrice (entry, amount);
+    gncEntrySetBillAccount (entry, expense);
+    gncBillAddEntry (bill, entry);
+
+    gncInvoicePostToAccount (bill, payable, date, date, "memo", TRUE, FALSE);
+    return gncInvoiceGetPostedLot (bill);
+}
+
+static void
+apply_scenario_setup (ApplyScenario *sc)
+{
+    time64 date = gnc_dmy2time64 (1, 1, 2020);
+    Account *expense, *payable, *bank;
+    GList *docs = NULL;
+    gnc_numeric bill_bal;
+    int i;
+
+    sc->book = qof_book_new ();
+    sc->commodity = gnc_commodity_new (sc->book, "foo", "bar", "xy", "xy", 100);
+    sc->lots = NULL;
+
+    expense = xaccMallocAccount (sc->book);
+    payable = xaccMallocAccount (sc->book);
+    bank = xaccMallocAccount (sc->book);
+    xaccAccountSetCommodity (expense, sc->commodity);
+    xaccAccountSetCommodity (payable, sc->commodity);
+    xaccAccountSetCommodity (bank, sc->commodity);
+    xaccAccountSetType (expense, ACCT_TYPE_EXPENSE);
+    xaccAccountSetType (payable, ACCT_TYPE_PAYABLE);
+    xaccAccountSetType (bank, ACCT_TYPE_BANK);
+
+    sc->vendor = gncVendorCreate (sc->book);
+    gncOwnerInitVendor (&sc->owner, sc->vendor);
+
+    /* Every fifth document is a credit note */
+    for (i = 0; i < 60; i++)
+    {
+        gnc_numeric amount = gnc_numeric_create (1000 * (i % 7 + 1) + 37 * i, 100);
+        docs = g_list_prepend (docs, apply_scenario_post_bill (sc, expense, payable, amount,
+                                                               i % 5 == 4, date + i * 86400));
+    }
+    docs = g_list_reverse (docs);
+
+    /* Payments must have the opposite sign of the bills */
+    bill_bal = gnc_lot_get_balance (docs->data);
+    for (i = 0; i < 3; i++)
+    {
+        gnc_numeric amount = gnc_numeric_create (25000 + 10000 * i, 100);
+        if (gnc_numeric_negative_p (bill_bal))
+            amount = gnc_numeric_neg (amount);
+        sc->lots = g_list_append (sc->lots,
+                                  gncOwnerCreatePaymentLotSecs (&sc->owner, NULL, payable, bank,
+                                                                amount, gnc_numeric_create (1, 1),
+                                                                date + i * 20 * 86400, "memo", "num"));
+    }
+    sc->lots = g_list_concat (sc->lots, docs);
+}
+
+static void
+apply_scenario_teardown (ApplyScenario *sc)
+{
+    g_list_free (sc->lots);
+    gnc_commodity_destroy (sc->commodity);
+    qof_book_destroy (sc->book);
+}
+
+/* gncOwnerAutoApplyPaymentsWithLots as it was before it learned to
+ * only look at lots that can offset each other: every open lot is
+ * compared with every open lot following it. */
+static void
+reference_auto_apply_payments (const GncOwner *owner, GList *lots)
+{
+    GList *left_iter;
+
+    for (left_iter = lots; left_iter; left_iter = left_iter->next)
+    {
+        GNCLot *left_lot = left_iter->data;
+        gnc_numeric left_lot_bal;
+        Account *acct;
+        GList *right_iter;
+
+        if (!left_lot)
+            continue;
+        if (gnc_lot_count_splits (left_lot) == 0)
+        {
+            gnc_lot_destroy (left_lot);
+            left_iter->data = NULL;
+            continue;
+        }
+        if (gnc_lot_is_closed (left_lot))
+            continue;
+
+        acct = gnc_lot_get_account (left_lot);
+        xaccAccountBeginEdit (acct);
+        left_lot_bal = gnc_lot_get_balance (left_lot);
+
+        for (right_iter = left_iter->next; right_iter; right_iter = right_iter->next)
+        {
+            GNCLot *right_lot = right_iter->data;
+            gnc_numeric right_lot_bal;
+
+            if (!right_lot)
+                continue;
+            if (gnc_lot_count_splits (right_lot) == 0)
+            {
+                gnc_lot_destroy (right_lot);
+                right_iter->data = NULL;
+                continue;
+            }
+            if (gnc_lot_is_closed (right_lot))
+                continue;
+            if (acct != gnc_lot_get_account (right_lot))
+                continue;
+
+            right_lot_bal = gnc_lot_get_balance (right_lot);
+            if (gnc_numeric_positive_p (left_lot_bal) == gnc_numeric_positive_p (right_lot_bal))
+                continue;
+
+            gncOwnerOffsetLotPair (left_lot, left_lot_bal, right_lot, right_lot_bal, owner);
+        }
+        xaccAccountCommitEdit (acct);
+    }
+}
+
+static void
+test_auto_apply_payments (void)
+{
+    ApplyScenario reference, scenario;
+    GList *ref_node, *node;
+    guint closed = 0;
+
+    apply_scenario_setup (&reference);
+    apply_scenario_setup (&scenario);
+
+    reference_auto_apply_payments (&reference.owner, reference.lots);
+    gncOwnerAutoApplyPaymentsWithLots (&scenario.owner, scenario.lots);
+
+    g_assert_cmpint (g_list_length (scenario.lots), ==, g_list_length (reference.lots));
+    for (ref_node = reference.lots, node = scenario.lots; node;
+         ref_node = ref_node->next, node = node->next)
+    {
+        g_assert_true ((ref_node->data == NULL) == (node->data == NULL));
+        if (!node->data)
+            continue;
+
+        g_assert_true (gnc_numeric_equal (gnc_lot_get_balance (node->data),
+                                          gnc_lot_get_balance (ref_node->data)));
+        if (gnc_lot_is_closed (node->data))
+            closed++;
+    }
+    /* The payments and credit notes must have settled some bills */
+    g_assert_cmpint (closed, >, 0);
+
+    apply_scenario_teardown (&reference);
+    apply_scenario_teardown (&scenario);
+}
+
 void
 test_suite_gncInvoice ( void )
 {
@@ -402,4 +612,10 @@ test_suite_gncInvoice ( void )
     /* test txn type heuristics */
     GNC_TEST_ADD( suitename, "tests txntype I & P", Fixture, &pData, setup_with_invoice_and_payment, test_xaccTransGetTxnTypeInvoice, teardown_with_invoice);
     GNC_TEST_ADD( suitename, "tests txntype L", Fixture, &pData, setup_with_invoice_and_CN, test_xaccTransGetTxnTypeLink, teardown_with_invoice);
+
+    /* test the owner lot index */
+    GNC_TEST_ADD( suitename, "owner open lots", Fixture, &pData, setup_with_invoice, test_owner_find_open_lots, teardown_with_invoice);
+    GNC_TEST_ADD( suitename, "owner open lots - closed", Fixture, &pData, setup_with_invoice_and_CN, test_owner_find_open_lots_closed, teardown_with_invoice);
+
+    GNC_TEST_ADD_FUNC( suitename, "auto apply payments", test_auto_apply_payments);
 }
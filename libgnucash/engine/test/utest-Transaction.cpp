@@ -1807,6 +1807,43 @@ test_xaccTransGetTxnType (Fixture *fixture, gconstpointer pData)
     g_assert_cmpint (TXN_TYPE_NONE, ==, xaccTransGetTxnType(txn));
 }
 
+static void
+test_xaccTransGetIsClosingTxn (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = fixture->txn;
+    GValue v = G_VALUE_INIT;
+    g_value_init (&v, G_TYPE_INT64);
+    g_value_set_int64 (&v, 1);
+
+    g_assert_true (!xaccTransGetIsClosingTxn (txn));
+    xaccTransSetIsClosingTxn (txn, TRUE);
+    g_assert_true (xaccTransGetIsClosingTxn (txn));
+    g_assert_cmpint (txn->is_closing_txn, ==, 1);
+
+    /* The flag is answered from the cache, not from the KVP frame, until
+     * the next commit. */
+    qof_instance_set_kvp (QOF_INSTANCE (txn), nullptr, 1, "book_closing");
+    g_assert_true (xaccTransGetIsClosingTxn (txn));
+    xaccTransBeginEdit (txn);
+    xaccTransCommitEdit (txn);
+    g_assert_cmpint (txn->is_closing_txn, ==, TXN_CLOSING_UNCACHED);
+    g_assert_true (!xaccTransGetIsClosingTxn (txn));
+
+    /* Slots loaded by a backend inside an edit are picked up at commit. */
+    xaccTransBeginEdit (txn);
+    qof_instance_set_kvp (QOF_INSTANCE (txn), &v, 1, "book_closing");
+    xaccTransCommitEdit (txn);
+    g_assert_true (xaccTransGetIsClosingTxn (txn));
+
+    /* And a rollback restores the original slot. */
+    xaccTransBeginEdit (txn);
+    xaccTransSetIsClosingTxn (txn, FALSE);
+    g_assert_true (!xaccTransGetIsClosingTxn (txn));
+    xaccTransRollbackEdit (txn);
+    g_assert_true (xaccTransGetIsClosingTxn (txn));
+    g_value_unset (&v);
+}
+
 /* xaccTransGetReadOnly C: 7 in 5  Local: 1:0:0
  * xaccTransIsReadonlyByPostedDate C: 2 in 2  Local: 0:0:0
  * xaccTransHasReconciledSplitsByAccount Local: 1:0:0
@@ -2049,6 +2086,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit - Backend Errors", Fixture, NULL, setup, test_xaccTransRollbackEdit_BackendErrors, teardown);
     GNC_TEST_ADD (suitename, "xaccTransOrder_num_action", Fixture, NULL, setup, test_xaccTransOrder_num_action, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetTxnType", Fixture, NULL, setup, test_xaccTransGetTxnType, teardown);
+    GNC_TEST_ADD (suitename, "xaccTransGetIsClosingTxn", Fixture, NULL, setup, test_xaccTransGetIsClosingTxn, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetreadOnly", Fixture, NULL, setup, test_xaccTransGetReadOnly, teardown);
     GNC_TEST_ADD (suitename, "xaccTransSetDocLink", Fixture, NULL, setup, test_xaccTransSetDocLink, teardown);
     GNC_TEST_ADD (suitename, "xaccTransVoid", Fixture, NULL, setup, test_xaccTransVoid, teardown);
@@ -791,6 +791,101 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)// C: 7 in 7 SCM: 1  Local: 0:
 test_gnc_pricedb_add_price (Fixture *fixture, gconstpointer pData)
 {
 }*/
+/* gnc_pricedb_add_prices
+guint
+gnc_pricedb_add_prices(GNCPriceDB *db, PriceList *prices)
+*/
+typedef struct
+{
+    guint price_events;
+    guint pricedb_modifies;
+} PriceEventCounts;
+
+static void
+count_price_events (QofInstance *ent, QofEventId event_type,
+                    gpointer handler_data, gpointer event_data)
+{
+    PriceEventCounts *counts = handler_data;
+    if (GNC_IS_PRICE (ent))
+        ++counts->price_events;
+    else if (GNC_IS_PRICEDB (ent) && event_type == QOF_EVENT_MODIFY)
+        ++counts->pricedb_modifies;
+}
+
+static void
+test_gnc_pricedb_add_prices (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    Commodities *c = fixture->com;
+    PriceList *prices = NULL, *usd_aud;
+    GNCPrice *price;
+    guint added;
+    PriceEventCounts events = {0, 0};
+    gint handler_id;
+
+    /* The FQ price already in the DB is better, so this is dropped. */
+    prices = g_list_prepend (prices, construct_price(book, c->usd, c->aud,
+                                                     gnc_dmy2time64(11, 4, 2009),
+                                                     PRICE_SOURCE_USER_PRICE,
+                                                     gnc_numeric_create(2, 1)));
+    /* This replaces the user price already in the DB. */
+    prices = g_list_prepend (prices, construct_price(book, c->usd, c->aud,
+                                                     gnc_dmy2time64(12, 4, 2009),
+                                                     PRICE_SOURCE_FQ,
+                                                     gnc_numeric_create(3, 1)));
+    /* Only the last of the FQ prices for the day is kept. */
+    prices = g_list_prepend (prices, construct_price(book, c->usd, c->aud,
+                                                     gnc_dmy2time64(13, 4, 2009),
+                                                     PRICE_SOURCE_USER_PRICE,
+                                                     gnc_numeric_create(4, 1)));
+    prices = g_list_prepend (prices, construct_price(book, c->usd, c->aud,
+                                                     gnc_dmy2time64(13, 4, 2009),
+                                                     PRICE_SOURCE_FQ,
+                                                     gnc_numeric_create(5, 1)));
+    prices = g_list_prepend (prices, construct_price(book, c->usd, c->aud,
+                                                     gnc_dmy2time64(13, 4, 2009),
+                                                     PRICE_SOURCE_FQ,
+                                                     gnc_numeric_create(6, 1)));
+    prices = g_list_prepend (prices, construct_price(book, c->bgn, c->eur,
+                                                     gnc_dmy2time64(13, 4, 2009),
+                                                     PRICE_SOURCE_FQ,
+                                                     gnc_numeric_create(7, 1)));
+    prices = g_list_reverse (prices);
+
+    /* The whole batch is announced by one event for the pricedb. */
+    handler_id = qof_event_register_handler (count_price_events, &events);
+    added = gnc_pricedb_add_prices (db, prices);
+    qof_event_unregister_handler (handler_id);
+    g_assert_cmpint (added, ==, 3);
+    g_assert_cmpint (events.price_events, ==, 0);
+    g_assert_cmpint (events.pricedb_modifies, ==, 1);
+    gnc_price_list_destroy (prices);
+
+    price = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud,
+                                        gnc_dmy2time64(11, 4, 2009));
+    g_assert_true (gnc_numeric_equal (gnc_price_get_value (price),
+                                      gnc_numeric_create(131190, 10000)));
+    gnc_price_unref (price);
+    price = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud,
+                                        gnc_dmy2time64(12, 4, 2009));
+    g_assert_true (gnc_numeric_equal (gnc_price_get_value (price),
+                                      gnc_numeric_create(3, 1)));
+    gnc_price_unref (price);
+    price = gnc_pricedb_lookup_day_t64 (db, c->usd, c->aud,
+                                        gnc_dmy2time64(13, 4, 2009));
+    g_assert_true (gnc_numeric_equal (gnc_price_get_value (price),
+                                      gnc_numeric_create(6, 1)));
+    gnc_price_unref (price);
+    price = gnc_pricedb_lookup_latest (db, c->bgn, c->eur);
+    g_assert_true (gnc_numeric_equal (gnc_price_get_value (price),
+                                      gnc_numeric_create(7, 1)));
+    gnc_price_unref (price);
+
+    usd_aud = gnc_pricedb_get_prices (db, c->usd, c->aud);
+    g_assert_cmpint (g_list_length (usd_aud), ==, 6);
+    gnc_price_list_destroy (usd_aud);
+}
 /* remove_price
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)// Local: 4:0:0
@@ -1489,6 +1584,63 @@ test_gnc_pricedb_get_nearest_before_price (PriceDBFixture *fixture, gconstpointe
     g_assert_cmpint(result.denom, ==, 1331);
 }
 
+static void
+test_gnc_pricedb_get_nearest_price_multi_hop (PriceDBFixture *fixture, gconstpointer pData)
+{
+    time64 t = gnc_dmy2time64(15, 8, 2011);
+    GNCPrice *price;
+    gnc_numeric result;
+
+    /* There's no direct or single-currency path from AMZN to EUR, only
+     * AMZN->USD->GBP->EUR, so without multi-hop conversions there's no
+     * rate. */
+    result = gnc_pricedb_get_nearest_price (fixture->pricedb,
+                                            fixture->com->amzn,
+                                            fixture->com->eur, t);
+    g_assert_true (gnc_numeric_zero_p (result));
+
+    /* The cached zero doesn't hide the chain once they're enabled. */
+    gnc_pricedb_set_multi_hop_conversions (fixture->pricedb, TRUE);
+    result = gnc_pricedb_get_nearest_price (fixture->pricedb,
+                                            fixture->com->amzn,
+                                            fixture->com->eur, t);
+    g_assert_cmpint(result.num, ==, 210075569);
+    g_assert_cmpint(result.denom, ==, 1347025);
+
+    /* The second lookup comes from the cache. */
+    result = gnc_pricedb_get_nearest_price (fixture->pricedb,
+                                            fixture->com->amzn,
+                                            fixture->com->eur, t);
+    g_assert_cmpint(result.num, ==, 210075569);
+    g_assert_cmpint(result.denom, ==, 1347025);
+
+    /* Changing a price on the path must invalidate it. */
+    price = gnc_pricedb_lookup_day_t64 (fixture->pricedb, fixture->com->gbp,
+                                        fixture->com->eur,
+                                        gnc_dmy2time64(20, 7, 2011));
+    g_assert_nonnull (price);
+    gnc_price_set_value (price, gnc_numeric_create (2, 1));
+    gnc_price_unref (price);
+    result = gnc_pricedb_get_nearest_price (fixture->pricedb,
+                                            fixture->com->amzn,
+                                            fixture->com->eur, t);
+    g_assert_cmpint(result.num, ==, 44504000);
+    g_assert_cmpint(result.denom, ==, 161643);
+
+    /* And nothing connects BGN to anything. */
+    result = gnc_pricedb_get_nearest_price (fixture->pricedb,
+                                            fixture->com->amzn,
+                                            fixture->com->bgn, t);
+    g_assert_true (gnc_numeric_zero_p (result));
+
+    /* Turning them off again gives back the cached zero. */
+    gnc_pricedb_set_multi_hop_conversions (fixture->pricedb, FALSE);
+    result = gnc_pricedb_get_nearest_price (fixture->pricedb,
+                                            fixture->com->amzn,
+                                            fixture->com->eur, t);
+    g_assert_true (gnc_numeric_zero_p (result));
+}
+
 /* gnc_pricedb_foreach_price
 gboolean
 gnc_pricedb_foreach_price(GNCPriceDB *db,// C: 2 in 2  Local: 6:0:0
@@ -1744,6 +1896,7 @@ GNC_TEST_ADD (suitename, "gnc price list equal", PriceDBFixture, NULL, setup, te
 // GNC_TEST_ADD (suitename, "insert or replace price", Fixture, NULL, setup, test_insert_or_replace_price, teardown);
 // GNC_TEST_ADD (suitename, "add price", Fixture, NULL, setup, test_add_price, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb add price", Fixture, NULL, setup, test_gnc_pricedb_add_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb add prices", PriceDBFixture, NULL, setup, test_gnc_pricedb_add_prices, teardown);
 // GNC_TEST_ADD (suitename, "remove price", Fixture, NULL, setup, test_remove_price, teardown);
 // GNC_TEST_ADD (suitename, "gnc pricedb remove price", Fixture, NULL, setup, test_gnc_pricedb_remove_price, teardown);
 // GNC_TEST_ADD (suitename, "check one price date", Fixture, NULL, setup, test_check_one_price_date, teardown);
@@ -1779,6 +1932,7 @@ GNC_TEST_ADD (suitename, "gnc price list equal", PriceDBFixture, NULL, setup, te
     GNC_TEST_ADD (suitename, "gnc pricedb get latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb get nearest before price", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_before_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb get nearest price multi hop", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_nearest_price_multi_hop, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);